@@ -0,0 +1,361 @@
+/*!
+ * bench/adversarial.js - worst-case verification cost for javascript
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ *
+ * Usage:
+ *   $ node bench/adversarial.js [ops] [--json]
+ *
+ * Builds signatures which are well-formed (correct size, every field in
+ * range, every group element reduced) but chosen to make verification as
+ * expensive as possible, along with the import edge cases exercised by
+ * scripts/fuzz.js, and reports their cost relative to an honest signature.
+ *
+ * Note that the primality test on `ell` only runs once the recomputed `chal`
+ * matches, which requires a valid proof. An attacker without the key can
+ * therefore at most force the four recoveries, the batch inversion and the
+ * transcript hash. A signer, however, may pick any prime in the `ell` window,
+ * so the spread of `goo_is_prime` cost (and the Lucas `p` reached) over the
+ * primes near a real `ell` is reported separately.
+ */
+
+/* eslint camelcase: "off" */
+
+'use strict';
+
+const assert = require('bsert');
+const {performance} = require('perf_hooks');
+const BN = require('bcrypto/lib/bn.js');
+const rsa = require('bcrypto/lib/rsa');
+const rng = require('bcrypto/lib/random');
+const Goo = require('../');
+const constants = require('../lib/internal/constants');
+const primes = require('../lib/js/primes');
+const Signature = require('../lib/js/signature');
+const util = require('../test/util');
+
+/*
+ * Constants
+ */
+
+const MODULI = ['AOL1', 'AOL2', 'RSA2048', 'RSA617'];
+
+const {
+  CHAL_BITS,
+  ELL_BITS,
+  EXP_BITS,
+  ELLDIFF_MAX
+} = constants;
+
+/*
+ * Helpers
+ */
+
+function mask(bits) {
+  return new BN(1).iushln(bits).isubn(1);
+}
+
+function randomBits(bits) {
+  const num = BN.decode(rng.randomBytes((bits + 7) >>> 3));
+  num.imaskn(bits);
+  num.setn(bits - 1, 1);
+  return num;
+}
+
+function randomElement(n) {
+  // Element of (Z/n)/{1,-1} with no leading zeros.
+  const nh = n.ushrn(1);
+
+  for (;;) {
+    const x = BN.decode(rng.randomBytes(n.byteLength())).imod(n);
+
+    if (x.cmp(nh) > 0)
+      x.isub(n).ineg();
+
+    if (x.bitLength() === nh.bitLength())
+      return x;
+  }
+}
+
+function clone(S) {
+  const opts = {};
+
+  for (const key of Object.keys(S))
+    opts[key] = S[key].clone();
+
+  return new Signature(opts);
+}
+
+function measure(ver, msg, sig, C1, ops) {
+  const times = [];
+  let result = null;
+
+  for (let i = 0; i < ops; i++) {
+    const start = performance.now();
+    const ok = ver.verify(msg, sig, C1);
+    times.push(performance.now() - start);
+
+    assert(result === null || result === ok);
+    result = ok;
+  }
+
+  times.sort((a, b) => a - b);
+
+  return {
+    result,
+    mean: times.reduce((a, b) => a + b, 0) / times.length,
+    max: times[times.length - 1]
+  };
+}
+
+/*
+ * Inputs
+ */
+
+function maximal(n, bits) {
+  // Every exponent at its maximum bit length, `Eq` at
+  // its maximum magnitude and negative (sign byte set).
+  const ell = mask(ELL_BITS);
+  const z = () => randomBits(ELL_BITS).imod(ell);
+
+  return new Signature({
+    C2: randomElement(n),
+    C3: randomElement(n),
+    t: new BN(primes.smallPrimes[primes.smallPrimes.length - 1]),
+    chal: mask(CHAL_BITS),
+    ell,
+    Aq: randomElement(n),
+    Bq: randomElement(n),
+    Cq: randomElement(n),
+    Dq: randomElement(n),
+    Eq: mask(EXP_BITS).ineg(),
+    z_w: z(),
+    z_w2: z(),
+    z_s1: z(),
+    z_a: z(),
+    z_an: z(),
+    z_s1w: z(),
+    z_sa: z(),
+    z_s2: z()
+  }).encode(bits);
+}
+
+function cases(ver, modulus, msg, sig, C1) {
+  const {bits} = ver;
+  const n = BN.decode(modulus);
+  const S = Signature.decode(sig, bits);
+  const out = [];
+
+  const add = (name, data, c1 = C1) => {
+    out.push([name, data, c1]);
+  };
+
+  // Full cost: everything passes the range checks.
+  add('honest', sig);
+  add('maximal fields', maximal(n, bits));
+  add('maximal C1', maximal(n, bits), randomElement(n).encode('be', ver.size));
+
+  {
+    const T = clone(S);
+    T.Aq = randomElement(n);
+    add('forged Aq', T.encode(bits));
+  }
+
+  {
+    const T = clone(S);
+    T.Eq = mask(EXP_BITS).ineg();
+    add('maximal Eq', T.encode(bits));
+  }
+
+  {
+    const T = clone(S);
+    T.chal = T.chal.addn(1).imaskn(CHAL_BITS);
+    add('flipped chal', T.encode(bits));
+  }
+
+  {
+    // Wrong message: identical group work, different transcript.
+    const m = Buffer.from(msg);
+    m[0] ^= 1;
+    out.push(['flipped msg', sig, C1, m]);
+  }
+
+  // Import edge cases (scripts/fuzz.js).
+  add('truncated', sig.slice(0, -1));
+  add('extended', Buffer.concat([sig, Buffer.alloc(1)]));
+  add('empty', Buffer.alloc(0));
+
+  {
+    const data = Buffer.from(sig);
+    data[data.length - 1] = 2;
+    add('bad sign byte', data);
+  }
+
+  {
+    const T = clone(S);
+    T.t = new BN(1);
+    add('bad t', T.encode(bits));
+  }
+
+  {
+    const T = clone(S);
+    T.C2 = n.subn(1);
+    add('non-reduced C2', T.encode(bits));
+  }
+
+  {
+    const T = clone(S);
+    T.z_s2 = T.ell.clone();
+    add('z_s2 = ell', T.encode(bits));
+  }
+
+  {
+    const T = clone(S);
+    T.ell = new BN(0);
+    add('zero ell', T.encode(bits));
+  }
+
+  return out;
+}
+
+/*
+ * Primality
+ */
+
+function lucasParam(num) {
+  // Smallest `p` with jacobi(p^2 - 4, num) == -1.
+  for (let p = 3; p <= 10000; p++) {
+    const d = new BN(p * p - 4);
+
+    if (d.jacobi(num) === -1)
+      return p;
+  }
+
+  return -1;
+}
+
+function primeWindow(ell, key) {
+  // Every prime a signer could have chosen around `ell`.
+  const lo = ell.subn(ELLDIFF_MAX);
+  const hi = ell.addn(ELLDIFF_MAX);
+  const found = [];
+
+  for (let p = lo.isEven() ? lo.addn(1) : lo; p.cmp(hi) <= 0; p.iaddn(2)) {
+    if (!primes.isPrime(p, key))
+      continue;
+
+    const start = performance.now();
+
+    for (let i = 0; i < 8; i++)
+      assert(primes.isPrime(p, key));
+
+    found.push({
+      time: (performance.now() - start) / 8,
+      lucas: lucasParam(p)
+    });
+  }
+
+  found.sort((a, b) => a.time - b.time);
+
+  return found;
+}
+
+/*
+ * Main
+ */
+
+function main(argv) {
+  const ops = (argv[2] >>> 0) || 32;
+  const json = argv.includes('--json');
+  const key = util.genKey(2048);
+  const pub = rsa.publicKeyCreate(key);
+  const report = {};
+
+  for (const name of MODULI) {
+    const goo = new Goo(Goo[name], 2, 3, 2048);
+    const ver = new Goo(Goo[name], 2, 3);
+    const msg = rng.randomBytes(32);
+    const s_prime = goo.generate();
+    const C1 = goo.challenge(s_prime, pub);
+    const sig = goo.sign(msg, s_prime, key);
+    const inputs = cases(ver, Goo[name], msg, sig, C1);
+    const results = [];
+
+    let typical = 0;
+    let worst = null;
+
+    for (const [label, data, c1, m = msg] of inputs) {
+      const res = measure(ver, m, data, c1, ops);
+
+      assert(res.result === (label === 'honest'), label);
+
+      if (label === 'honest')
+        typical = res.mean;
+
+      results.push({ name: label, mean: res.mean, max: res.max });
+    }
+
+    for (const res of results) {
+      res.ratio = res.mean / typical;
+
+      if (!worst || res.mean > worst.mean)
+        worst = res;
+    }
+
+    const S = Signature.decode(sig, ver.bits);
+    const keyHash = rng.randomBytes(32);
+    const window = primeWindow(S.ell, keyHash);
+    const median = window[window.length >>> 1].time;
+
+    report[name] = {
+      bits: ver.bits,
+      typical,
+      worst: worst.name,
+      ratio: worst.ratio,
+      cases: results,
+      primality: {
+        primes: window.length,
+        median,
+        max: window[window.length - 1].time,
+        ratio: window[window.length - 1].time / median,
+        lucas: Math.max(...window.map(x => x.lucas))
+      }
+    };
+
+    if (json)
+      continue;
+
+    console.log('Verification cost for %s (%d bits):', name, ver.bits);
+
+    for (const res of results) {
+      console.log(' %s %s: %s ms (max=%s ms) x%s',
+                  res === worst ? '!' : '◷',
+                  res.name.padEnd(16),
+                  res.mean.toFixed(3),
+                  res.max.toFixed(3),
+                  res.ratio.toFixed(2));
+    }
+
+    const {primality} = report[name];
+
+    console.log(' Worst case: %s, x%s typical.',
+                worst.name, worst.ratio.toFixed(2));
+    console.log(' Primality (js, %d primes in window): median=%s ms,'
+                + ' max=%s ms, x%s, lucas p<=%d.',
+                primality.primes,
+                primality.median.toFixed(3),
+                primality.max.toFixed(3),
+                primality.ratio.toFixed(2),
+                primality.lucas);
+    console.log('');
+  }
+
+  if (json)
+    console.log(JSON.stringify(report, null, 2));
+}
+
+/*
+ * Execute
+ */
+
+main(process.argv);
@@ -0,0 +1,552 @@
+/*!
+ * bench/suite.js - GoUO benchmark suite for javascript
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ *
+ * Usage:
+ *   $ node bench/suite.js [options]
+ *
+ * Options:
+ *   --backends <list>  Comma-separated backends to run (native,js).
+ *   --threads <n>      Maximum verification threads (default: cpus).
+ *   --seconds <n>      Duration of each throughput run (default: 3).
+ *   --ops <n>          Samples per latency measurement (default: 16).
+ *   --contexts <n>     Contexts created for the memory footprint (default: 4).
+ *   --out <file>       Write the JSON report to a file instead of stdout.
+ *
+ * Every backend runs in its own child process (with NODE_BACKEND set) so
+ * results are not skewed by the other backend's heap or worker threads.
+ *
+ * The native backend additionally reports throughput of the native
+ * verification pool (`Goo.verifyPool`), from the main thread alone.
+ */
+
+/* eslint camelcase: "off" */
+
+'use strict';
+
+const assert = require('bsert');
+const cp = require('child_process');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const {performance} = require('perf_hooks');
+const workers = require('worker_threads');
+const rsa = require('bcrypto/lib/rsa');
+const util = require('../test/util');
+
+const {Worker, isMainThread, parentPort, workerData} = workers;
+
+/*
+ * Constants
+ */
+
+const VERSION = 2;
+
+const MODULI = [
+  ['AOL1', 2048],
+  ['AOL2', 4096],
+  ['RSA2048', 2048],
+  ['RSA617', 2048]
+];
+
+const VECTORS = [
+  ['4096-bit RSA GoUO, 2048-bit Signer PK', 'AOL2', 2048],
+  ['4096-bit RSA GoUO, 4096-bit Signer PK', 'AOL2', 4096],
+  ['2048-bit RSA GoUO, 2048-bit Signer PK', 'RSA2048', 2048],
+  ['2048-bit RSA GoUO, 4096-bit Signer PK', 'RSA2048', 4096]
+];
+
+/*
+ * Stats
+ */
+
+function summarize(times) {
+  const sorted = times.slice().sort((a, b) => a - b);
+  const quantile = (q) => {
+    const i = Math.ceil(q * sorted.length) - 1;
+    return sorted[Math.min(sorted.length - 1, Math.max(0, i))];
+  };
+
+  let mean = 0;
+  let sigma = 0;
+
+  for (const time of sorted)
+    mean += time;
+
+  mean /= sorted.length;
+
+  for (const time of sorted)
+    sigma += (time - mean) ** 2;
+
+  sigma = Math.sqrt(sigma / Math.max(1, sorted.length - 1));
+
+  return {
+    count: sorted.length,
+    mean,
+    sigma,
+    min: sorted[0],
+    p50: quantile(0.50),
+    p90: quantile(0.90),
+    p99: quantile(0.99),
+    max: sorted[sorted.length - 1]
+  };
+}
+
+function time(func) {
+  const start = performance.now();
+  func();
+  return performance.now() - start;
+}
+
+function collect() {
+  if (global.gc) {
+    global.gc();
+    global.gc();
+  }
+}
+
+/*
+ * Fixtures
+ */
+
+function fixture(Goo, name, modulus, bits) {
+  const n = Goo[modulus];
+  const goo = new Goo(n, 2, 3, bits);
+  const msg = Buffer.from(name, 'binary');
+  const key = util.genKey(bits);
+  const pub = rsa.publicKeyCreate(key);
+  const s_prime = goo.generate();
+  const C1 = goo.challenge(s_prime, pub);
+  const sig = goo.sign(msg, s_prime, key);
+
+  return { goo, n, msg, key, s_prime, C1, sig };
+}
+
+/*
+ * Benchmarks
+ */
+
+function benchContexts(Goo, opts) {
+  const results = [];
+
+  for (const [name, bits] of MODULI) {
+    const n = Goo[name];
+    const prover = [];
+    const verifier = [];
+
+    for (let i = 0; i < opts.ops; i++) {
+      prover.push(time(() => new Goo(n, 2, 3, 4096)));
+      verifier.push(time(() => new Goo(n, 2, 3)));
+    }
+
+    results.push({
+      modulus: name,
+      bits,
+      prover: summarize(prover),
+      verifier: summarize(verifier)
+    });
+  }
+
+  return results;
+}
+
+function footprint(func, count) {
+  const items = [];
+
+  collect();
+
+  const before = process.memoryUsage();
+
+  for (let i = 0; i < count; i++)
+    items.push(func());
+
+  collect();
+
+  const after = process.memoryUsage();
+
+  assert(items.length === count);
+
+  return {
+    rss: Math.max(0, after.rss - before.rss) / count,
+    heap: Math.max(0, after.heapUsed - before.heapUsed) / count,
+    external: Math.max(0, after.external - before.external) / count
+  };
+}
+
+function benchMemory(Goo, opts) {
+  const results = [];
+
+  for (const [name, bits] of MODULI) {
+    const n = Goo[name];
+
+    results.push({
+      modulus: name,
+      bits,
+      contexts: opts.contexts,
+      prover: footprint(() => new Goo(n, 2, 3, 4096), opts.contexts),
+      verifier: footprint(() => new Goo(n, 2, 3), opts.contexts)
+    });
+  }
+
+  return results;
+}
+
+function benchLatency(Goo, opts) {
+  const results = [];
+
+  for (const [name, modulus, bits] of VECTORS) {
+    const {goo, n, msg, key, s_prime, C1, sig} =
+      fixture(Goo, name, modulus, bits);
+    const pub = rsa.publicKeyCreate(key);
+    const ver = new Goo(n, 2, 3);
+    const challenge = [];
+    const sign = [];
+    const verify = [];
+
+    for (let i = 0; i < opts.ops; i++) {
+      challenge.push(time(() => goo.challenge(s_prime, pub)));
+      sign.push(time(() => goo.sign(msg, s_prime, key)));
+      verify.push(time(() => assert(ver.verify(msg, sig, C1))));
+    }
+
+    results.push({
+      name,
+      modulus,
+      bits,
+      challenge: summarize(challenge),
+      sign: summarize(sign),
+      verify: summarize(verify)
+    });
+  }
+
+  return results;
+}
+
+function runWorkers(threads, data) {
+  const shared = new SharedArrayBuffer(4);
+  const flag = new Int32Array(shared);
+  const workers = [];
+
+  for (let i = 0; i < threads; i++) {
+    workers.push(new Worker(__filename, {
+      workerData: Object.assign({ shared }, data)
+    }));
+  }
+
+  const ready = workers.map((worker) => {
+    return new Promise((resolve, reject) => {
+      worker.once('message', resolve);
+      worker.once('error', reject);
+    });
+  });
+
+  return Promise.all(ready).then(() => {
+    const done = workers.map((worker) => {
+      return new Promise((resolve, reject) => {
+        worker.once('message', resolve);
+        worker.once('error', reject);
+      });
+    });
+
+    Atomics.store(flag, 0, 1);
+    Atomics.notify(flag, 0);
+
+    return Promise.all(done);
+  });
+}
+
+async function benchThroughput(Goo, opts) {
+  const results = [];
+
+  for (const [name, modulus, bits] of VECTORS) {
+    const {msg, sig, C1} = fixture(Goo, name, modulus, bits);
+    const runs = [];
+
+    for (let threads = 1; threads <= opts.threads; threads++) {
+      const counts = await runWorkers(threads, {
+        modulus,
+        msg,
+        sig,
+        C1,
+        seconds: opts.seconds
+      });
+
+      let ops = 0;
+      let elapsed = 0;
+
+      for (const [count, ms] of counts) {
+        ops += count;
+        elapsed = Math.max(elapsed, ms);
+      }
+
+      runs.push({
+        threads,
+        ops,
+        seconds: elapsed / 1000,
+        perSecond: ops / (elapsed / 1000)
+      });
+    }
+
+    for (const run of runs)
+      run.scaling = run.perSecond / runs[0].perSecond;
+
+    results.push({ name, modulus, bits, runs });
+  }
+
+  return results;
+}
+
+async function runPool(Goo, threads, data) {
+  const {modulus, msg, sig, C1, seconds} = data;
+  const goo = new Goo(Goo[modulus], 2, 3);
+  const pool = Goo.verifyPool({ threads });
+  const depth = threads * pool.batch * 2;
+  const start = performance.now();
+  const deadline = start + seconds * 1000;
+
+  let count = 0;
+  let now = start;
+
+  // Keep the queue topped up until the deadline.
+  const loop = async () => {
+    while (now < deadline) {
+      assert(await goo.verifyAsync(msg, sig, C1, pool));
+      count += 1;
+      now = performance.now();
+    }
+  };
+
+  const loops = [];
+
+  for (let i = 0; i < depth; i++)
+    loops.push(loop());
+
+  await Promise.all(loops);
+
+  pool.close();
+
+  return [count, performance.now() - start];
+}
+
+async function benchPool(Goo, opts) {
+  const results = [];
+
+  for (const [name, modulus, bits] of VECTORS) {
+    const {msg, sig, C1} = fixture(Goo, name, modulus, bits);
+    const runs = [];
+
+    for (let threads = 1; threads <= opts.threads; threads++) {
+      const [ops, elapsed] = await runPool(Goo, threads, {
+        modulus,
+        msg,
+        sig,
+        C1,
+        seconds: opts.seconds
+      });
+
+      runs.push({
+        threads,
+        ops,
+        seconds: elapsed / 1000,
+        perSecond: ops / (elapsed / 1000)
+      });
+    }
+
+    for (const run of runs)
+      run.scaling = run.perSecond / runs[0].perSecond;
+
+    results.push({ name, modulus, bits, runs });
+  }
+
+  return results;
+}
+
+async function benchBackend(opts) {
+  const Goo = require('../');
+  const native = Goo.native === 2;
+
+  return {
+    backend: native ? 'native' : 'js',
+    contexts: benchContexts(Goo, opts),
+    memory: benchMemory(Goo, opts),
+    latency: benchLatency(Goo, opts),
+    throughput: await benchThroughput(Goo, opts),
+    pool: native ? await benchPool(Goo, opts) : null
+  };
+}
+
+/*
+ * Worker
+ */
+
+function worker() {
+  const Goo = require('../');
+  const {shared, modulus, seconds} = workerData;
+  const flag = new Int32Array(shared);
+  const msg = Buffer.from(workerData.msg);
+  const sig = Buffer.from(workerData.sig);
+  const C1 = Buffer.from(workerData.C1);
+  const ver = new Goo(Goo[modulus], 2, 3);
+
+  // Warm up.
+  assert(ver.verify(msg, sig, C1));
+
+  parentPort.postMessage(null);
+
+  Atomics.wait(flag, 0, 0);
+
+  const start = performance.now();
+  const deadline = start + seconds * 1000;
+
+  let count = 0;
+  let now = start;
+
+  while (now < deadline) {
+    assert(ver.verify(msg, sig, C1));
+    count += 1;
+    now = performance.now();
+  }
+
+  parentPort.postMessage([count, now - start]);
+}
+
+/*
+ * Main
+ */
+
+function parseArgs(argv) {
+  const opts = {
+    backends: ['native'],
+    threads: os.cpus().length,
+    seconds: 3,
+    ops: 16,
+    contexts: 4,
+    out: null,
+    child: false
+  };
+
+  for (let i = 2; i < argv.length; i++) {
+    const arg = argv[i];
+    const next = () => {
+      assert(i + 1 < argv.length, `Missing value for ${arg}.`);
+      return argv[++i];
+    };
+
+    switch (arg) {
+      case '--backends':
+        opts.backends = next().split(',');
+        break;
+      case '--threads':
+        opts.threads = next() >>> 0;
+        break;
+      case '--seconds':
+        opts.seconds = Number(next());
+        break;
+      case '--ops':
+        opts.ops = next() >>> 0;
+        break;
+      case '--contexts':
+        opts.contexts = next() >>> 0;
+        break;
+      case '--out':
+        opts.out = next();
+        break;
+      case '--child':
+        opts.child = true;
+        break;
+      default:
+        throw new Error(`Unknown option: ${arg}.`);
+    }
+  }
+
+  for (const backend of opts.backends)
+    assert(backend === 'native' || backend === 'js', 'Invalid backend.');
+
+  assert(opts.threads > 0);
+  assert(opts.seconds > 0);
+  assert(opts.ops > 0);
+  assert(opts.contexts > 0);
+
+  return opts;
+}
+
+function commit() {
+  try {
+    return cp.execFileSync('git', ['rev-parse', 'HEAD'], {
+      cwd: path.resolve(__dirname, '..'),
+      encoding: 'utf8',
+      stdio: ['ignore', 'pipe', 'ignore']
+    }).trim();
+  } catch (e) {
+    return null;
+  }
+}
+
+function spawnBackend(backend, argv) {
+  const args = ['--expose-gc', __filename, '--child', ...argv.slice(2)];
+  const env = Object.assign({}, process.env, { NODE_BACKEND: backend });
+  const child = cp.spawnSync(process.execPath, args, {
+    env,
+    encoding: 'utf8',
+    maxBuffer: 64 << 20,
+    stdio: ['ignore', 'pipe', 'inherit']
+  });
+
+  if (child.status !== 0)
+    throw new Error(`Backend ${backend} exited with ${child.status}.`);
+
+  return JSON.parse(child.stdout);
+}
+
+async function main(argv) {
+  const opts = parseArgs(argv);
+
+  if (opts.child) {
+    const result = await benchBackend(opts);
+    process.stdout.write(JSON.stringify(result) + '\n');
+    return;
+  }
+
+  const report = {
+    version: VERSION,
+    date: new Date().toISOString(),
+    commit: commit(),
+    node: process.version,
+    platform: process.platform,
+    arch: process.arch,
+    cpus: os.cpus().map(cpu => cpu.model),
+    options: {
+      threads: opts.threads,
+      seconds: opts.seconds,
+      ops: opts.ops,
+      contexts: opts.contexts
+    },
+    backends: {}
+  };
+
+  for (const backend of opts.backends) {
+    console.error('Running %s backend...', backend);
+    report.backends[backend] = spawnBackend(backend, argv);
+  }
+
+  const json = JSON.stringify(report, null, 2) + '\n';
+
+  if (opts.out)
+    fs.writeFileSync(opts.out, json);
+  else
+    process.stdout.write(json);
+}
+
+/*
+ * Execute
+ */
+
+if (isMainThread) {
+  main(process.argv).catch((err) => {
+    console.error(err.stack);
+    process.exit(1);
+  });
+} else {
+  worker();
+}
@@ -5,6 +5,7 @@
       "./src/goo/drbg.c",
       "./src/goo/goo.c",
       "./src/goo/hmac.c",
+      "./src/goo/mont.c",
       "./src/goo/sha256.c",
       "./src/goosig.cc"
     ],
@@ -23,9 +24,11 @@
     "variables": {
       "conditions": [
         ["OS=='win'", {
-          "with_gmp%": "false"
+          "with_gmp%": "false",
+          "with_sdt%": "false"
         }, {
-          "with_gmp%": "<!(./utils/has_gmp.sh)"
+          "with_gmp%": "<!(./utils/has_gmp.sh)",
+          "with_sdt%": "<!(./utils/has_sdt.sh)"
         }]
       ]
     },
@@ -35,6 +38,11 @@
           "WORDS_BIGENDIAN"
         ]
       }],
+      ["with_sdt=='true'", {
+        "defines": [
+          "GOO_HAS_SDT"
+        ]
+      }],
       ["with_gmp=='true'", {
         "defines": [
           "GOO_HAS_GMP"
@@ -49,6 +57,21 @@
         "cflags_c": [
           "-Wno-unused-parameter",
           "-Wno-sign-compare"
+        ],
+        "conditions": [
+          ["OS!='win'", {
+            "sources": [
+              "./src/goo/dlgmp.c"
+            ],
+            "defines": [
+              "GOO_HAS_DLGMP"
+            ]
+          }],
+          ["OS=='linux'", {
+            "libraries": [
+              "-ldl"
+            ]
+          }]
         ]
       }]
     ]
@@ -13,6 +13,7 @@
 'use strict';
 
 const assert = require('bsert');
+const fs = require('fs');
 const {countLeft} = require('bcrypto/lib/encoding/util');
 const Goo = require('./goo');
 const constants = require('./internal/constants');
@@ -68,6 +69,47 @@ class API {
     return this._prover().challenge(s_prime, key);
   }
 
+  deriveSprime(seed, index) {
+    return this.constructor.deriveSprime(seed, index);
+  }
+
+  challengeBatch(keys, options) {
+    return this._prover().challengeBatch(keys, options);
+  }
+
+  async challengeFile(file, keys, options = {}) {
+    assert(typeof file === 'string');
+    assert(Array.isArray(keys));
+    assert(options && typeof options === 'object');
+
+    // Write fixed-width C1 records, a chunk at a time, so
+    // the output never needs to be held in memory at once.
+    const chunk = options.chunk != null ? options.chunk : 4096;
+    const offset = options.offset != null ? options.offset : 0;
+    const {seed, s_primes} = options;
+    const fd = await fs.promises.open(file, 'w');
+
+    assert((chunk >>> 0) === chunk && chunk > 0);
+
+    try {
+      for (let i = 0; i < keys.length; i += chunk) {
+        const items = keys.slice(i, i + chunk);
+        const out = await this.challengeBatch(items, {
+          seed,
+          offset: offset + i,
+          s_primes: s_primes
+            ? s_primes.slice(i * 32, (i + items.length) * 32)
+            : null,
+          threads: options.threads
+        });
+
+        await fd.write(out);
+      }
+    } finally {
+      await fd.close();
+    }
+  }
+
   encrypt(msg, key, size) {
     return this.constructor.encrypt(msg, key, size);
   }
@@ -76,6 +118,14 @@ class API {
     return this.constructor.decrypt(ct, key, size);
   }
 
+  decryptor(key) {
+    return this.constructor.decryptor(key);
+  }
+
+  encryptBatch(msgs, keys, options) {
+    return this.constructor.encryptBatch(msgs, keys, options);
+  }
+
   validate(s_prime, C1, key) {
     return this._prover().validate(s_prime, C1, key);
   }
@@ -84,14 +134,74 @@ class API {
     return this._prover().sign(msg, s_prime, key);
   }
 
+  signer(s_prime, key) {
+    assert(Goo.native === 2, 'Prepared signers require the native backend.');
+    return this._prover().signer(s_prime, key);
+  }
+
+  presign(s_prime, key) {
+    assert(Goo.native === 2, 'Presigning requires the native backend.');
+    return this._prover().presign(s_prime, key);
+  }
+
+  presignAsync(s_prime, key) {
+    assert(Goo.native === 2, 'Presigning requires the native backend.');
+    return this._prover().presignAsync(s_prime, key);
+  }
+
+  signWithPresig(msg, presig) {
+    assert(Goo.native === 2, 'Presigning requires the native backend.');
+    return this._prover().signWithPresig(msg, presig);
+  }
+
+  presigPool(s_prime, key, size) {
+    assert(Goo.native === 2, 'Presigning requires the native backend.');
+    return this._prover().presigPool(s_prime, key, size);
+  }
+
   verify(msg, sig, C1) {
     return this._verifier().verify(msg, sig, C1);
   }
 
+  verifyAsync(msg, sig, C1, pool) {
+    assert(Goo.native === 2, 'Verification pools require the native backend.');
+    return this._verifier().verifyAsync(msg, sig, C1, pool);
+  }
+
+  histogram(op) {
+    assert(Goo.native === 2, 'Histograms require the native backend.');
+
+    if (op == null) {
+      return Object.assign(this._prover().histogram(),
+                           { verify: this._verifier().histogram('verify') });
+    }
+
+    if (op === 'verify')
+      return this._verifier().histogram(op);
+
+    return this._prover().histogram(op);
+  }
+
+  resetHistogram(op) {
+    assert(Goo.native === 2, 'Histograms require the native backend.');
+
+    if (this._p)
+      this._p.resetHistogram(op);
+
+    if (this._v)
+      this._v.resetHistogram(op);
+
+    return this;
+  }
+
   static generate() {
     return Goo.generate();
   }
 
+  static deriveSprime(seed, index) {
+    return Goo.deriveSprime(seed, index);
+  }
+
   static encrypt(msg, key, size) {
     return Goo.encrypt(msg, key, size);
   }
@@ -99,6 +209,35 @@ class API {
   static decrypt(ct, key, size) {
     return Goo.decrypt(ct, key, size);
   }
+
+  static decryptor(key) {
+    return Goo.decryptor(key);
+  }
+
+  static encryptBatch(msgs, keys, options) {
+    return Goo.encryptBatch(msgs, keys, options);
+  }
+
+  static histogram(op) {
+    assert(Goo.native === 2, 'Histograms require the native backend.');
+    return Goo.histogram(op);
+  }
+
+  static resetHistogram(op) {
+    assert(Goo.native === 2, 'Histograms require the native backend.');
+    Goo.resetHistogram(op);
+    return this;
+  }
+
+  static registry() {
+    assert(Goo.native === 2, 'The registry requires the native backend.');
+    return Goo.registry();
+  }
+
+  static verifyPool(options) {
+    assert(Goo.native === 2, 'Verification pools require the native backend.');
+    return Goo.verifyPool(options);
+  }
 }
 
 /*
@@ -106,6 +245,7 @@ class API {
  */
 
 API.native = Goo.native;
+API.backend = Goo.backend;
 API.AOL1 = constants.AOL1;
 API.AOL2 = constants.AOL2;
 API.RSA2048 = constants.RSA2048;
@@ -0,0 +1,320 @@
+/*!
+ * client.js - goosigd client for javascript
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ */
+
+/* eslint camelcase: "off" */
+
+'use strict';
+
+const assert = require('bsert');
+const fs = require('fs');
+const net = require('net');
+const {dirname, join} = require('path');
+const SHA256 = require('bcrypto/lib/sha256');
+const API = require('./api');
+const Goo = require('./goo');
+const constants = require('./internal/constants');
+
+// Peer credentials need the addon.
+const binding = Goo.native === 2 ? require('./native/binding') : null;
+
+/*
+ * Constants
+ */
+
+const {
+  DEFAULT_N,
+  DEFAULT_G,
+  DEFAULT_H
+} = constants;
+
+const MAGIC = 0x474f4f56;
+const MAX_COUNT = 65536;
+const SOCKET = defaultPath();
+
+/*
+ * Client
+ */
+
+class Client {
+  constructor(options = {}) {
+    assert(options && typeof options === 'object');
+
+    const n = options.n != null ? options.n : DEFAULT_N;
+    const g = options.g != null ? options.g : DEFAULT_G;
+    const h = options.h != null ? options.h : DEFAULT_H;
+    const path = options.path != null ? options.path : SOCKET;
+
+    assert(Buffer.isBuffer(n));
+    assert((g >>> 0) === g);
+    assert((h >>> 0) === h);
+    assert(path === null || typeof path === 'string');
+
+    this.path = path;
+    this.id = groupId(n, g, h);
+    this.local = new API(n, g, h);
+    this.socket = null;
+    this.connected = false;
+    this.fallback = false;
+    this.pending = [];
+    this.buffer = Buffer.alloc(0);
+    this.opening = null;
+  }
+
+  open() {
+    if (this.connected || this.fallback)
+      return Promise.resolve(this);
+
+    if (!this.opening) {
+      this.opening = this._connect().then(() => {
+        this.opening = null;
+        return this;
+      });
+    }
+
+    return this.opening;
+  }
+
+  _connect() {
+    return new Promise((resolve) => {
+      // No (trustworthy) daemon: verify in-process.
+      if (this.path === null || !trustSocket(this.path)) {
+        this.fallback = true;
+        resolve();
+        return;
+      }
+
+      const socket = net.connect(this.path);
+
+      const onError = () => {
+        socket.destroy();
+        this.fallback = true;
+        resolve();
+      };
+
+      socket.once('error', onError);
+
+      socket.once('connect', () => {
+        socket.removeListener('error', onError);
+
+        if (!trustPeer(socket)) {
+          onError();
+          return;
+        }
+
+        socket.on('error', () => socket.destroy());
+        socket.on('close', () => this._degrade());
+        socket.on('data', data => this._read(data));
+        this.socket = socket;
+        this.connected = true;
+        resolve();
+      });
+    });
+  }
+
+  async verify(msg, sig, C1) {
+    const [result] = await this.verifyBatch([[msg, sig, C1]]);
+    return result;
+  }
+
+  async verifyBatch(items) {
+    assert(Array.isArray(items));
+    assert(items.length <= MAX_COUNT);
+
+    for (const [msg, sig, C1] of items) {
+      assert(Buffer.isBuffer(msg));
+      assert(Buffer.isBuffer(sig));
+      assert(Buffer.isBuffer(C1));
+    }
+
+    await this.open();
+
+    if (!this.connected)
+      return this._verifyLocal(items);
+
+    return new Promise((resolve) => {
+      this.pending.push([items, resolve]);
+      this.socket.write(encode(this.id, items));
+    });
+  }
+
+  _verifyLocal(items) {
+    return items.map(([msg, sig, C1]) => this.local.verify(msg, sig, C1));
+  }
+
+  _read(data) {
+    this.buffer = Buffer.concat([this.buffer, data]);
+
+    while (this.buffer.length >= 12) {
+      const count = this.buffer.readUInt32BE(8);
+
+      if (this.buffer.readUInt32BE(0) !== MAGIC) {
+        this.socket.destroy();
+        return;
+      }
+
+      if (this.buffer.length < 12 + count)
+        break;
+
+      if (this.pending.length === 0) {
+        this.socket.destroy();
+        return;
+      }
+
+      const status = this.buffer.readUInt32BE(4);
+      const body = this.buffer.slice(12, 12 + count);
+      const [items, resolve] = this.pending.shift();
+
+      this.buffer = this.buffer.slice(12 + count);
+
+      if (status !== 0 || count !== items.length) {
+        // Wrong group (or a confused daemon).
+        resolve(this._verifyLocal(items));
+        this.socket.destroy();
+        this._degrade();
+        return;
+      }
+
+      resolve(Array.from(body, x => x === 1));
+    }
+  }
+
+  _reset() {
+    const pending = this.pending;
+
+    if (this.socket)
+      this.socket.removeAllListeners('close');
+
+    this.connected = false;
+    this.socket = null;
+    this.pending = [];
+    this.buffer = Buffer.alloc(0);
+
+    // Anything in flight is redone locally.
+    for (const [items, resolve] of pending)
+      resolve(this._verifyLocal(items));
+  }
+
+  _degrade() {
+    this._reset();
+    this.fallback = true;
+  }
+
+  close() {
+    const {socket} = this;
+
+    this._reset();
+
+    if (socket)
+      socket.end();
+
+    return this;
+  }
+}
+
+/*
+ * Helpers
+ */
+
+function defaultPath() {
+  // Never a shared directory like /tmp: anyone could bind there.
+  if (process.env.GOOSIGD_SOCKET)
+    return process.env.GOOSIGD_SOCKET;
+
+  if (process.env.XDG_RUNTIME_DIR)
+    return join(process.env.XDG_RUNTIME_DIR, 'goosigd.sock');
+
+  return null;
+}
+
+function trustSocket(path) {
+  // The daemon's answers are taken on trust, so its socket must
+  // belong to us, be closed to everyone else, and sit in a directory
+  // where no one else can replace it.
+  if (typeof process.getuid !== 'function')
+    return false;
+
+  const uid = process.getuid();
+
+  let sock, dir;
+
+  try {
+    sock = fs.lstatSync(path);
+    dir = fs.statSync(dirname(path));
+  } catch (e) {
+    return false;
+  }
+
+  if (!sock.isSocket() || sock.uid !== uid || (sock.mode & 0o077) !== 0)
+    return false;
+
+  if (dir.uid !== uid && dir.uid !== 0)
+    return false;
+
+  // Writable by others only if sticky (as /tmp is).
+  if ((dir.mode & 0o022) !== 0 && (dir.mode & 0o1000) === 0)
+    return false;
+
+  return true;
+}
+
+function trustPeer(socket) {
+  const {_handle} = socket;
+
+  if (!binding || !_handle || typeof _handle.fd !== 'number')
+    return true;
+
+  const uid = binding.goosig_peer_uid(_handle.fd);
+
+  // -1: the platform cannot tell; the socket checks stand.
+  return uid === -1 || uid === process.getuid();
+}
+
+function groupId(n, g, h) {
+  let i = 0;
+
+  while (i < n.length && n[i] === 0x00)
+    i += 1;
+
+  const head = Buffer.alloc(8);
+
+  head.writeUInt32BE(g, 0);
+  head.writeUInt32BE(h, 4);
+
+  return SHA256.multi(head, n.slice(i));
+}
+
+function encode(id, items) {
+  let size = 36;
+
+  for (const [msg, sig, C1] of items)
+    size += 12 + msg.length + sig.length + C1.length;
+
+  const out = Buffer.alloc(8 + size);
+
+  let pos = 0;
+
+  pos = out.writeUInt32BE(MAGIC, pos);
+  pos = out.writeUInt32BE(size, pos);
+  pos += id.copy(out, pos);
+  pos = out.writeUInt32BE(items.length, pos);
+
+  for (const item of items) {
+    for (const data of item) {
+      pos = out.writeUInt32BE(data.length, pos);
+      pos += data.copy(out, pos);
+    }
+  }
+
+  assert(pos === out.length);
+
+  return out;
+}
+
+/*
+ * Expose
+ */
+
+module.exports = Client;
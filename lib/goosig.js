@@ -10,4 +10,9 @@
 
 'use strict';
 
-module.exports = require('./api');
+const API = require('./api');
+const Client = require('./client');
+
+API.Client = Client;
+
+module.exports = API;
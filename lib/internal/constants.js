@@ -118,6 +118,7 @@ exports.ELLDIFF_MAX = 512;
 
 exports.MIN_RSA_BYTES = (exports.MIN_RSA_BITS + 7) >>> 3;
 exports.MAX_RSA_BYTES = (exports.MAX_RSA_BITS + 7) >>> 3;
+exports.CIPHERTEXT_SIZE = (exports.MAX_RSA_BITS + 8 + 7) >>> 3;
 exports.EXP_BYTES = (exports.EXP_BITS + 7) >>> 3;
 exports.CHAL_BYTES = (exports.CHAL_BITS + 7) >>> 3;
 exports.ELL_BYTES = (exports.ELL_BITS + 7) >>> 3;
@@ -151,3 +152,8 @@ exports.PRNG_PRIMALITY = Buffer.from(''
 exports.PRNG_SIGN = Buffer.from(''
   + '22e64a953d87742d7ce6dd663d4ceaf3'
   + '55cea1746ab812206668a1b2f1e32db3', 'hex');
+
+// SHA256("Goo Batch")
+exports.PRNG_BATCH = Buffer.from(''
+  + 'b53461542767b7e7430d2f681bb55bbd'
+  + 'dd0b148ba3e9136b30283edbdcc09186', 'hex');
@@ -21,6 +21,7 @@
 'use strict';
 
 const assert = require('bsert');
+const fs = require('fs');
 const BN = require('bcrypto/lib/bn.js');
 const rng = require('bcrypto/lib/random');
 const SHA256 = require('bcrypto/lib/sha256');
@@ -456,6 +457,60 @@ class Goo {
     return C1.encode('be', this.size);
   }
 
+  deriveSprime(seed, index) {
+    return this.constructor.deriveSprime(seed, index);
+  }
+
+  challengeBatch(keys, options = {}) {
+    assert(Array.isArray(keys));
+    assert(options && typeof options === 'object');
+
+    const {seed, s_primes} = options;
+    const offset = options.offset != null ? options.offset : 0;
+    const out = options.out || Buffer.alloc(keys.length * this.size);
+
+    assert(seed == null || Buffer.isBuffer(seed));
+    assert(s_primes == null || Buffer.isBuffer(s_primes));
+    assert(seed != null || s_primes != null);
+    assert((offset >>> 0) === offset);
+    assert(Buffer.isBuffer(out));
+
+    if (out.length !== keys.length * this.size)
+      throw new Error('Invalid output size.');
+
+    if (s_primes && s_primes.length !== keys.length * 32)
+      throw new Error('Invalid s_primes size.');
+
+    let ok = true;
+
+    // No threads here: the native backend
+    // spreads the batch across every core.
+    for (let i = 0; i < keys.length; i++) {
+      let s_prime;
+
+      if (seed) {
+        s_prime = this.deriveSprime(seed, offset + i);
+
+        if (s_primes)
+          s_prime.copy(s_primes, i * 32);
+      } else {
+        s_prime = s_primes.slice(i * 32, i * 32 + 32);
+      }
+
+      try {
+        this.challenge(s_prime, keys[i]).copy(out, i * this.size);
+      } catch (e) {
+        out.fill(0x00, i * this.size, i * this.size + this.size);
+        ok = false;
+      }
+    }
+
+    if (!ok)
+      return Promise.reject(new Error('Could not create challenge.'));
+
+    return Promise.resolve(out);
+  }
+
   _challenge(s_prime, n) {
     const bits = n.bitLength();
 
@@ -480,6 +535,14 @@ class Goo {
     return this.constructor.decrypt(ct, key, size);
   }
 
+  decryptor(key) {
+    return this.constructor.decryptor(key);
+  }
+
+  encryptBatch(msgs, keys, options) {
+    return this.constructor.encryptBatch(msgs, keys, options);
+  }
+
   validate(s_prime, C1, key) {
     assert(Buffer.isBuffer(s_prime));
     assert(Buffer.isBuffer(C1));
@@ -857,6 +920,22 @@ class Goo {
     return SHA256.multi(constants.PRNG_GENERATE, rng.randomBytes(32));
   }
 
+  static deriveSprime(seed, index) {
+    // Derive the `index`th s_prime from a master seed:
+    //   s_prime = H(PRNG_BATCH, seed, index (64 bit BE))
+    assert(Buffer.isBuffer(seed));
+    assert((index >>> 0) === index);
+
+    if (seed.length !== 32)
+      throw new Error('Invalid seed size.');
+
+    const ctr = Buffer.alloc(8);
+
+    ctr.writeUInt32BE(index, 4);
+
+    return SHA256.multi(constants.PRNG_BATCH, seed, ctr);
+  }
+
   static encrypt(msg, key, size) {
     return internal.encrypt(msg, key, size);
   }
@@ -864,6 +943,65 @@ class Goo {
   static decrypt(ct, key, size) {
     return internal.decrypt(ct, key, size);
   }
+
+  static decryptor(key) {
+    assert(Buffer.isBuffer(key));
+
+    // Nothing to prepare here: bcrypto
+    // already decrypts by way of the CRT.
+    return {
+      decrypt: (ct, size) => internal.decrypt(ct, key, size),
+      scan: async (file, options = {}) => {
+        const size = options.size != null ? options.size : 32;
+        const data = await fs.promises.readFile(file);
+        const matches = [];
+
+        if (data.length % constants.CIPHERTEXT_SIZE !== 0)
+          throw new Error('Could not read ciphertext file.');
+
+        for (let i = 0; i < data.length; i += constants.CIPHERTEXT_SIZE) {
+          const ct = data.slice(i, i + constants.CIPHERTEXT_SIZE);
+
+          let msg;
+          try {
+            msg = internal.decrypt(ct, key, size);
+          } catch (e) {
+            continue;
+          }
+
+          matches.push({ index: i / constants.CIPHERTEXT_SIZE, msg });
+        }
+
+        return matches;
+      }
+    };
+  }
+
+  static async encryptBatch(msgs, keys, options = {}) {
+    assert(Array.isArray(msgs));
+    assert(Array.isArray(keys));
+    assert(msgs.length === keys.length);
+    assert(options && typeof options === 'object');
+
+    const size = options.size != null ? options.size : 32;
+    const out = options.out
+      || Buffer.alloc(msgs.length * constants.CIPHERTEXT_SIZE);
+
+    assert(Buffer.isBuffer(out));
+
+    if (out.length !== msgs.length * constants.CIPHERTEXT_SIZE)
+      throw new Error('Invalid output size.');
+
+    for (let i = 0; i < msgs.length; i++) {
+      const ct = internal.encrypt(msgs[i], keys[i], size);
+
+      assert(ct.length === constants.CIPHERTEXT_SIZE);
+
+      ct.copy(out, i * constants.CIPHERTEXT_SIZE);
+    }
+
+    return out;
+  }
 }
 
 /*
@@ -871,6 +1009,7 @@ class Goo {
  */
 
 Goo.native = 0;
+Goo.backend = 'js';
 Goo.AOL1 = constants.AOL1;
 Goo.AOL2 = constants.AOL2;
 Goo.RSA2048 = constants.RSA2048;
@@ -11,8 +11,8 @@ const randomBytes = crypto.randomBytes.bind(crypto);
 
 const binding = require('loady')('goosig', __dirname);
 
-binding.entropy = function entropy() {
-  return randomBytes(32);
+binding.entropy = function entropy(size = 32) {
+  return randomBytes(size);
 };
 
 Object.freeze(binding);
@@ -13,11 +13,24 @@
 'use strict';
 
 const assert = require('bsert');
+const os = require('os');
 const {countLeft} = require('bcrypto/lib/encoding/util');
 const binding = require('./binding');
 const constants = require('../internal/constants');
 const rsa = require('bcrypto/lib/rsa');
-const internal = require('../internal/rsa');
+const {Presig, PresigPool} = require('./presig');
+const {VerifyPool} = require('./pool');
+
+/*
+ * Constants
+ */
+
+const ops = {
+  challenge: 0,
+  validate: 1,
+  sign: 2,
+  verify: 3
+};
 
 /*
  * Goo
@@ -51,12 +64,61 @@ class Goo {
     return binding.goosig_challenge(this._handle, s_prime, n);
   }
 
+  deriveSprime(seed, index) {
+    return this.constructor.deriveSprime(seed, index);
+  }
+
+  challengeBatch(keys, options = {}) {
+    assert(this instanceof Goo);
+    assert(Array.isArray(keys));
+    assert(options && typeof options === 'object');
+
+    const {seed, s_primes} = options;
+    const offset = options.offset != null ? options.offset : 0;
+    const threads = options.threads != null
+      ? options.threads
+      : os.cpus().length;
+    const out = options.out || Buffer.alloc(keys.length * this.size);
+
+    assert(seed == null || Buffer.isBuffer(seed));
+    assert(s_primes == null || Buffer.isBuffer(s_primes));
+    assert(seed != null || s_primes != null);
+    assert((offset >>> 0) === offset);
+    assert((threads >>> 0) === threads && threads > 0);
+    assert(Buffer.isBuffer(out));
+
+    const ns = keys.map(key => rsa.publicKeyExport(key).n);
+
+    return new Promise((resolve, reject) => {
+      const cb = (err) => {
+        if (err) {
+          reject(err);
+          return;
+        }
+
+        resolve(out);
+      };
+
+      binding.goosig_challenge_batch(this._handle, out, s_primes || null,
+                                     seed || null, offset, ns,
+                                     threads, cb);
+    });
+  }
+
   encrypt(msg, key, size) {
-    return internal.encrypt(msg, key, size);
+    return this.constructor.encrypt(msg, key, size);
   }
 
   decrypt(ct, key, size) {
-    return internal.decrypt(ct, key, size);
+    return this.constructor.decrypt(ct, key, size);
+  }
+
+  decryptor(key) {
+    return this.constructor.decryptor(key);
+  }
+
+  encryptBatch(msgs, keys, options) {
+    return this.constructor.encryptBatch(msgs, keys, options);
   }
 
   validate(s_prime, C1, key) {
@@ -86,6 +148,67 @@ class Goo {
     return binding.goosig_sign(this._handle, msg, s_prime, p, q);
   }
 
+  signer(s_prime, key) {
+    assert(this instanceof Goo);
+    assert(Buffer.isBuffer(s_prime));
+    assert(Buffer.isBuffer(key));
+
+    const {p, q} = rsa.privateKeyExport(key);
+    const handle = binding.goosig_signer_create(this._handle, s_prime, p, q);
+
+    return new Signer(this, handle);
+  }
+
+  presign(s_prime, key) {
+    assert(this instanceof Goo);
+    assert(Buffer.isBuffer(s_prime));
+    assert(Buffer.isBuffer(key));
+
+    const {p, q} = rsa.privateKeyExport(key);
+    const entropy = binding.entropy();
+
+    return new Presig(binding.goosig_presign(this._handle, s_prime,
+                                             p, q, entropy));
+  }
+
+  presignAsync(s_prime, key) {
+    assert(this instanceof Goo);
+    assert(Buffer.isBuffer(s_prime));
+    assert(Buffer.isBuffer(key));
+
+    const {p, q} = rsa.privateKeyExport(key);
+    const entropy = binding.entropy();
+
+    return new Promise((resolve, reject) => {
+      const cb = (err, handle) => {
+        if (err) {
+          reject(err);
+          return;
+        }
+
+        resolve(new Presig(handle));
+      };
+
+      binding.goosig_presign_async(this._handle, s_prime,
+                                   p, q, entropy, cb);
+    });
+  }
+
+  signWithPresig(msg, presig) {
+    assert(this instanceof Goo);
+    assert(Buffer.isBuffer(msg));
+    assert(presig instanceof Presig);
+
+    return binding.goosig_sign_with_presig(this._handle,
+                                           presig.consume(),
+                                           msg);
+  }
+
+  presigPool(s_prime, key, size) {
+    assert(this instanceof Goo);
+    return new PresigPool(this, s_prime, key, size);
+  }
+
   verify(msg, sig, C1) {
     assert(this instanceof Goo);
     assert(Buffer.isBuffer(msg));
@@ -95,17 +218,232 @@ class Goo {
     return binding.goosig_verify(this._handle, msg, sig, C1);
   }
 
+  verifyAsync(msg, sig, C1, pool) {
+    assert(this instanceof Goo);
+    assert(pool instanceof VerifyPool);
+    return pool.verify(this, msg, sig, C1);
+  }
+
+  histogram(op) {
+    assert(this instanceof Goo);
+    return histogram(this._handle, op);
+  }
+
+  resetHistogram(op) {
+    assert(this instanceof Goo);
+    resetHistogram(this._handle, op);
+    return this;
+  }
+
   static generate() {
     return binding.goosig_generate(binding.entropy());
   }
 
-  static encrypt(msg, key, size) {
-    return internal.encrypt(msg, key, size);
+  static deriveSprime(seed, index) {
+    assert(Buffer.isBuffer(seed));
+    assert((index >>> 0) === index);
+    return binding.goosig_derive_sprime(seed, index);
   }
 
-  static decrypt(ct, key, size) {
-    return internal.decrypt(ct, key, size);
+  static encrypt(msg, key, size = 32) {
+    assert(Buffer.isBuffer(msg));
+    assert((size >>> 0) === size);
+    assert(msg.length === size);
+
+    const {n, e} = rsa.publicKeyExport(key);
+
+    return binding.goosig_encrypt(msg, n, e, binding.entropy());
+  }
+
+  static decrypt(ct, key, size = 32) {
+    assert(Buffer.isBuffer(ct));
+    assert((size >>> 0) === size);
+
+    const {p, q, e} = rsa.privateKeyExport(key);
+    const msg = binding.goosig_decrypt(ct, p, q, e, binding.entropy());
+
+    if (msg.length !== size)
+      throw new Error('Invalid ciphertext.');
+
+    return msg;
   }
+
+  static decryptor(key) {
+    assert(Buffer.isBuffer(key));
+
+    const {p, q, e} = rsa.privateKeyExport(key);
+
+    return new Decryptor(binding.goosig_rsakey_create(p, q, e));
+  }
+
+  static encryptBatch(msgs, keys, options = {}) {
+    assert(Array.isArray(msgs));
+    assert(Array.isArray(keys));
+    assert(msgs.length === keys.length);
+    assert(options && typeof options === 'object');
+
+    const size = options.size != null ? options.size : 32;
+    const threads = options.threads != null
+      ? options.threads
+      : os.cpus().length;
+    const out = options.out
+      || Buffer.alloc(msgs.length * constants.CIPHERTEXT_SIZE);
+
+    assert((size >>> 0) === size);
+    assert((threads >>> 0) === threads && threads > 0);
+    assert(Buffer.isBuffer(out));
+
+    for (const msg of msgs) {
+      assert(Buffer.isBuffer(msg));
+      assert(msg.length === size);
+    }
+
+    const ns = [];
+    const es = [];
+
+    for (const key of keys) {
+      const {n, e} = rsa.publicKeyExport(key);
+      ns.push(n);
+      es.push(e);
+    }
+
+    const data = Buffer.concat(msgs, msgs.length * size);
+    const entropy = binding.entropy(msgs.length * 32);
+
+    return new Promise((resolve, reject) => {
+      const cb = (err) => {
+        if (err) {
+          reject(err);
+          return;
+        }
+
+        resolve(out);
+      };
+
+      binding.goosig_encrypt_batch(out, data, size, ns, es,
+                                   entropy, threads, cb);
+    });
+  }
+
+  static histogram(op) {
+    return histogram(null, op);
+  }
+
+  static resetHistogram(op) {
+    resetHistogram(null, op);
+    return this;
+  }
+
+  static registry() {
+    return binding.goosig_registry();
+  }
+
+  static verifyPool(options) {
+    return new VerifyPool(options);
+  }
+}
+
+/*
+ * Signer
+ */
+
+class Signer {
+  constructor(goo, handle) {
+    assert(goo instanceof Goo);
+    assert(handle != null);
+
+    this.goo = goo;
+    this._handle = handle;
+  }
+
+  sign(msg) {
+    assert(Buffer.isBuffer(msg));
+    return binding.goosig_signer_sign(this.goo._handle, this._handle, msg);
+  }
+}
+
+/*
+ * Decryptor
+ */
+
+class Decryptor {
+  constructor(handle) {
+    assert(handle != null);
+    this._handle = handle;
+  }
+
+  decrypt(ct, size = 32) {
+    assert(Buffer.isBuffer(ct));
+    assert((size >>> 0) === size);
+
+    const msg = binding.goosig_rsakey_decrypt(this._handle, ct,
+                                              binding.entropy());
+
+    if (msg.length !== size)
+      throw new Error('Invalid ciphertext.');
+
+    return msg;
+  }
+
+  scan(file, options = {}) {
+    assert(typeof file === 'string');
+    assert(options && typeof options === 'object');
+
+    const size = options.size != null ? options.size : 32;
+    const threads = options.threads != null
+      ? options.threads
+      : os.cpus().length;
+
+    assert((size >>> 0) === size);
+    assert((threads >>> 0) === threads && threads > 0);
+
+    return new Promise((resolve, reject) => {
+      const cb = (err, matches) => {
+        if (err) {
+          reject(err);
+          return;
+        }
+
+        resolve(matches);
+      };
+
+      binding.goosig_rsakey_scan(this._handle, file, size,
+                                 binding.entropy(), threads, cb);
+    });
+  }
+}
+
+/*
+ * Helpers
+ */
+
+function histogram(handle, op) {
+  if (op == null) {
+    const out = Object.create(null);
+
+    for (const name of Object.keys(ops))
+      out[name] = binding.goosig_histogram(handle, ops[name]);
+
+    return out;
+  }
+
+  assert(typeof op === 'string');
+  assert(ops[op] != null, 'Invalid operation.');
+
+  return binding.goosig_histogram(handle, ops[op]);
+}
+
+function resetHistogram(handle, op) {
+  if (op == null) {
+    for (const name of Object.keys(ops))
+      binding.goosig_histogram_reset(handle, ops[name]);
+    return;
+  }
+
+  assert(typeof op === 'string');
+  assert(ops[op] != null, 'Invalid operation.');
+
+  binding.goosig_histogram_reset(handle, ops[op]);
 }
 
 /*
@@ -113,6 +451,12 @@ class Goo {
  */
 
 Goo.native = 2;
+Goo.backend = binding.goosig_backend();
+Goo.Signer = Signer;
+Goo.Decryptor = Decryptor;
+Goo.Presig = Presig;
+Goo.PresigPool = PresigPool;
+Goo.VerifyPool = VerifyPool;
 Goo.AOL1 = constants.AOL1;
 Goo.AOL2 = constants.AOL2;
 Goo.RSA2048 = constants.RSA2048;
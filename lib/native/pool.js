@@ -0,0 +1,152 @@
+/*!
+ * pool.js - goosig verification pool for javascript
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ */
+
+/* eslint camelcase: "off" */
+
+'use strict';
+
+const assert = require('bsert');
+const os = require('os');
+const binding = require('./binding');
+
+/*
+ * VerifyPool
+ */
+
+class VerifyPool {
+  constructor(options = {}) {
+    assert(options && typeof options === 'object');
+
+    const threads = options.threads != null
+      ? options.threads
+      : os.cpus().length;
+
+    const cpus = options.cpus != null ? options.cpus : null;
+    const capacity = options.capacity != null ? options.capacity : 1024;
+    const batch = options.batch != null ? options.batch : 8;
+
+    assert((threads >>> 0) === threads && threads > 0);
+    assert(cpus === null || Array.isArray(cpus));
+    assert((capacity >>> 0) === capacity && capacity > 0);
+    assert(capacity <= (1 << 24));
+    assert((batch >>> 0) === batch && batch > 0);
+
+    if (cpus) {
+      for (const cpu of cpus)
+        assert((cpu >>> 0) === cpu);
+    }
+
+    this.threads = threads;
+    this.capacity = pow2(Math.max(2, capacity));
+    this.batch = batch;
+    this.jobs = new Map();
+    this.backlog = [];
+    this.id = 0;
+    this.closed = false;
+
+    this._handle = binding.goosig_pool_create(threads, cpus, this.capacity,
+                                              batch, this._complete.bind(this));
+  }
+
+  get pending() {
+    return this.jobs.size;
+  }
+
+  verify(goo, msg, sig, C1) {
+    assert(goo && goo._handle != null);
+    assert(Buffer.isBuffer(msg));
+    assert(Buffer.isBuffer(sig));
+    assert(Buffer.isBuffer(C1));
+
+    if (this.closed)
+      return Promise.reject(new Error('Pool is closed.'));
+
+    return new Promise((resolve, reject) => {
+      const id = this._next();
+
+      this.jobs.set(id, [resolve, reject]);
+
+      if (this.backlog.length > 0
+          || !this._submit(id, goo, msg, sig, C1)) {
+        this.backlog.push([id, goo, msg, sig, C1]);
+      }
+    });
+  }
+
+  _next() {
+    do {
+      this.id = (this.id + 1) >>> 0;
+    } while (this.jobs.has(this.id));
+
+    return this.id;
+  }
+
+  _submit(id, goo, msg, sig, C1) {
+    return binding.goosig_pool_verify(this._handle, goo._handle,
+                                      id, msg, sig, C1);
+  }
+
+  _complete(ids, results) {
+    for (let i = 0; i < ids.length; i++) {
+      const job = this.jobs.get(ids[i]);
+
+      if (!job)
+        continue;
+
+      this.jobs.delete(ids[i]);
+
+      job[0](results[i]);
+    }
+
+    // Refill the queue from the overflow.
+    while (this.backlog.length > 0 && !this.closed) {
+      const [id, goo, msg, sig, C1] = this.backlog[0];
+
+      if (!this._submit(id, goo, msg, sig, C1))
+        break;
+
+      this.backlog.shift();
+    }
+  }
+
+  close() {
+    if (this.closed)
+      return this;
+
+    this.closed = true;
+
+    binding.goosig_pool_close(this._handle);
+
+    const jobs = this.jobs;
+
+    this.jobs = new Map();
+    this.backlog.length = 0;
+
+    for (const [, reject] of jobs.values())
+      reject(new Error('Pool is closed.'));
+
+    return this;
+  }
+}
+
+/*
+ * Helpers
+ */
+
+function pow2(x) {
+  let y = 1;
+
+  while (y < x)
+    y *= 2;
+
+  return y;
+}
+
+/*
+ * Expose
+ */
+
+exports.VerifyPool = VerifyPool;
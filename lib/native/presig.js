@@ -0,0 +1,152 @@
+/*!
+ * presig.js - goosig presignatures for javascript
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ */
+
+/* eslint camelcase: "off" */
+
+'use strict';
+
+const assert = require('bsert');
+
+/*
+ * Presig
+ */
+
+class Presig {
+  constructor(handle) {
+    assert(handle != null);
+    this._handle = handle;
+  }
+
+  get used() {
+    return this._handle == null;
+  }
+
+  consume() {
+    assert(this._handle != null, 'Presignature already used.');
+
+    const handle = this._handle;
+
+    this._handle = null;
+
+    return handle;
+  }
+}
+
+/*
+ * PresigPool
+ */
+
+class PresigPool {
+  constructor(goo, s_prime, key, size = 8) {
+    assert(goo && typeof goo.presignAsync === 'function');
+    assert(Buffer.isBuffer(s_prime));
+    assert(Buffer.isBuffer(key));
+    assert((size >>> 0) === size && size > 0);
+
+    this.goo = goo;
+    this.s_prime = Buffer.from(s_prime);
+    this.key = key;
+    this.size = size;
+    this.items = [];
+    this.pending = 0;
+    this.waiters = [];
+    this.closed = false;
+    this.error = null;
+  }
+
+  get available() {
+    return this.items.length;
+  }
+
+  fill() {
+    while (!this.closed && this.items.length + this.pending < this.size) {
+      this.pending += 1;
+      this.goo.presignAsync(this.s_prime, this.key).then((presig) => {
+        this.pending -= 1;
+        if (!this.closed)
+          this.items.push(presig);
+        this._wake();
+      }, (err) => {
+        this.pending -= 1;
+        this.error = err;
+        this._wake();
+      });
+
+      // Stop refilling after a failure (likely a bad key).
+      if (this.error)
+        break;
+    }
+
+    return this;
+  }
+
+  _wake() {
+    if (this.pending > 0)
+      return;
+
+    const waiters = this.waiters;
+
+    this.waiters = [];
+
+    for (const [resolve, reject] of waiters) {
+      if (this.error)
+        reject(this.error);
+      else
+        resolve(this);
+    }
+  }
+
+  open() {
+    assert(!this.closed, 'Pool is closed.');
+
+    this.fill();
+
+    if (this.pending === 0)
+      return Promise.resolve(this);
+
+    return new Promise((resolve, reject) => {
+      this.waiters.push([resolve, reject]);
+    });
+  }
+
+  take() {
+    assert(!this.closed, 'Pool is closed.');
+
+    const presig = this.items.length > 0 ? this.items.shift() : null;
+
+    if (!this.error)
+      this.fill();
+
+    return presig;
+  }
+
+  sign(msg) {
+    assert(Buffer.isBuffer(msg));
+
+    const presig = this.take();
+
+    // Fall back to a full (deterministic) signature
+    // when the background workers have not caught up.
+    if (!presig)
+      return this.goo.sign(msg, this.s_prime, this.key);
+
+    return this.goo.signWithPresig(msg, presig);
+  }
+
+  close() {
+    // Unused presignatures are wiped when collected.
+    this.closed = true;
+    this.items.length = 0;
+    return this;
+  }
+}
+
+/*
+ * Expose
+ */
+
+exports.Presig = Presig;
+exports.PresigPool = PresigPool;
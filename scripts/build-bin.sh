@@ -0,0 +1,44 @@
+#!/bin/bash
+
+# Build the standalone programs in src/bin against
+# the same sources as the addon (and GMP if present).
+
+set -ex
+
+cc="${CC:-cc}"
+out="${1:-./build/bin}"
+gmp=''
+
+if test x"$(./utils/has_gmp.sh)" = x'true'; then
+  gmp='-DGOO_HAS_GMP -lgmp'
+else
+  # Falls back to mini-gmp, but picks up a system libgmp at runtime.
+  gmp='./src/goo/mini-gmp.c ./src/goo/dlgmp.c -DGOO_HAS_DLGMP -ldl'
+fi
+
+mkdir -p "$out"
+
+for src in ./src/bin/*.c; do
+  name="$(basename "$src" .c)"
+
+  "$cc" -o "$out/$name"       \
+    -std=c89                  \
+    -pedantic                 \
+    -Wall                     \
+    -Wextra                   \
+    -Wcast-align              \
+    -Wshadow                  \
+    -Wno-long-long            \
+    -Wno-unused-parameter     \
+    -Wno-sign-compare         \
+    -D_POSIX_C_SOURCE=200809L \
+    -O3                       \
+    ./src/goo/drbg.c          \
+    ./src/goo/goo.c           \
+    ./src/goo/hmac.c          \
+    ./src/goo/mont.c          \
+    ./src/goo/sha256.c        \
+    "$src"                    \
+    $gmp                      \
+    -lpthread
+done
@@ -0,0 +1,78 @@
+/*!
+ * pack-verify.js - build a goo-verify container
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ *
+ * Usage:
+ *   $ node scripts/pack-verify.js <vectors.json> <out> [repeat] [modulus]
+ *
+ * Reads `[msg, sig, C1, ...]` vectors (as in test/data/verify.json) and
+ * writes them, `repeat` times over, as a container for goo-verify. The
+ * modulus (default: RSA2048) is written as hex to `<out>.n`.
+ */
+
+'use strict';
+
+const assert = require('bsert');
+const fs = require('fs');
+const constants = require('../lib/internal/constants');
+
+const MAGIC = 0x474f4f52;
+
+function main(argv) {
+  assert(argv.length >= 4, 'Usage: pack-verify.js <json> <out> [repeat]');
+
+  const vectors = JSON.parse(fs.readFileSync(argv[2], 'utf8'));
+  const file = argv[3];
+  const repeat = argv.length > 4 ? argv[4] >>> 0 : 1;
+  const modulus = constants[argv.length > 5 ? argv[5] : 'RSA2048'];
+
+  assert(Array.isArray(vectors));
+  assert(repeat > 0);
+  assert(Buffer.isBuffer(modulus), 'Unknown modulus.');
+
+  const records = [];
+
+  for (const [msg, sig, C1] of vectors) {
+    const fields = [msg, sig, C1].map(x => Buffer.from(x, 'hex'));
+    const size = fields.reduce((a, x) => a + 4 + x.length, 0);
+    const out = Buffer.alloc(size);
+
+    let pos = 0;
+
+    for (const field of fields) {
+      pos = out.writeUInt32BE(field.length, pos);
+      pos += field.copy(out, pos);
+    }
+
+    records.push(out);
+  }
+
+  const count = records.length * repeat;
+
+  assert(count <= 0xffffffff);
+
+  const head = Buffer.alloc(8);
+
+  head.writeUInt32BE(MAGIC, 0);
+  head.writeUInt32BE(count, 4);
+
+  const fd = fs.openSync(file, 'w');
+
+  try {
+    fs.writeSync(fd, head);
+
+    for (let i = 0; i < repeat; i++) {
+      for (const record of records)
+        fs.writeSync(fd, record);
+    }
+  } finally {
+    fs.closeSync(fd);
+  }
+
+  fs.writeFileSync(`${file}.n`, modulus.toString('hex') + '\n');
+
+  console.log('Wrote %d records to %s.', count, file);
+}
+
+main(process.argv);
@@ -14,14 +14,23 @@ for cc in gcc clang; do
       -Wno-unused-parameter    \
       -Wno-sign-compare        \
       -O3                      \
+      -DGOO_HAS_DLGMP          \
+      ./src/goo/dlgmp.c        \
       ./src/goo/drbg.c         \
       ./src/goo/hmac.c         \
       ./src/goo/mini-gmp.c     \
+      ./src/goo/mont.c         \
       ./src/goo/sha256.c       \
-      ./src/goo/test.c
+      ./src/goo/test.c         \
+      -ldl
 
     ./goo-test
 
+    # Same binary, with libgmp loaded at runtime.
+    if ldconfig -p 2> /dev/null | grep -q 'libgmp\.so'; then
+      GOO_TEST_DLGMP=1 ./goo-test
+    fi
+
     valgrind                \
       --tool=memcheck       \
       --leak-check=full     \
@@ -49,6 +58,7 @@ for cc in gcc clang; do
     -DGOO_HAS_CRYPTO         \
     ./src/goo/drbg.c         \
     ./src/goo/hmac.c         \
+    ./src/goo/mont.c         \
     ./src/goo/sha256.c       \
     ./src/goo/test.c
 
@@ -0,0 +1,334 @@
+/*!
+ * goo-verify.c - bulk signature verification
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ *
+ * Verifies every record of a container file in parallel, prints the
+ * indices of failing records to stdout and a summary to stderr. Exits
+ * with 0 if every record verified, 1 if any failed, 2 on error.
+ *
+ * Usage:
+ *   $ goo-verify -n <hex|@file> [-g 2] [-h 3] [-t threads] <file>
+ *
+ * Container (all integers are 32 bit big endian):
+ *
+ *   magic ("GOOR"), count,
+ *   count * (msg length, msg, sig length, sig, C1 length, C1)
+ *
+ * See scripts/pack-verify.js to build one from test vectors.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "../goo/goo.h"
+#include "util.h"
+
+#define GOO_VERIFY_MAGIC 0x474f4f52
+#define GOO_VERIFY_CHUNK 64
+
+/*
+ * Types
+ */
+
+typedef struct goo_verify_record_s {
+  const unsigned char *msg;
+  size_t msg_len;
+  const unsigned char *sig;
+  size_t sig_len;
+  const unsigned char *C1;
+  size_t C1_len;
+} goo_verify_record_t;
+
+typedef struct goo_verify_job_s {
+  const goo_ctx_t *ctx;
+  const goo_verify_record_t *records;
+  unsigned char *results;
+  size_t count;
+  size_t next;
+  pthread_mutex_t lock;
+} goo_verify_job_t;
+
+/*
+ * Helpers
+ */
+
+static void
+goo_verify_fatal(const char *msg) {
+  fprintf(stderr, "goo-verify: %s\n", msg);
+  exit(2);
+}
+
+static double
+goo_verify_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int
+goo_verify_index(goo_verify_record_t **out,
+                 size_t *out_len,
+                 const unsigned char *data,
+                 size_t len) {
+  goo_verify_record_t *records;
+  size_t count, i;
+
+  if (len < 8 || goo_bin_read32(data) != GOO_VERIFY_MAGIC)
+    return 0;
+
+  count = goo_bin_read32(data + 4);
+
+  data += 8;
+  len -= 8;
+
+  /* Every record is at least 12 bytes. */
+  if (count > len / 12)
+    return 0;
+
+  records = malloc((count + 1) * sizeof(goo_verify_record_t));
+
+  if (records == NULL)
+    return 0;
+
+  for (i = 0; i < count; i++) {
+    const unsigned char **ptrs[3];
+    size_t *lens[3];
+    int j;
+
+    ptrs[0] = &records[i].msg;
+    ptrs[1] = &records[i].sig;
+    ptrs[2] = &records[i].C1;
+    lens[0] = &records[i].msg_len;
+    lens[1] = &records[i].sig_len;
+    lens[2] = &records[i].C1_len;
+
+    for (j = 0; j < 3; j++) {
+      size_t size;
+
+      if (len < 4)
+        goto fail;
+
+      size = goo_bin_read32(data);
+
+      data += 4;
+      len -= 4;
+
+      if (len < size)
+        goto fail;
+
+      *ptrs[j] = data;
+      *lens[j] = size;
+
+      data += size;
+      len -= size;
+    }
+  }
+
+  if (len != 0)
+    goto fail;
+
+  *out = records;
+  *out_len = count;
+
+  return 1;
+fail:
+  free(records);
+  return 0;
+}
+
+/*
+ * Workers
+ */
+
+static void *
+goo_verify_work(void *arg) {
+  goo_verify_job_t *job = (goo_verify_job_t *)arg;
+  goo_ctx_t *ctx = goo_clone(job->ctx);
+
+  if (ctx == NULL)
+    goo_verify_fatal("could not clone context");
+
+  for (;;) {
+    size_t start, end, i;
+
+    pthread_mutex_lock(&job->lock);
+    start = job->next;
+    end = start + GOO_VERIFY_CHUNK < job->count
+        ? start + GOO_VERIFY_CHUNK
+        : job->count;
+    job->next = end;
+    pthread_mutex_unlock(&job->lock);
+
+    if (start == end)
+      break;
+
+    for (i = start; i < end; i++) {
+      const goo_verify_record_t *rec = &job->records[i];
+
+      job->results[i] = goo_verify(ctx, rec->msg, rec->msg_len,
+                                   rec->sig, rec->sig_len,
+                                   rec->C1, rec->C1_len) != 0;
+    }
+  }
+
+  goo_destroy(ctx);
+
+  return NULL;
+}
+
+/*
+ * Main
+ */
+
+static void
+goo_verify_usage(void) {
+  fprintf(stderr, "Usage: goo-verify -n <hex|@file> [-g 2] [-h 3]"
+                  " [-t threads] <file>\n");
+  exit(2);
+}
+
+int
+main(int argc, char **argv) {
+  const char *modulus = NULL;
+  const char *file = NULL;
+  const char *backend;
+  unsigned long g = 2;
+  unsigned long h = 3;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  goo_verify_record_t *records;
+  pthread_t *workers;
+  goo_verify_job_t job;
+  unsigned char *data;
+  unsigned char *n;
+  size_t n_len, count, failed, i;
+  struct stat st;
+  double start, elapsed;
+  goo_ctx_t *ctx;
+  int fd;
+  long t;
+
+  for (i = 1; i < (size_t)argc; i++) {
+    if (argv[i][0] != '-') {
+      if (file != NULL)
+        goo_verify_usage();
+      file = argv[i];
+      continue;
+    }
+
+    if (i + 1 >= (size_t)argc)
+      goo_verify_usage();
+
+    if (strcmp(argv[i], "-n") == 0)
+      modulus = argv[++i];
+    else if (strcmp(argv[i], "-g") == 0)
+      g = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "-h") == 0)
+      h = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "-t") == 0)
+      threads = strtol(argv[++i], NULL, 10);
+    else
+      goo_verify_usage();
+  }
+
+  if (modulus == NULL || file == NULL || threads <= 0)
+    goo_verify_usage();
+
+  backend = goo_bin_backend();
+
+  if (!goo_bin_modulus(&n, &n_len, modulus))
+    goo_verify_fatal("invalid modulus");
+
+  ctx = goo_create(n, n_len, g, h, 0);
+
+  free(n);
+
+  if (ctx == NULL)
+    goo_verify_fatal("could not create context");
+
+  fd = open(file, O_RDONLY);
+
+  if (fd < 0 || fstat(fd, &st) != 0)
+    goo_verify_fatal("could not open file");
+
+  if (st.st_size == 0)
+    goo_verify_fatal("invalid container");
+
+  data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (data == MAP_FAILED)
+    goo_verify_fatal("could not map file");
+
+  close(fd);
+
+  if (!goo_verify_index(&records, &count, data, st.st_size))
+    goo_verify_fatal("invalid container");
+
+  job.ctx = ctx;
+  job.records = records;
+  job.results = malloc(count + 1);
+  job.count = count;
+  job.next = 0;
+
+  if (job.results == NULL)
+    goo_verify_fatal("out of memory");
+
+  pthread_mutex_init(&job.lock, NULL);
+
+  if ((size_t)threads > count)
+    threads = count > 0 ? count : 1;
+
+  workers = malloc(threads * sizeof(pthread_t));
+
+  if (workers == NULL)
+    goo_verify_fatal("out of memory");
+
+  start = goo_verify_now();
+
+  for (t = 0; t < threads; t++) {
+    if (pthread_create(&workers[t], NULL, goo_verify_work, &job) != 0)
+      goo_verify_fatal("could not start worker");
+  }
+
+  for (t = 0; t < threads; t++)
+    pthread_join(workers[t], NULL);
+
+  elapsed = goo_verify_now() - start;
+
+  failed = 0;
+
+  for (i = 0; i < count; i++) {
+    if (!job.results[i]) {
+      printf("%lu\n", (unsigned long)i);
+      failed += 1;
+    }
+  }
+
+  fprintf(stderr, "goo-verify: %lu records, %lu failed, %.3f s,"
+                  " %.1f verifies/s (%ld threads, %s)\n",
+          (unsigned long)count,
+          (unsigned long)failed,
+          elapsed,
+          elapsed > 0 ? (double)count / elapsed : 0.0,
+          threads,
+          backend);
+
+  pthread_mutex_destroy(&job.lock);
+  munmap(data, st.st_size);
+  free(workers);
+  free(job.results);
+  free(records);
+  goo_destroy(ctx);
+
+  return failed > 0 ? 1 : 0;
+}
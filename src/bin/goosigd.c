@@ -0,0 +1,559 @@
+/*!
+ * goosigd.c - goosig verification daemon
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ *
+ * Serves verification for one group over a unix domain socket, so that
+ * every process on a host shares a single copy of the precomputation.
+ *
+ * Usage:
+ *   $ goosigd -n <hex|@file> [-g 2] [-h 3] [-t threads] [-s path]
+ *
+ * The socket defaults to $XDG_RUNTIME_DIR/goosigd.sock and is created
+ * with mode 0600: only the user running the daemon may connect.
+ *
+ * Protocol (all integers are 32 bit big endian):
+ *
+ *   request:  magic ("GOOV"), body length, body
+ *   body:     group id (32 bytes), count,
+ *             count * (msg length, msg, sig length, sig, C1 length, C1)
+ *   response: magic ("GOOV"), status, count, count * result byte
+ *
+ * The group id is SHA256(g || h || n), with `n` stripped of leading
+ * zeroes. Requests are answered in order. A status other than zero
+ * carries no results.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../goo/goo.h"
+#include "../goo/sha256.h"
+#include "util.h"
+
+#define GOOSIGD_MAGIC 0x474f4f56
+#define GOOSIGD_MAX_BODY (64 << 20)
+#define GOOSIGD_MAX_COUNT 65536
+#define GOOSIGD_CHUNK 16
+#define GOOSIGD_SOCKET "goosigd.sock"
+
+#define GOOSIGD_OK 0
+#define GOOSIGD_ERR_GROUP 1
+#define GOOSIGD_ERR_FRAME 2
+
+/*
+ * Types
+ */
+
+typedef struct goosigd_record_s {
+  const unsigned char *msg;
+  size_t msg_len;
+  const unsigned char *sig;
+  size_t sig_len;
+  const unsigned char *C1;
+  size_t C1_len;
+} goosigd_record_t;
+
+typedef struct goosigd_frame_s {
+  goosigd_record_t *records;
+  unsigned char *results;
+  size_t count;
+  size_t remaining;
+  pthread_mutex_t lock;
+  pthread_cond_t done;
+} goosigd_frame_t;
+
+typedef struct goosigd_task_s {
+  struct goosigd_task_s *next;
+  goosigd_frame_t *frame;
+  size_t start;
+  size_t end;
+} goosigd_task_t;
+
+typedef struct goosigd_s {
+  goo_ctx_t *ctx;
+  unsigned char id[32];
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+  goosigd_task_t *head;
+  goosigd_task_t *tail;
+} goosigd_t;
+
+static goosigd_t goosigd;
+static const char *goosigd_path = NULL;
+
+/*
+ * Helpers
+ */
+
+static void
+goosigd_fatal(const char *msg) {
+  fprintf(stderr, "goosigd: %s\n", msg);
+  exit(EXIT_FAILURE);
+}
+
+static int
+goosigd_recv(int fd, unsigned char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = read(fd, buf, len);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+
+    if (n <= 0)
+      return 0;
+
+    buf += n;
+    len -= n;
+  }
+
+  return 1;
+}
+
+static int
+goosigd_send(int fd, const unsigned char *buf, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, buf, len);
+
+    if (n < 0 && errno == EINTR)
+      continue;
+
+    if (n <= 0)
+      return 0;
+
+    buf += n;
+    len -= n;
+  }
+
+  return 1;
+}
+
+static void
+goosigd_group_id(unsigned char *out,
+                 const unsigned char *n,
+                 size_t n_len,
+                 uint32_t g,
+                 uint32_t h) {
+  unsigned char buf[8];
+  goo_sha256_t sha;
+
+  while (n_len > 0 && n[0] == 0x00) {
+    n += 1;
+    n_len -= 1;
+  }
+
+  goo_bin_write32(buf + 0, g);
+  goo_bin_write32(buf + 4, h);
+
+  goo_sha256_init(&sha);
+  goo_sha256_update(&sha, buf, 8);
+  goo_sha256_update(&sha, n, n_len);
+  goo_sha256_final(&sha, out);
+}
+
+/*
+ * Workers
+ */
+
+static void
+goosigd_push(goosigd_task_t *task) {
+  pthread_mutex_lock(&goosigd.lock);
+
+  task->next = NULL;
+
+  if (goosigd.tail != NULL)
+    goosigd.tail->next = task;
+  else
+    goosigd.head = task;
+
+  goosigd.tail = task;
+
+  pthread_cond_signal(&goosigd.ready);
+  pthread_mutex_unlock(&goosigd.lock);
+}
+
+static goosigd_task_t *
+goosigd_pop(void) {
+  goosigd_task_t *task;
+
+  pthread_mutex_lock(&goosigd.lock);
+
+  while (goosigd.head == NULL)
+    pthread_cond_wait(&goosigd.ready, &goosigd.lock);
+
+  task = goosigd.head;
+  goosigd.head = task->next;
+
+  if (goosigd.head == NULL)
+    goosigd.tail = NULL;
+
+  pthread_mutex_unlock(&goosigd.lock);
+
+  return task;
+}
+
+static void *
+goosigd_work(void *arg) {
+  /* Every worker verifies on a clone sharing the combs. */
+  goo_ctx_t *ctx = goo_clone(goosigd.ctx);
+
+  if (ctx == NULL)
+    goosigd_fatal("could not clone context");
+
+  for (;;) {
+    goosigd_task_t *task = goosigd_pop();
+    goosigd_frame_t *frame = task->frame;
+    size_t i;
+
+    for (i = task->start; i < task->end; i++) {
+      const goosigd_record_t *rec = &frame->records[i];
+
+      frame->results[i] = goo_verify(ctx, rec->msg, rec->msg_len,
+                                     rec->sig, rec->sig_len,
+                                     rec->C1, rec->C1_len) != 0;
+    }
+
+    pthread_mutex_lock(&frame->lock);
+
+    frame->remaining -= task->end - task->start;
+
+    if (frame->remaining == 0)
+      pthread_cond_signal(&frame->done);
+
+    pthread_mutex_unlock(&frame->lock);
+
+    free(task);
+  }
+
+  return NULL;
+}
+
+/*
+ * Frames
+ */
+
+static int
+goosigd_parse(goosigd_frame_t *frame,
+              const unsigned char *body,
+              size_t len) {
+  size_t count, i;
+
+  if (len < 36)
+    return GOOSIGD_ERR_FRAME;
+
+  if (memcmp(body, goosigd.id, 32) != 0)
+    return GOOSIGD_ERR_GROUP;
+
+  count = goo_bin_read32(body + 32);
+
+  body += 36;
+  len -= 36;
+
+  if (count > GOOSIGD_MAX_COUNT)
+    return GOOSIGD_ERR_FRAME;
+
+  frame->records = malloc((count + 1) * sizeof(goosigd_record_t));
+  frame->results = malloc(count + 1);
+  frame->count = count;
+
+  if (frame->records == NULL || frame->results == NULL)
+    return GOOSIGD_ERR_FRAME;
+
+  for (i = 0; i < count; i++) {
+    const unsigned char **ptrs[3];
+    size_t *lens[3];
+    int j;
+
+    ptrs[0] = &frame->records[i].msg;
+    ptrs[1] = &frame->records[i].sig;
+    ptrs[2] = &frame->records[i].C1;
+    lens[0] = &frame->records[i].msg_len;
+    lens[1] = &frame->records[i].sig_len;
+    lens[2] = &frame->records[i].C1_len;
+
+    for (j = 0; j < 3; j++) {
+      size_t size;
+
+      if (len < 4)
+        return GOOSIGD_ERR_FRAME;
+
+      size = goo_bin_read32(body);
+
+      body += 4;
+      len -= 4;
+
+      if (len < size)
+        return GOOSIGD_ERR_FRAME;
+
+      *ptrs[j] = body;
+      *lens[j] = size;
+
+      body += size;
+      len -= size;
+    }
+  }
+
+  if (len != 0)
+    return GOOSIGD_ERR_FRAME;
+
+  return GOOSIGD_OK;
+}
+
+static void
+goosigd_run(goosigd_frame_t *frame) {
+  size_t i;
+
+  frame->remaining = frame->count;
+
+  pthread_mutex_init(&frame->lock, NULL);
+  pthread_cond_init(&frame->done, NULL);
+
+  for (i = 0; i < frame->count; i += GOOSIGD_CHUNK) {
+    goosigd_task_t *task = malloc(sizeof(goosigd_task_t));
+
+    if (task == NULL)
+      goosigd_fatal("out of memory");
+
+    task->frame = frame;
+    task->start = i;
+    task->end = i + GOOSIGD_CHUNK < frame->count
+              ? i + GOOSIGD_CHUNK
+              : frame->count;
+
+    goosigd_push(task);
+  }
+
+  pthread_mutex_lock(&frame->lock);
+
+  while (frame->remaining > 0)
+    pthread_cond_wait(&frame->done, &frame->lock);
+
+  pthread_mutex_unlock(&frame->lock);
+
+  pthread_cond_destroy(&frame->done);
+  pthread_mutex_destroy(&frame->lock);
+}
+
+static void *
+goosigd_serve(void *arg) {
+  int fd = (int)(intptr_t)arg;
+  unsigned char head[8];
+
+  while (goosigd_recv(fd, head, 8)) {
+    unsigned char *body = NULL;
+    unsigned char *out = NULL;
+    goosigd_frame_t frame;
+    size_t len, count;
+    int status;
+
+    if (goo_bin_read32(head) != GOOSIGD_MAGIC)
+      break;
+
+    len = goo_bin_read32(head + 4);
+
+    if (len > GOOSIGD_MAX_BODY)
+      break;
+
+    body = malloc(len + 1);
+
+    if (body == NULL || !goosigd_recv(fd, body, len)) {
+      free(body);
+      break;
+    }
+
+    memset(&frame, 0, sizeof(frame));
+
+    status = goosigd_parse(&frame, body, len);
+    count = status == GOOSIGD_OK ? frame.count : 0;
+
+    if (status == GOOSIGD_OK)
+      goosigd_run(&frame);
+
+    out = malloc(12 + count);
+
+    if (out == NULL)
+      goosigd_fatal("out of memory");
+
+    goo_bin_write32(out + 0, GOOSIGD_MAGIC);
+    goo_bin_write32(out + 4, status);
+    goo_bin_write32(out + 8, count);
+
+    if (count > 0)
+      memcpy(out + 12, frame.results, count);
+
+    status = goosigd_send(fd, out, 12 + count);
+
+    free(out);
+    free(frame.records);
+    free(frame.results);
+    free(body);
+
+    if (!status)
+      break;
+  }
+
+  close(fd);
+
+  return NULL;
+}
+
+/*
+ * Main
+ */
+
+static void
+goosigd_exit(int sig) {
+  unlink(goosigd_path);
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+static void
+goosigd_usage(void) {
+  fprintf(stderr, "Usage: goosigd -n <hex|@file> [-g 2] [-h 3]"
+                  " [-t threads] [-s path]\n");
+  exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv) {
+  const char *modulus = NULL;
+  const char *backend;
+  unsigned long g = 2;
+  unsigned long h = 3;
+  long threads = sysconf(_SC_NPROCESSORS_ONLN);
+  struct sockaddr_un addr;
+  char path[sizeof(addr.sun_path)];
+  unsigned char *n;
+  size_t n_len;
+  mode_t mask;
+  int fd, i;
+
+  for (i = 1; i < argc; i++) {
+    if (i + 1 >= argc)
+      goosigd_usage();
+
+    if (strcmp(argv[i], "-n") == 0)
+      modulus = argv[++i];
+    else if (strcmp(argv[i], "-g") == 0)
+      g = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "-h") == 0)
+      h = strtoul(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "-t") == 0)
+      threads = strtol(argv[++i], NULL, 10);
+    else if (strcmp(argv[i], "-s") == 0)
+      goosigd_path = argv[++i];
+    else
+      goosigd_usage();
+  }
+
+  if (modulus == NULL || threads <= 0)
+    goosigd_usage();
+
+  if (goosigd_path == NULL) {
+    /* Never a shared directory like /tmp: anyone could bind there. */
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+
+    if (dir == NULL || *dir == '\0')
+      goosigd_fatal("no socket path (pass -s or set XDG_RUNTIME_DIR)");
+
+    if (strlen(dir) + 1 + sizeof(GOOSIGD_SOCKET) > sizeof(path))
+      goosigd_fatal("socket path too long");
+
+    strcpy(path, dir);
+    strcat(path, "/");
+    strcat(path, GOOSIGD_SOCKET);
+
+    goosigd_path = path;
+  }
+
+  backend = goo_bin_backend();
+
+  if (!goo_bin_modulus(&n, &n_len, modulus))
+    goosigd_fatal("invalid modulus");
+
+  goosigd.ctx = goo_create(n, n_len, g, h, 0);
+
+  if (goosigd.ctx == NULL)
+    goosigd_fatal("could not create context");
+
+  goosigd_group_id(goosigd.id, n, n_len, g, h);
+
+  free(n);
+
+  pthread_mutex_init(&goosigd.lock, NULL);
+  pthread_cond_init(&goosigd.ready, NULL);
+
+  for (i = 0; i < threads; i++) {
+    pthread_t thread;
+
+    if (pthread_create(&thread, NULL, goosigd_work, NULL) != 0)
+      goosigd_fatal("could not start worker");
+
+    pthread_detach(thread);
+  }
+
+  if (strlen(goosigd_path) >= sizeof(addr.sun_path))
+    goosigd_fatal("socket path too long");
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, goosigd_path);
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+  if (fd < 0)
+    goosigd_fatal("could not create socket");
+
+  unlink(goosigd_path);
+
+  /* Only our own user may connect. */
+  mask = umask(077);
+
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    goosigd_fatal("could not bind socket");
+
+  umask(mask);
+
+  if (chmod(goosigd_path, 0600) != 0)
+    goosigd_fatal("could not set socket mode");
+
+  if (listen(fd, 64) != 0)
+    goosigd_fatal("could not listen");
+
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, goosigd_exit);
+  signal(SIGTERM, goosigd_exit);
+
+  fprintf(stderr, "goosigd: listening on %s (%ld threads, %s)\n",
+          goosigd_path, threads, backend);
+
+  for (;;) {
+    pthread_t thread;
+    int conn = accept(fd, NULL, NULL);
+
+    if (conn < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      goosigd_fatal("could not accept");
+    }
+
+    if (pthread_create(&thread, NULL, goosigd_serve,
+                       (void *)(intptr_t)conn) != 0) {
+      close(conn);
+      continue;
+    }
+
+    pthread_detach(thread);
+  }
+
+  return 0;
+}
@@ -0,0 +1,153 @@
+/*!
+ * util.h - shared helpers for the goosig programs
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ */
+
+#ifndef _GOO_BIN_UTIL_H
+#define _GOO_BIN_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../goo/goo.h"
+
+/* Not every program uses every helper. */
+#if defined(__GNUC__)
+#define GOO_BIN_UNUSED __attribute__((unused))
+#else
+#define GOO_BIN_UNUSED
+#endif
+
+static GOO_BIN_UNUSED uint32_t
+goo_bin_read32(const unsigned char *p) {
+  return ((uint32_t)p[0] << 24)
+       | ((uint32_t)p[1] << 16)
+       | ((uint32_t)p[2] << 8)
+       | ((uint32_t)p[3] << 0);
+}
+
+static GOO_BIN_UNUSED void
+goo_bin_write32(unsigned char *p, uint32_t x) {
+  p[0] = (x >> 24) & 0xff;
+  p[1] = (x >> 16) & 0xff;
+  p[2] = (x >> 8) & 0xff;
+  p[3] = (x >> 0) & 0xff;
+}
+
+static GOO_BIN_UNUSED int
+goo_bin_unhex(unsigned char **out, size_t *out_len, const char *str) {
+  size_t len = strlen(str);
+  unsigned char *data = malloc(len / 2 + 1);
+  size_t j = 0;
+  int hi = -1;
+  size_t i;
+
+  if (data == NULL)
+    return 0;
+
+  for (i = 0; i < len; i++) {
+    int ch = str[i];
+    int nib;
+
+    if (ch >= '0' && ch <= '9')
+      nib = ch - '0';
+    else if (ch >= 'a' && ch <= 'f')
+      nib = ch - 'a' + 10;
+    else if (ch >= 'A' && ch <= 'F')
+      nib = ch - 'A' + 10;
+    else if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
+      continue;
+    else
+      goto fail;
+
+    if (hi < 0) {
+      hi = nib;
+    } else {
+      data[j++] = (hi << 4) | nib;
+      hi = -1;
+    }
+  }
+
+  if (hi >= 0 || j == 0)
+    goto fail;
+
+  *out = data;
+  *out_len = j;
+
+  return 1;
+fail:
+  free(data);
+  return 0;
+}
+
+static GOO_BIN_UNUSED char *
+goo_bin_slurp(const char *file) {
+  FILE *fp = fopen(file, "rb");
+  char *str = NULL;
+  long size;
+
+  if (fp == NULL)
+    return NULL;
+
+  if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0)
+    goto done;
+
+  rewind(fp);
+
+  str = malloc(size + 1);
+
+  if (str == NULL)
+    goto done;
+
+  if (fread(str, 1, size, fp) != (size_t)size) {
+    free(str);
+    str = NULL;
+    goto done;
+  }
+
+  str[size] = '\0';
+done:
+  fclose(fp);
+  return str;
+}
+
+/* Use a system libgmp when the build fell back to mini-gmp
+   (unless GOOSIG_NO_GMP is set). */
+static GOO_BIN_UNUSED const char *
+goo_bin_backend(void) {
+  if (getenv("GOOSIG_NO_GMP") == NULL)
+    goo_load_gmp();
+
+  return goo_backend();
+}
+
+/* Parse a modulus given as hex, or as `@file` containing hex. */
+static GOO_BIN_UNUSED int
+goo_bin_modulus(unsigned char **out, size_t *out_len, const char *arg) {
+  char *hex;
+  int ok;
+
+  if (arg[0] == '@') {
+    hex = goo_bin_slurp(arg + 1);
+
+    if (hex == NULL)
+      return 0;
+  } else {
+    hex = malloc(strlen(arg) + 1);
+
+    if (hex == NULL)
+      return 0;
+
+    strcpy(hex, arg);
+  }
+
+  ok = goo_bin_unhex(out, out_len, hex);
+
+  free(hex);
+
+  return ok;
+}
+
+#endif
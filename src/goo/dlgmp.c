@@ -0,0 +1,117 @@
+/*!
+ * dlgmp.c - runtime gmp loading for C89
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ */
+
+#define GOO_DLGMP_IMPL
+
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include "dlgmp.h"
+
+#define GOO_MPZ_DEFAULT(ret, name, args) mpz_##name,
+
+goo_mpz_table_t goo_mpz_table = {
+  GOO_MPZ_FUNCS(GOO_MPZ_DEFAULT)
+  NULL
+};
+
+#undef GOO_MPZ_DEFAULT
+
+static void *goo_dlgmp_handle = NULL;
+
+#ifndef _WIN32
+static int
+goo_dlgmp_sym(void *handle, void *out, const char *prefix, const char *name) {
+  /* ISO C has no conversion from void * to a function
+     pointer, so the symbol address is copied instead. */
+  char sym[64];
+  void *ptr;
+
+  if (strlen(prefix) + strlen(name) >= sizeof(sym))
+    return 0;
+
+  strcpy(sym, prefix);
+  strcat(sym, name);
+
+  ptr = dlsym(handle, sym);
+
+  if (ptr == NULL)
+    return 0;
+
+  memcpy(out, &ptr, sizeof(ptr));
+
+  return 1;
+}
+#endif
+
+int
+goo_dlgmp_load(void) {
+#ifdef _WIN32
+  return 0;
+#else
+  static const char *names[] = {
+    "libgmp.so.10",
+    "libgmp.so",
+    "libgmp.10.dylib",
+    "libgmp.dylib"
+  };
+
+  goo_mpz_table_t table;
+  const int *bits;
+  void *handle = NULL;
+  size_t i;
+
+  if (goo_dlgmp_handle != NULL)
+    return 1;
+
+  for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    handle = dlopen(names[i], RTLD_NOW | RTLD_LOCAL);
+
+    if (handle != NULL)
+      break;
+  }
+
+  if (handle == NULL)
+    return 0;
+
+  /* The limbs must match for the shared mpz_t layout. */
+  if (!goo_dlgmp_sym(handle, &bits, "__gmp_", "bits_per_limb"))
+    goto fail;
+
+  if (*bits != (int)(sizeof(mp_limb_t) * CHAR_BIT))
+    goto fail;
+
+#define GOO_MPZ_LOAD(ret, name, args)                    \
+  if (!goo_dlgmp_sym(handle, &table.name, "__gmpz_", #name)) \
+    goto fail;
+
+  GOO_MPZ_FUNCS(GOO_MPZ_LOAD)
+
+#undef GOO_MPZ_LOAD
+
+  if (!goo_dlgmp_sym(handle, &table.powm_sec, "__gmpz_", "powm_sec"))
+    table.powm_sec = NULL;
+
+  memcpy(&goo_mpz_table, &table, sizeof(table));
+
+  goo_dlgmp_handle = handle;
+
+  return 1;
+fail:
+  dlclose(handle);
+  return 0;
+#endif
+}
+
+int
+goo_dlgmp_loaded(void) {
+  return goo_dlgmp_handle != NULL;
+}
@@ -0,0 +1,133 @@
+/*!
+ * dlgmp.h - runtime gmp loading for C89
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ *
+ * Builds without libgmp-dev link mini-gmp, but route every mpz call
+ * through the table below. If a system libgmp with the same limb size
+ * can be loaded at startup, the table is switched over to it. GMP and
+ * mini-gmp share the mpz_t layout and both allocate with malloc, so
+ * the struct accessors (mpz_sgn, mpz_odd_p, ...) work with either.
+ *
+ * Every mpz function used by goo must appear here.
+ */
+
+#ifndef _GOOSIG_DLGMP_H
+#define _GOOSIG_DLGMP_H
+
+#include "mini-gmp.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#define GOO_MPZ_FUNCS(X)                                                    \
+  X(void, init, (mpz_ptr))                                                  \
+  X(void, clear, (mpz_ptr))                                                 \
+  X(void, swap, (mpz_ptr, mpz_ptr))                                         \
+  X(void, set, (mpz_ptr, mpz_srcptr))                                       \
+  X(void, set_ui, (mpz_ptr, unsigned long))                                 \
+  X(void, set_si, (mpz_ptr, long))                                          \
+  X(int, set_str, (mpz_ptr, const char *, int))                             \
+  X(int, cmp, (mpz_srcptr, mpz_srcptr))                                     \
+  X(int, cmp_ui, (mpz_srcptr, unsigned long))                               \
+  X(int, cmp_si, (mpz_srcptr, long))                                        \
+  X(void, neg, (mpz_ptr, mpz_srcptr))                                       \
+  X(void, add, (mpz_ptr, mpz_srcptr, mpz_srcptr))                           \
+  X(void, add_ui, (mpz_ptr, mpz_srcptr, unsigned long))                     \
+  X(void, sub, (mpz_ptr, mpz_srcptr, mpz_srcptr))                           \
+  X(void, sub_ui, (mpz_ptr, mpz_srcptr, unsigned long))                     \
+  X(void, mul, (mpz_ptr, mpz_srcptr, mpz_srcptr))                           \
+  X(void, mul_ui, (mpz_ptr, mpz_srcptr, unsigned long))                     \
+  X(void, mul_2exp, (mpz_ptr, mpz_srcptr, mp_bitcnt_t))                     \
+  X(void, mod, (mpz_ptr, mpz_srcptr, mpz_srcptr))                           \
+  X(void, fdiv_q, (mpz_ptr, mpz_srcptr, mpz_srcptr))                        \
+  X(void, fdiv_q_2exp, (mpz_ptr, mpz_srcptr, mp_bitcnt_t))                  \
+  X(unsigned long, fdiv_ui, (mpz_srcptr, unsigned long))                    \
+  X(void, tdiv_q_2exp, (mpz_ptr, mpz_srcptr, mp_bitcnt_t))                  \
+  X(void, divexact, (mpz_ptr, mpz_srcptr, mpz_srcptr))                      \
+  X(void, powm, (mpz_ptr, mpz_srcptr, mpz_srcptr, mpz_srcptr))              \
+  X(void, powm_ui, (mpz_ptr, mpz_srcptr, unsigned long, mpz_srcptr))        \
+  X(int, invert, (mpz_ptr, mpz_srcptr, mpz_srcptr))                         \
+  X(void, gcd, (mpz_ptr, mpz_srcptr, mpz_srcptr))                           \
+  X(void, gcdext, (mpz_ptr, mpz_ptr, mpz_ptr, mpz_srcptr, mpz_srcptr))      \
+  X(int, perfect_square_p, (mpz_srcptr))                                    \
+  X(void, and, (mpz_ptr, mpz_srcptr, mpz_srcptr))                           \
+  X(void, ior, (mpz_ptr, mpz_srcptr, mpz_srcptr))                           \
+  X(void, setbit, (mpz_ptr, mp_bitcnt_t))                                   \
+  X(int, tstbit, (mpz_srcptr, mp_bitcnt_t))                                 \
+  X(mp_bitcnt_t, scan1, (mpz_srcptr, mp_bitcnt_t))                          \
+  X(size_t, size, (mpz_srcptr))                                             \
+  X(size_t, sizeinbase, (mpz_srcptr, int))                                  \
+  X(mp_limb_t, getlimbn, (mpz_srcptr, mp_size_t))                           \
+  X(void, import, (mpz_ptr, size_t, int, size_t, int, size_t, const void *))\
+  X(void *, export, (void *, size_t *, int, size_t, int, size_t, mpz_srcptr))
+
+#define GOO_MPZ_FIELD(ret, name, args) ret (*name) args;
+
+typedef struct goo_mpz_table_s {
+  GOO_MPZ_FUNCS(GOO_MPZ_FIELD)
+  /* Only available from GMP (NULL otherwise). */
+  void (*powm_sec)(mpz_ptr, mpz_srcptr, mpz_srcptr, mpz_srcptr);
+} goo_mpz_table_t;
+
+#undef GOO_MPZ_FIELD
+
+extern goo_mpz_table_t goo_mpz_table;
+
+/* Switch the table over to a system libgmp. Must be called before any
+ * mpz is initialized. Returns 1 if GMP is in use. */
+int
+goo_dlgmp_load(void);
+
+int
+goo_dlgmp_loaded(void);
+
+#ifndef GOO_DLGMP_IMPL
+#define mpz_init goo_mpz_table.init
+#define mpz_clear goo_mpz_table.clear
+#define mpz_swap goo_mpz_table.swap
+#define mpz_set goo_mpz_table.set
+#define mpz_set_ui goo_mpz_table.set_ui
+#define mpz_set_si goo_mpz_table.set_si
+#define mpz_set_str goo_mpz_table.set_str
+#define mpz_cmp goo_mpz_table.cmp
+#define mpz_cmp_ui goo_mpz_table.cmp_ui
+#define mpz_cmp_si goo_mpz_table.cmp_si
+#define mpz_neg goo_mpz_table.neg
+#define mpz_add goo_mpz_table.add
+#define mpz_add_ui goo_mpz_table.add_ui
+#define mpz_sub goo_mpz_table.sub
+#define mpz_sub_ui goo_mpz_table.sub_ui
+#define mpz_mul goo_mpz_table.mul
+#define mpz_mul_ui goo_mpz_table.mul_ui
+#define mpz_mul_2exp goo_mpz_table.mul_2exp
+#define mpz_mod goo_mpz_table.mod
+#define mpz_fdiv_q goo_mpz_table.fdiv_q
+#define mpz_fdiv_q_2exp goo_mpz_table.fdiv_q_2exp
+#define mpz_fdiv_ui goo_mpz_table.fdiv_ui
+#define mpz_tdiv_q_2exp goo_mpz_table.tdiv_q_2exp
+#define mpz_divexact goo_mpz_table.divexact
+#define mpz_powm goo_mpz_table.powm
+#define mpz_powm_ui goo_mpz_table.powm_ui
+#define mpz_invert goo_mpz_table.invert
+#define mpz_gcd goo_mpz_table.gcd
+#define mpz_gcdext goo_mpz_table.gcdext
+#define mpz_perfect_square_p goo_mpz_table.perfect_square_p
+#define mpz_and goo_mpz_table.and
+#define mpz_ior goo_mpz_table.ior
+#define mpz_setbit goo_mpz_table.setbit
+#define mpz_tstbit goo_mpz_table.tstbit
+#define mpz_scan1 goo_mpz_table.scan1
+#define mpz_size goo_mpz_table.size
+#define mpz_sizeinbase goo_mpz_table.sizeinbase
+#define mpz_getlimbn goo_mpz_table.getlimbn
+#define mpz_import goo_mpz_table.import
+#define mpz_export goo_mpz_table.export
+#endif
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
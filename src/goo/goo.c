@@ -924,6 +924,214 @@ fail:
   return r;
 }
 
+static int
+goo_is_prime_mr4(int *ok,
+                 mpz_srcptr *n,
+                 const unsigned char *keys,
+                 size_t len,
+                 unsigned long reps,
+                 int force2,
+                 unsigned int cpu) {
+  /* goo_is_prime_mr for up to four moduli at once, one per goo_smont4
+   * lane, with the same bases per modulus. `n` must be odd and at least
+   * 7; `keys` holds 32 bytes per modulus. Returns 0 without touching
+   * `ok` if a modulus is wider than GOO_SMONT4_BITS.
+   *
+   * The exponents differ per lane, so windows are fixed at four bits
+   * and every lane multiplies by its own table entry at each one. The
+   * squarings after x^q run for as long as any lane is still looking
+   * for -1; lanes which are done simply ride along.
+   */
+  const size_t size = GOO_SMONT4_BITS / 8;
+  unsigned char raw[4 * (GOO_SMONT4_BITS / 8)];
+  unsigned char nm1s[4 * (GOO_SMONT4_BITS / 8)];
+  unsigned char one[GOO_SMONT4_BITS / 8];
+  unsigned char digits[4][GOO_SMONT4_BITS / 4];
+  goo_limb_t table[16][GOO_SMONT4_WORDS];
+  goo_limb_t y[GOO_SMONT4_WORDS];
+  const goo_limb_t *lanes[4];
+  unsigned long k[4];
+  int state[4];
+  goo_prng_t prng[4];
+  mpz_srcptr m[4];
+  mpz_t nm1, nm3[4], q[4], x;
+  goo_smont4_t sm;
+  size_t bits, top, i, j, w;
+  unsigned long s, kmax;
+  int live;
+
+  assert(len >= 1 && len <= 4);
+
+  /* Unused lanes repeat the first modulus. */
+  for (j = 0; j < 4; j++) {
+    m[j] = n[j < len ? j : 0];
+
+    if (goo_mpz_bitlen(m[j]) > GOO_SMONT4_BITS)
+      return 0;
+
+    goo_mpz_pad(raw + j * size, size, m[j]);
+  }
+
+  if (!goo_smont4_init(&sm, raw, size, cpu))
+    return 0;
+
+  mpz_init(nm1);
+  mpz_init(x);
+
+  memset(one, 0x00, size);
+  one[size - 1] = 0x01;
+
+  bits = 0;
+
+  for (j = 0; j < 4; j++) {
+    mpz_init(nm3[j]);
+    mpz_init(q[j]);
+
+    /* nm1 = n - 1, nm3 = nm1 - 2 */
+    mpz_sub_ui(nm1, m[j], 1);
+    mpz_sub_ui(nm3[j], nm1, 2);
+
+    goo_mpz_pad(nm1s + j * size, size, nm1);
+
+    /* q = nm1 >> k, for the largest such k */
+    k[j] = goo_mpz_zerobits(nm1);
+    mpz_tdiv_q_2exp(q[j], nm1, k[j]);
+
+    if (goo_mpz_bitlen(q[j]) > bits)
+      bits = goo_mpz_bitlen(q[j]);
+
+    /* q is the same for every round: split it into windows once. */
+    for (w = 0; w < GOO_SMONT4_BITS / 4; w++) {
+      digits[j][w] = mpz_tstbit(q[j], w * 4)
+                   | (mpz_tstbit(q[j], w * 4 + 1) << 1)
+                   | (mpz_tstbit(q[j], w * 4 + 2) << 2)
+                   | (mpz_tstbit(q[j], w * 4 + 3) << 3);
+    }
+
+    goo_prng_init(&prng[j]);
+    goo_prng_seed(&prng[j], keys + (j < len ? j : 0) * 32,
+                  GOO_PRNG_PRIMALITY);
+  }
+
+  for (j = 0; j < len; j++)
+    ok[j] = 1;
+
+  top = (bits + 3) / 4;
+
+  for (i = 0; i < reps; i++) {
+    for (j = 0; j < 4; j++) {
+      if (i == reps - 1 && force2) {
+        /* x = 2 */
+        mpz_set_ui(x, 2);
+      } else {
+        /* x = random integer in [2,n-1] */
+        goo_prng_random_int(&prng[j], x, nm3[j]);
+        mpz_add_ui(x, x, 2);
+      }
+
+      goo_mpz_pad(raw + j * size, size, x);
+    }
+
+    /* table[i] = x^i */
+    goo_smont4_set_one(&sm, table[0]);
+    goo_smont4_import(&sm, table[1], raw, size);
+
+    for (w = 2; w < 16; w++)
+      goo_smont4_mul(&sm, table[w], table[w - 1], table[1]);
+
+    /* y = x^q mod n */
+    goo_smont4_set_one(&sm, y);
+
+    for (w = top; w-- > 0;) {
+      for (j = 0; j < 4; j++)
+        lanes[j] = table[digits[j][w]];
+
+      if (w != top - 1) {
+        goo_smont4_sqr(&sm, y, y);
+        goo_smont4_sqr(&sm, y, y);
+        goo_smont4_sqr(&sm, y, y);
+        goo_smont4_sqr(&sm, y, y);
+      }
+
+      goo_smont4_mul_lanes(&sm, y, y, lanes);
+    }
+
+    goo_smont4_export(&sm, raw, size, y);
+
+    /* Lanes with y == 1 or y == -1 pass this round, */
+    /* the rest square until they find -1. */
+    kmax = 0;
+    live = 0;
+
+    for (j = 0; j < len; j++) {
+      state[j] = 0;
+
+      if (!ok[j])
+        continue;
+
+      if (memcmp(raw + j * size, one, size) == 0
+          || memcmp(raw + j * size, nm1s + j * size, size) == 0) {
+        continue;
+      }
+
+      state[j] = 1;
+
+      if (k[j] > kmax)
+        kmax = k[j];
+    }
+
+    for (s = 1; s < kmax; s++) {
+      /* y = y^2 mod n */
+      goo_smont4_sqr(&sm, y, y);
+      goo_smont4_export(&sm, raw, size, y);
+
+      for (j = 0; j < len; j++) {
+        if (!state[j])
+          continue;
+
+        if (s >= k[j]) {
+          ok[j] = 0;
+          state[j] = 0;
+          continue;
+        }
+
+        /* if y == -1 mod n */
+        if (memcmp(raw + j * size, nm1s + j * size, size) == 0) {
+          state[j] = 0;
+          continue;
+        }
+
+        /* if y == 1 mod n */
+        if (memcmp(raw + j * size, one, size) == 0) {
+          ok[j] = 0;
+          state[j] = 0;
+        }
+      }
+    }
+
+    for (j = 0; j < len; j++) {
+      if (state[j])
+        ok[j] = 0;
+
+      live |= ok[j];
+    }
+
+    if (!live)
+      break;
+  }
+
+  for (j = 0; j < 4; j++) {
+    mpz_clear(nm3[j]);
+    mpz_clear(q[j]);
+    goo_prng_uninit(&prng[j]);
+  }
+
+  mpz_clear(nm1);
+  mpz_clear(x);
+
+  return 1;
+}
+
 /* https://github.com/golang/go/blob/aadaec5/src/math/big/prime.go#L150 */
 static int
 goo_is_prime_lucas(const mpz_t n, unsigned long limit) {
@@ -1103,12 +1311,53 @@ goo_is_prime(const mpz_t p, const unsigned char *key) {
   return 1;
 }
 
+static void
+goo_is_prime_batch(int *ok,
+                   mpz_srcptr *p,
+                   const unsigned char *keys,
+                   size_t len,
+                   unsigned int cpu) {
+  /* goo_is_prime for `len` numbers (with 32 byte keys), running
+     the Miller-Rabin rounds of four at a time in lockstep. */
+  unsigned char lkeys[4 * 32];
+  mpz_srcptr lanes[4];
+  size_t idx[4];
+  int res[4];
+  size_t i, j;
+  size_t m = 0;
+
+  for (i = 0; i < len; i++) {
+    ok[i] = goo_is_prime_div(p[i]);
+
+    if (ok[i] == -1) {
+      lanes[m] = p[i];
+      memcpy(lkeys + m * 32, keys + i * 32, 32);
+      idx[m++] = i;
+    }
+
+    if (m == 4 || (m > 0 && i == len - 1)) {
+      if (!goo_is_prime_mr4(res, lanes, lkeys, m, 16 + 1, 1, cpu)) {
+        for (j = 0; j < m; j++)
+          res[j] = goo_is_prime_mr(lanes[j], lkeys + j * 32, 16 + 1, 1);
+      }
+
+      for (j = 0; j < m; j++)
+        ok[idx[j]] = res[j] && goo_is_prime_lucas(lanes[j], 50);
+
+      m = 0;
+    }
+  }
+}
+
 static int
 goo_next_prime(mpz_t ret,
                const mpz_t p,
                const unsigned char *key,
                unsigned long max) {
   unsigned long inc = 0;
+  int r = 0;
+
+  GOO_PROBE1(next_prime__entry, goo_mpz_bitlen(p));
 
   mpz_set(ret, p);
 
@@ -1126,9 +1375,12 @@ goo_next_prime(mpz_t ret,
   }
 
   if (max != 0 && inc > max)
-    return 0;
+    goto fail;
 
-  return 1;
+  r = 1;
+fail:
+  GOO_PROBE2(next_prime__return, goo_mpz_bitlen(p), r);
+  return r;
 }
 
 /*
@@ -1352,9 +1604,10 @@ combspec_generate(goo_combspec_t **specs,
                   unsigned long shifts,
                   unsigned long aps,
                   unsigned long ppa,
-                  unsigned long bps) {
+                  unsigned long bps,
+                  unsigned long bases) {
   unsigned long ops = shifts * (aps + 1) - 1;
-  unsigned long size = ((1 << ppa) - 1) * aps;
+  unsigned long size = ((1UL << (ppa * bases)) - 1) * aps;
   goo_combspec_t *best;
 
   assert((size_t)ops < specs_len);
@@ -1378,7 +1631,10 @@ combspec_generate(goo_combspec_t **specs,
 static int
 goo_combspec_init(goo_combspec_t *out,
                   unsigned long bits,
-                  unsigned long max_size) {
+                  unsigned long max_size,
+                  unsigned long bases) {
+  /* A joint comb (bases = 2) holds every product of a g point */
+  /* and an h point, so its subcombs are squared in size. */
   int r = 0;
   size_t specs_len, i;
   goo_combspec_t **specs, *ret;
@@ -1391,7 +1647,7 @@ goo_combspec_init(goo_combspec_t *out,
   specs_len = combspec_size(bits);
   specs = goo_calloc(specs_len, sizeof(goo_combspec_t *));
 
-  for (ppa = 2; ppa < 18; ppa++) {
+  for (ppa = 2; ppa * bases < 18; ppa++) {
     unsigned long bpw = (bits + ppa - 1) / ppa;
     unsigned long sqrt = goo_isqrt(bpw);
     unsigned long aps;
@@ -1407,8 +1663,8 @@ goo_combspec_init(goo_combspec_t *out,
       assert(shifts != 0);
       assert(aps != 0);
 
-      combspec_generate(specs, specs_len, shifts, aps, ppa, bpw);
-      combspec_generate(specs, specs_len, aps, shifts, ppa, bpw);
+      combspec_generate(specs, specs_len, shifts, aps, ppa, bpw, bases);
+      combspec_generate(specs, specs_len, aps, shifts, ppa, bpw, bases);
     }
   }
 
@@ -1447,6 +1703,76 @@ fail:
   return r;
 }
 
+/*
+ * Montgomery
+ */
+
+static size_t
+goo_group_mtable4_size(const goo_group_t *group) {
+  /* Three tables of four lanes (b1, b2 and b2^-1), and an accumulator. */
+  size_t words = goo_mont4_words(&group->mont);
+  return (3 * GOO_TABLEN + 1) * words * sizeof(goo_limb_t);
+}
+
+static void
+goo_group_mont_pad(goo_group_t *group, unsigned char *raw, const mpz_t x) {
+  /* raw = x mod n */
+  if (mpz_sgn(x) < 0 || mpz_cmp(x, group->n) >= 0) {
+    mpz_t t;
+
+    mpz_init(t);
+    mpz_mod(t, x, group->n);
+
+    goo_mpz_pad(raw, group->size, t);
+
+    mpz_clear(t);
+  } else {
+    goo_mpz_pad(raw, group->size, x);
+  }
+}
+
+static void
+goo_group_mont_set(goo_group_t *group, goo_limb_t *out, const mpz_t x) {
+  /* out = x * R mod n */
+  unsigned char raw[GOO_MAX_RSA_BYTES];
+
+  goo_group_mont_pad(group, raw, x);
+  goo_mont_import(&group->mont, out, raw, group->size);
+}
+
+static void
+goo_group_mont_get(goo_group_t *group, mpz_t ret, const goo_limb_t *x) {
+  /* ret = x / R mod n */
+  unsigned char raw[GOO_MAX_RSA_BYTES];
+
+  goo_mont_export(&group->mont, raw, group->size, x);
+  goo_mpz_import(ret, raw, group->size);
+}
+
+static void
+goo_group_mont4_set(goo_group_t *group, goo_limb_t *out, mpz_srcptr *x) {
+  /* out[j] = x[j] * R mod n */
+  unsigned char raw[4 * GOO_MAX_RSA_BYTES];
+  size_t j;
+
+  for (j = 0; j < 4; j++)
+    goo_group_mont_pad(group, &raw[j * group->size], x[j]);
+
+  goo_mont4_import(&group->mont, out, raw, group->size);
+}
+
+static void
+goo_group_mont4_get(goo_group_t *group, mpz_t *ret, const goo_limb_t *x) {
+  /* ret[j] = x[j] / R mod n */
+  unsigned char raw[4 * GOO_MAX_RSA_BYTES];
+  size_t j;
+
+  goo_mont4_export(&group->mont, raw, group->size, x);
+
+  for (j = 0; j < 4; j++)
+    goo_mpz_import(ret[j], &raw[j * group->size], group->size);
+}
+
 /*
  * Comb
  */
@@ -1460,85 +1786,192 @@ goo_group_pow_slow(goo_group_t *group,
 static void
 goo_group_mul(goo_group_t *group, mpz_t ret, const mpz_t m1, const mpz_t m2);
 
+static void
+goo_comb_precomp_mont(goo_comb_t *comb,
+                      goo_group_t *group,
+                      mpz_t base,
+                      mpz_srcptr base2) {
+  /* Same points as below, computed in montgomery form. */
+  /* Raising to a power of two is just repeated squaring. */
+  goo_mont_t *mont = &group->mont;
+  size_t limbs = mont->limbs;
+  unsigned long teeth = comb->points_per_add * comb->bases;
+  unsigned long i, j, k, t, skip;
+  goo_limb_t *items;
+
+  comb->mitems = goo_calloc(comb->size * limbs, sizeof(goo_limb_t));
+
+  items = comb->mitems;
+
+  skip = comb->points_per_subcomb;
+
+  for (i = 0; i < comb->adds_per_shift; i++) {
+    goo_limb_t *sub = &items[i * skip * limbs];
+
+    for (t = 0; t < teeth; t++) {
+      unsigned long x = 1UL << t;
+      goo_limb_t *bx = &sub[(x - 1) * limbs];
+
+      if (i > 0) {
+        /* Only the teeth are shifted; the rest are their products. */
+        goo_mont_copy(mont, bx, bx - skip * limbs);
+
+        for (k = 0; k < comb->shifts; k++)
+          goo_mont_sqr(mont, bx, bx);
+      } else if (t == 0) {
+        goo_group_mont_set(group, bx, base);
+      } else if (t == comb->points_per_add) {
+        /* The second base starts the upper teeth. */
+        goo_group_mont_set(group, bx, base2);
+      } else {
+        goo_mont_copy(mont, bx, &sub[((x >> 1) - 1) * limbs]);
+
+        for (k = 0; k < comb->bits_per_window; k++)
+          goo_mont_sqr(mont, bx, bx);
+      }
+
+      for (j = x + 1; j < 2 * x; j++) {
+        goo_mont_mul(mont, &sub[(j - 1) * limbs],
+                           &sub[(j - x - 1) * limbs], bx);
+      }
+    }
+  }
+}
+
 static void
 goo_comb_init(goo_comb_t *comb,
               goo_group_t *group,
               mpz_t base,
+              mpz_srcptr base2,
               goo_combspec_t *spec) {
-  unsigned long i, j, skip;
-  mpz_t *items, exp;
+  /* With `base2`, a joint comb: the points are every product */
+  /* of a point of `base` and a point of `base2`, and `spec` */
+  /* must have been made for two bases. */
+  unsigned long bases = base2 != NULL ? 2 : 1;
+  unsigned long teeth = spec->points_per_add * bases;
+  unsigned long i, j, t, skip;
+  mpz_t exp, shift;
 
-  assert((size_t)spec->points_per_add <= sizeof(unsigned long) * 8);
+  assert((size_t)teeth <= sizeof(unsigned long) * 8);
 
-  mpz_init(exp);
+  GOO_PROBE2(comb_init__entry, group->bits, spec->size);
 
   comb->points_per_add = spec->points_per_add;
   comb->adds_per_shift = spec->adds_per_shift;
   comb->shifts = spec->shifts;
   comb->bits_per_window = spec->bits_per_window;
   comb->bits = spec->bits_per_window * spec->points_per_add;
-  comb->points_per_subcomb = (1 << spec->points_per_add) - 1;
+  comb->points_per_subcomb = (1UL << teeth) - 1;
   comb->size = spec->size;
-  comb->items = goo_calloc(comb->size, sizeof(mpz_t));
+  comb->bases = bases;
+  comb->shared = 0;
+  comb->items = NULL;
+  comb->mitems = NULL;
   comb->wins = goo_calloc(comb->shifts, sizeof(unsigned long *));
 
-  for (i = 0; i < comb->size; i++)
-    mpz_init(comb->items[i]);
-
   for (i = 0; i < comb->shifts; i++)
     comb->wins[i] = goo_calloc(comb->adds_per_shift, sizeof(unsigned long));
 
-  mpz_set(comb->items[0], base);
+  if (group->use_mont) {
+    goo_comb_precomp_mont(comb, group, base, base2);
+    GOO_PROBE2(comb_init__return, group->bits, comb->size);
+    return;
+  }
+
+  mpz_init(exp);
+
+  comb->items = goo_calloc(comb->size, sizeof(mpz_t));
+
+  for (i = 0; i < comb->size; i++)
+    mpz_init(comb->items[i]);
 
-  items = &comb->items[0];
+  mpz_init(shift);
 
   /* exp = 1 << bits_per_window */
   mpz_set_ui(exp, 1);
   mpz_mul_2exp(exp, exp, comb->bits_per_window);
 
-  for (i = 1; i < comb->points_per_add; i++) {
-    unsigned long x = 1 << i;
-    unsigned long y = x >> 1;
-
-    goo_group_pow_slow(group, items[x - 1], items[y - 1], exp);
+  /* shift = 1 << shifts */
+  mpz_set_ui(shift, 1);
+  mpz_mul_2exp(shift, shift, comb->shifts);
 
-    for (j = x + 1; j < 2 * x; j++)
-      goo_group_mul(group, items[j - 1], items[j - x - 1], items[x - 1]);
-  }
+  skip = comb->points_per_subcomb;
 
-  /* exp = 1 << shifts */
-  mpz_set_ui(exp, 1);
-  mpz_mul_2exp(exp, exp, comb->shifts);
+  for (i = 0; i < comb->adds_per_shift; i++) {
+    mpz_t *items = &comb->items[i * skip];
 
-  skip = comb->points_per_subcomb;
+    for (t = 0; t < teeth; t++) {
+      unsigned long x = 1UL << t;
 
-  for (i = 1; i < comb->adds_per_shift; i++) {
-    for (j = 0; j < skip; j++) {
-      unsigned long k = i * skip + j;
+      /* Only the teeth are shifted; the rest are their products. */
+      /* The second base starts the upper teeth. */
+      if (i > 0)
+        goo_group_pow_slow(group, items[x - 1], items[x - 1 - skip], shift);
+      else if (t == 0)
+        mpz_set(items[0], base);
+      else if (t == comb->points_per_add)
+        mpz_set(items[x - 1], base2);
+      else
+        goo_group_pow_slow(group, items[x - 1], items[(x >> 1) - 1], exp);
 
-      goo_group_pow_slow(group, items[k], items[k - skip], exp);
+      for (j = x + 1; j < 2 * x; j++)
+        goo_group_mul(group, items[j - 1], items[j - x - 1], items[x - 1]);
     }
   }
 
   mpz_clear(exp);
+  mpz_clear(shift);
+
+  GOO_PROBE2(comb_init__return, group->bits, comb->size);
+}
+
+static void
+goo_comb_clone(goo_comb_t *comb, const goo_comb_t *parent) {
+  unsigned long i;
+
+  comb->points_per_add = parent->points_per_add;
+  comb->adds_per_shift = parent->adds_per_shift;
+  comb->shifts = parent->shifts;
+  comb->bits_per_window = parent->bits_per_window;
+  comb->bits = parent->bits;
+  comb->points_per_subcomb = parent->points_per_subcomb;
+  comb->size = parent->size;
+  comb->bases = parent->bases;
+
+  /* The precomputed points are only ever read, so they are */
+  /* shared. The window scratch space is per-context. */
+  comb->shared = 1;
+  comb->items = parent->items;
+  comb->mitems = parent->mitems;
+  comb->wins = goo_calloc(comb->shifts, sizeof(unsigned long *));
+
+  for (i = 0; i < comb->shifts; i++)
+    comb->wins[i] = goo_calloc(comb->adds_per_shift, sizeof(unsigned long));
 }
 
 static void
 goo_comb_uninit(goo_comb_t *comb) {
   unsigned long i;
 
-  for (i = 0; i < comb->size; i++)
-    mpz_clear(comb->items[i]);
+  if (!comb->shared) {
+    if (comb->items != NULL) {
+      for (i = 0; i < comb->size; i++)
+        mpz_clear(comb->items[i]);
+    }
+
+    goo_free(comb->items);
+    goo_free(comb->mitems);
+  }
 
   for (i = 0; i < comb->shifts; i++)
     goo_free(comb->wins[i]);
 
-  goo_free(comb->items);
   goo_free(comb->wins);
 
   comb->shifts = 0;
   comb->size = 0;
   comb->items = NULL;
+  comb->mitems = NULL;
   comb->wins = NULL;
 }
 
@@ -1550,30 +1983,46 @@ goo_comb_cleanse(goo_comb_t *comb) {
     goo_cleanse(comb->wins[i], comb->adds_per_shift * sizeof(unsigned long));
 }
 
+static unsigned long
+goo_comb_window(const goo_comb_t *comb,
+                const mpz_t e,
+                unsigned long i,
+                unsigned long j) {
+  unsigned long ret = 0;
+  unsigned long k;
+
+  for (k = 0; k < comb->points_per_add; k++) {
+    unsigned long b = (i + k * comb->adds_per_shift) * comb->shifts + j;
+
+    ret <<= 1;
+    ret |= mpz_tstbit(e, (comb->bits - 1) - b);
+  }
+
+  return ret;
+}
+
 static int
-goo_comb_recode(goo_comb_t *comb, const mpz_t e) {
-  unsigned long len = goo_mpz_bitlen(e);
+goo_comb_recode(goo_comb_t *comb, const mpz_t e1, mpz_srcptr e2) {
+  /* A joint comb takes both exponents, with the window */
+  /* of `e2` selecting its upper teeth. */
   long i;
 
-  if (len > comb->bits)
+  if (goo_mpz_bitlen(e1) > comb->bits || mpz_sgn(e1) < 0)
     return 0;
 
-  if (mpz_sgn(e) < 0)
-    return 0;
+  if (comb->bases == 2) {
+    if (goo_mpz_bitlen(e2) > comb->bits || mpz_sgn(e2) < 0)
+      return 0;
+  }
 
   for (i = (long)comb->adds_per_shift - 1; i >= 0; i--) {
     unsigned long j;
 
     for (j = 0; j < comb->shifts; j++) {
-      unsigned long ret = 0;
-      unsigned long k;
-
-      for (k = 0; k < comb->points_per_add; k++) {
-        unsigned long b = (i + k * comb->adds_per_shift) * comb->shifts + j;
+      unsigned long ret = goo_comb_window(comb, e1, i, j);
 
-        ret <<= 1;
-        ret |= mpz_tstbit(e, (comb->bits - 1) - b);
-      }
+      if (comb->bases == 2)
+        ret |= goo_comb_window(comb, e2, i, j) << comb->points_per_add;
 
       comb->wins[j][(comb->adds_per_shift - 1) - i] = ret;
     }
@@ -1582,6 +2031,46 @@ goo_comb_recode(goo_comb_t *comb, const mpz_t e) {
   return 1;
 }
 
+static unsigned long
+goo_combspec_ops(const goo_combspec_t *spec, unsigned long walks) {
+  /* Squarings, plus one multiplication per add for each */
+  /* comb walked (two for a comb per base, one if joint). */
+  return spec->shifts - 1 + walks * spec->shifts * spec->adds_per_shift;
+}
+
+static int
+goo_comb_item_init(goo_comb_item_t *item,
+                   goo_group_t *group,
+                   unsigned long bits) {
+  /* Combs for g^e1 * h^e2 with exponents of up to `bits` bits.
+   *
+   * A joint comb of g^i * h^j needs half the multiplications of
+   * a comb per base, but its subcombs are squared in size. It is
+   * used when, within GOO_MAX_JOINT_COMB_SIZE points, it saves at
+   * least an eighth of the operations: for the verifier's comb and
+   * for all but the largest of the signer's.
+   */
+  goo_combspec_t spec, joint;
+
+  if (!goo_combspec_init(&spec, bits, GOO_MAX_COMB_SIZE, 1))
+    return 0;
+
+  item->joint = GOO_MAX_JOINT_COMB_SIZE > 0
+             && goo_combspec_init(&joint, bits, GOO_MAX_JOINT_COMB_SIZE, 2)
+             && goo_combspec_ops(&joint, 1) * 8
+              < goo_combspec_ops(&spec, 2) * 7;
+
+  if (item->joint) {
+    goo_comb_init(&item->g, group, group->g, group->h, &joint);
+    memset(&item->h, 0, sizeof(goo_comb_t));
+  } else {
+    goo_comb_init(&item->g, group, group->g, NULL, &spec);
+    goo_comb_init(&item->h, group, group->h, NULL, &spec);
+  }
+
+  return 1;
+}
+
 /*
  * Group
  */
@@ -1613,6 +2102,8 @@ goo_group_init(goo_group_t *group,
   }
 
   group->combs_len = 0;
+  group->use_mont = 0;
+  group->mtable4 = NULL;
 
   /* Initialize. */
   mpz_set(group->n, n);
@@ -1639,6 +2130,16 @@ goo_group_init(goo_group_t *group,
   goo_sha256_update(&group->sha, GOO_HASH_PREFIX, sizeof(GOO_HASH_PREFIX));
   goo_sha256_update(&group->sha, group->slab, GOO_SHA256_HASH_SIZE);
 
+  /* Use fixed-width arithmetic for the hot path when the modulus fits. */
+  goo_mpz_pad(group->slab, group->size, group->n);
+
+  group->cpu = goo_mont_cpu();
+  group->use_mont = goo_mont_init_cpu(&group->mont, group->slab,
+                                      group->size, group->cpu);
+
+  if (group->use_mont)
+    group->mtable4 = goo_malloc(goo_group_mtable4_size(group));
+
   /* Calculate combs for g^e1 * h^e2 mod n. */
   if (bits != 0) {
     unsigned long big1 = 2 * bits;
@@ -1646,33 +2147,25 @@ goo_group_init(goo_group_t *group,
     unsigned long big = big1 > big2 ? big1 : big2;
     unsigned long big_bits = big + GOO_ELL_BITS + 1;
     unsigned long small_bits = group->rand_bits;
-    goo_combspec_t big_spec, small_spec;
 
     if (bits < GOO_MIN_RSA_BITS || bits > GOO_MAX_RSA_BITS)
       goto fail;
 
-    if (!goo_combspec_init(&big_spec, big_bits, GOO_MAX_COMB_SIZE))
+    if (!goo_comb_item_init(&group->combs[0], group, small_bits))
       goto fail;
 
-    if (!goo_combspec_init(&small_spec, small_bits, GOO_MAX_COMB_SIZE))
-      goto fail;
+    group->combs_len = 1;
 
-    goo_comb_init(&group->combs[0].g, group, group->g, &small_spec);
-    goo_comb_init(&group->combs[0].h, group, group->h, &small_spec);
-    goo_comb_init(&group->combs[1].g, group, group->g, &big_spec);
-    goo_comb_init(&group->combs[1].h, group, group->h, &big_spec);
+    if (!goo_comb_item_init(&group->combs[1], group, big_bits))
+      goto fail;
 
     group->combs_len = 2;
   } else {
     unsigned long tiny_bits = GOO_ELL_BITS;
-    goo_combspec_t tiny_spec;
 
-    if (!goo_combspec_init(&tiny_spec, tiny_bits, GOO_MAX_COMB_SIZE))
+    if (!goo_comb_item_init(&group->combs[0], group, tiny_bits))
       goto fail;
 
-    goo_comb_init(&group->combs[0].g, group, group->g, &tiny_spec);
-    goo_comb_init(&group->combs[0].h, group, group->h, &tiny_spec);
-
     group->combs_len = 1;
   }
 
@@ -1682,6 +2175,56 @@ fail:
   return 0;
 }
 
+static void
+goo_group_clone(goo_group_t *group, const goo_group_t *parent) {
+  size_t i;
+
+  mpz_init(group->n);
+  mpz_init(group->g);
+  mpz_init(group->h);
+  mpz_init(group->nh);
+
+  goo_prng_init(&group->prng);
+
+  for (i = 0; i < GOO_TABLEN; i++) {
+    mpz_init(group->table_p1[i]);
+    mpz_init(group->table_n1[i]);
+    mpz_init(group->table_p2[i]);
+    mpz_init(group->table_n2[i]);
+  }
+
+  mpz_set(group->n, parent->n);
+  mpz_set(group->g, parent->g);
+  mpz_set(group->h, parent->h);
+  mpz_set(group->nh, parent->nh);
+
+  group->bits = parent->bits;
+  group->size = parent->size;
+  group->rand_bits = parent->rand_bits;
+
+  memcpy(&group->sha, &parent->sha, sizeof(goo_sha256_t));
+
+  group->cpu = parent->cpu;
+  group->use_mont = parent->use_mont;
+  group->mtable4 = NULL;
+
+  if (group->use_mont) {
+    memcpy(&group->mont, &parent->mont, sizeof(goo_mont_t));
+    group->mtable4 = goo_malloc(goo_group_mtable4_size(group));
+  }
+
+  for (i = 0; i < parent->combs_len; i++) {
+    group->combs[i].joint = parent->combs[i].joint;
+
+    goo_comb_clone(&group->combs[i].g, &parent->combs[i].g);
+
+    if (!parent->combs[i].joint)
+      goo_comb_clone(&group->combs[i].h, &parent->combs[i].h);
+  }
+
+  group->combs_len = parent->combs_len;
+}
+
 static void
 goo_group_uninit(goo_group_t *group) {
   size_t i;
@@ -1702,10 +2245,15 @@ goo_group_uninit(goo_group_t *group) {
 
   for (i = 0; i < group->combs_len; i++) {
     goo_comb_uninit(&group->combs[i].g);
-    goo_comb_uninit(&group->combs[i].h);
+
+    if (!group->combs[i].joint)
+      goo_comb_uninit(&group->combs[i].h);
   }
 
   group->combs_len = 0;
+
+  goo_free(group->mtable4);
+  group->mtable4 = NULL;
 }
 
 static void
@@ -1722,10 +2270,22 @@ goo_group_cleanse(goo_group_t *group) {
   goo_cleanse(group->wnaf0, sizeof(group->wnaf0));
   goo_cleanse(group->wnaf1, sizeof(group->wnaf1));
   goo_cleanse(group->wnaf2, sizeof(group->wnaf2));
+  goo_cleanse(group->wnaf4, sizeof(group->wnaf4));
+
+  goo_cleanse(group->mtable_p1, sizeof(group->mtable_p1));
+  goo_cleanse(group->mtable_n1, sizeof(group->mtable_n1));
+  goo_cleanse(group->mtable_p2, sizeof(group->mtable_p2));
+  goo_cleanse(group->mtable_n2, sizeof(group->mtable_n2));
+  goo_cleanse(group->macc, sizeof(group->macc));
+
+  if (group->mtable4 != NULL)
+    goo_cleanse(group->mtable4, goo_group_mtable4_size(group));
 
   for (i = 0; i < group->combs_len; i++) {
     goo_comb_cleanse(&group->combs[i].g);
-    goo_comb_cleanse(&group->combs[i].h);
+
+    if (!group->combs[i].joint)
+      goo_comb_cleanse(&group->combs[i].h);
   }
 
   goo_cleanse(group->slab, sizeof(group->slab));
@@ -1770,108 +2330,45 @@ goo_group_inv(goo_group_t *group, mpz_t ret, const mpz_t b) {
 }
 
 static int
-goo_group_inv2(goo_group_t *group,
-               mpz_t r1,
-               mpz_t r2,
-               const mpz_t b1,
-               const mpz_t b2) {
+goo_group_inv_batch(goo_group_t *group,
+                    mpz_ptr *out,
+                    mpz_srcptr *in,
+                    size_t len) {
+  /* out[i] = in[i]^-1 mod n, sharing one inversion between all */
+  /* `len` elements (Montgomery's trick): three multiplications */
+  /* per element. The prefix products are kept in `out`, which */
+  /* must not alias `in`. Fails if any element has no inverse. */
   int r = 0;
-  mpz_ptr b12i = r2;
+  mpz_t acc;
+  size_t i;
 
-  /* b12i = (b1 * b2)^-1 mod n */
-  goo_group_mul(group, b12i, b1, b2);
+  if (len == 0)
+    return 1;
 
-  if (!goo_group_inv(group, b12i, b12i))
-    goto fail;
+  mpz_init(acc);
 
-  /* r1 = b2 * b12i mod n */
-  goo_group_mul(group, r1, b2, b12i);
-  /* r2 = b1 * b12i mod n */
-  goo_group_mul(group, r2, b1, b12i);
+  /* out[i] = in[0] * ... * in[i] mod n */
+  mpz_set(out[0], in[0]);
 
-  r = 1;
-fail:
-  return r;
-}
+  for (i = 1; i < len; i++)
+    goo_group_mul(group, out[i], out[i - 1], in[i]);
 
-static int
-goo_group_inv7(goo_group_t *group,
-               mpz_t r1,
-               mpz_t r2,
-               mpz_t r3,
-               mpz_t r4,
-               mpz_t r5,
-               mpz_t r6,
-               mpz_t r7,
-               const mpz_t b1,
-               const mpz_t b2,
-               const mpz_t b3,
-               const mpz_t b4,
-               const mpz_t b5,
-               const mpz_t b6,
-               const mpz_t b7) {
-  int r = 0;
+  /* acc = (in[0] * ... * in[len - 1])^-1 mod n */
+  if (!goo_group_inv(group, acc, out[len - 1]))
+    goto fail;
 
-  /* Tricky memory management */
-  /* to avoid allocations. */
-  mpz_ptr b12 = r4;
-  mpz_ptr b34 = r2;
-  mpz_ptr b56 = r3;
-  mpz_ptr b1234 = r1;
-  mpz_ptr b123456 = r5;
-  mpz_ptr b1234567 = r7;
-  mpz_ptr b1234567i = r7;
-  mpz_ptr b123456i = r6;
-  mpz_ptr b1234i = r3;
-  mpz_ptr b56i = r1;
-  mpz_ptr b34i = r4;
-  mpz_ptr b12i = r2;
-
-  /* b12 = b1 * b2 mod n */
-  goo_group_mul(group, b12, b1, b2);
-  /* b34 = b3 * b4 mod n */
-  goo_group_mul(group, b34, b3, b4);
-  /* b56 = b5 * b6 mod n */
-  goo_group_mul(group, b56, b5, b6);
-  /* b1234 = b12 * b34 mod n */
-  goo_group_mul(group, b1234, b12, b34);
-  /* b123456 = b1234 * b56 mod n */
-  goo_group_mul(group, b123456, b1234, b56);
-  /* b1234567 = b123456 * b7 mod n */
-  goo_group_mul(group, b1234567, b123456, b7);
-
-  /* b1234567i = b1234567^-1 mod n */
-  if (!goo_group_inv(group, b1234567i, b1234567))
-    goto fail;
-
-  /* b123456i = b1234567i * b7 mod n */
-  goo_group_mul(group, b123456i, b1234567i, b7);
-  /* b1234i = b123456i * b56 mod n */
-  goo_group_mul(group, b1234i, b123456i, b56);
-  /* b56i = b123456i * b1234 mod n */
-  goo_group_mul(group, b56i, b123456i, b1234);
-  /* b34i = b1234i * b12 mod n */
-  goo_group_mul(group, b34i, b1234i, b12);
-  /* b12i = b1234i * b34 mod n */
-  goo_group_mul(group, b12i, b1234i, b34);
-
-  /* r7 = b1234567i * b123456 mod n */
-  goo_group_mul(group, r7, b1234567i, b123456);
-  /* r5 = b56i * b6 mod n */
-  goo_group_mul(group, r5, b56i, b6);
-  /* r6 = b56i * b5 mod n */
-  goo_group_mul(group, r6, b56i, b5);
-  /* r1 = b12i * b2 mod n */
-  goo_group_mul(group, r1, b12i, b2);
-  /* r2 = b12i * b1 mod n */
-  goo_group_mul(group, r2, b12i, b1);
-  /* r3 = b34i * b4 mod n */
-  goo_group_mul(group, r3, b34i, b4);
-  /* r4 = b34i * b3 mod n */
-  goo_group_mul(group, r4, b34i, b3);
+  for (i = len - 1; i > 0; i--) {
+    /* out[i] = acc * out[i - 1] mod n */
+    goo_group_mul(group, out[i], acc, out[i - 1]);
+    /* acc = acc * in[i] mod n */
+    goo_group_mul(group, acc, acc, in[i]);
+  }
+
+  mpz_swap(out[0], acc);
 
   r = 1;
 fail:
+  mpz_clear(acc);
   return r;
 }
 
@@ -1912,8 +2409,8 @@ goo_group_powgh_slow(
 static int
 goo_group_powgh(goo_group_t *group, mpz_t ret, const mpz_t e1, const mpz_t e2) {
   /* Compute g^e1 * h*e2 mod n. */
-  goo_comb_t *gcomb = NULL;
-  goo_comb_t *hcomb = NULL;
+  goo_comb_item_t *item = NULL;
+  goo_comb_t *gcomb, *hcomb;
   unsigned long bits1 = goo_mpz_bitlen(e1);
   unsigned long bits2 = goo_mpz_bitlen(e2);
   unsigned long bits = bits1 > bits2 ? bits1 : bits2;
@@ -1921,41 +2418,80 @@ goo_group_powgh(goo_group_t *group, mpz_t ret, const mpz_t e1, const mpz_t e2) {
 
   for (i = 0; i < (unsigned long)group->combs_len; i++) {
     if (bits <= group->combs[i].g.bits) {
-      gcomb = &group->combs[i].g;
-      hcomb = &group->combs[i].h;
+      item = &group->combs[i];
       break;
     }
   }
 
-  if (gcomb == NULL || hcomb == NULL)
+  if (item == NULL)
     return 0;
 
-  if (!goo_comb_recode(gcomb, e1))
+  gcomb = &item->g;
+  hcomb = item->joint ? NULL : &item->h;
+
+  if (!goo_comb_recode(gcomb, e1, e2))
     return 0;
 
-  if (!goo_comb_recode(hcomb, e2))
+  if (hcomb != NULL && !goo_comb_recode(hcomb, e2, NULL))
     return 0;
 
-  mpz_set_ui(ret, 1);
+  /* A joint comb multiplies in g^u * h^v with a */
+  /* single point, so `hcomb` is only walked when */
+  /* the bases have combs of their own. */
+  if (group->use_mont) {
+    goo_mont_t *mont = &group->mont;
+    goo_limb_t *acc = group->macc;
+    size_t limbs = mont->limbs;
 
-  for (i = 0; i < gcomb->shifts; i++) {
-    unsigned long *us = gcomb->wins[i];
-    unsigned long *vs = hcomb->wins[i];
-    unsigned long j;
+    goo_mont_set_one(mont, acc);
 
-    if (i != 0)
+    for (i = 0; i < gcomb->shifts; i++) {
+      unsigned long *us = gcomb->wins[i];
+      unsigned long j;
+
+      if (i != 0)
+        goo_mont_sqr(mont, acc, acc);
+
+      for (j = 0; j < gcomb->adds_per_shift; j++) {
+        unsigned long u = us[j];
+
+        if (u != 0) {
+          unsigned long k = j * gcomb->points_per_subcomb + u - 1;
+          goo_mont_mul(mont, acc, acc, &gcomb->mitems[k * limbs]);
+        }
+
+        if (hcomb != NULL && hcomb->wins[i][j] != 0) {
+          unsigned long v = hcomb->wins[i][j];
+          unsigned long k = j * hcomb->points_per_subcomb + v - 1;
+          goo_mont_mul(mont, acc, acc, &hcomb->mitems[k * limbs]);
+        }
+      }
+    }
+
+    goo_group_mont_get(group, ret, acc);
+
+    return 1;
+  }
+
+  mpz_set_ui(ret, 1);
+
+  for (i = 0; i < gcomb->shifts; i++) {
+    unsigned long *us = gcomb->wins[i];
+    unsigned long j;
+
+    if (i != 0)
       goo_group_sqr(group, ret, ret);
 
     for (j = 0; j < gcomb->adds_per_shift; j++) {
       unsigned long u = us[j];
-      unsigned long v = vs[j];
 
       if (u != 0) {
         mpz_t *g = &gcomb->items[j * gcomb->points_per_subcomb + u - 1];
         goo_group_mul(group, ret, ret, *g);
       }
 
-      if (v != 0) {
+      if (hcomb != NULL && hcomb->wins[i][j] != 0) {
+        unsigned long v = hcomb->wins[i][j];
         mpz_t *h = &hcomb->items[j * hcomb->points_per_subcomb + v - 1];
         goo_group_mul(group, ret, ret, *h);
       }
@@ -1988,6 +2524,48 @@ goo_group_precomp_wnaf(goo_group_t *group,
   goo_group_precomp_table(group, n, bi);
 }
 
+static void
+goo_group_precomp_mont(goo_group_t *group, goo_limb_t *out, const mpz_t b) {
+  goo_mont_t *mont = &group->mont;
+  size_t limbs = mont->limbs;
+  goo_limb_t *b2 = &out[(GOO_TABLEN - 1) * limbs];
+  size_t i;
+
+  goo_group_mont_set(group, &out[0], b);
+  goo_mont_sqr(mont, b2, &out[0]);
+
+  for (i = 1; i < GOO_TABLEN; i++)
+    goo_mont_mul(mont, &out[i * limbs], &out[(i - 1) * limbs], b2);
+}
+
+static void
+goo_group_precomp_mont4(goo_group_t *group, goo_limb_t *out, mpz_srcptr *b) {
+  goo_mont_t *mont = &group->mont;
+  size_t words = goo_mont4_words(mont);
+  goo_limb_t *b2 = &out[(GOO_TABLEN - 1) * words];
+  size_t i;
+
+  goo_group_mont4_set(group, &out[0], b);
+  goo_mont4_sqr(mont, b2, &out[0]);
+
+  for (i = 1; i < GOO_TABLEN; i++)
+    goo_mont4_mul(mont, &out[i * words], &out[(i - 1) * words], b2);
+}
+
+static void
+goo_group_one_mul_mont(goo_group_t *group,
+                       goo_limb_t *ret,
+                       long w,
+                       const goo_limb_t *p,
+                       const goo_limb_t *n) {
+  size_t limbs = group->mont.limbs;
+
+  if (w > 0)
+    goo_mont_mul(&group->mont, ret, ret, &p[((w - 1) >> 1) * limbs]);
+  else if (w < 0)
+    goo_mont_mul(&group->mont, ret, ret, &n[((-1 - w) >> 1) * limbs]);
+}
+
 static void
 goo_group_wnaf(goo_group_t *group,
                long *out,
@@ -2028,6 +2606,41 @@ goo_group_wnaf(goo_group_t *group,
   mpz_clear(e);
 }
 
+static void
+goo_group_window(goo_group_t *group,
+                 long *out,
+                 const mpz_t exp,
+                 unsigned long bits) {
+  /* Sliding windows with positive digits only: the same odd digits
+     as the wnaf (up to 2 * GOO_TABLEN - 1), so the `p` tables serve
+     both, but no inverse of the base is needed. */
+  long mask = 2 * GOO_TABLEN - 1;
+  long i;
+  mpz_t e;
+
+  (void)group;
+
+  mpz_init(e);
+  mpz_set(e, exp);
+
+  for (i = (long)bits - 1; i >= 0; i--) {
+    long val = 0;
+
+    if (mpz_odd_p(e)) {
+      val = mpz_getlimbn(e, 0) & mask;
+      mpz_sub_ui(e, e, val);
+    }
+
+    out[i] = val;
+
+    mpz_tdiv_q_2exp(e, e, 1);
+  }
+
+  assert(mpz_sgn(e) == 0);
+
+  mpz_clear(e);
+}
+
 static void
 goo_group_one_mul(goo_group_t *group, mpz_t ret, long w, mpz_t *p, mpz_t *n) {
   if (w > 0)
@@ -2068,9 +2681,33 @@ goo_group_pow(goo_group_t *group,
   if (mpz_sgn(e) < 0)
     return 0;
 
-  goo_group_precomp_wnaf(group, p, n, b, bi);
   goo_group_wnaf(group, group->wnaf0, e, bits);
 
+  if (group->use_mont) {
+    goo_limb_t *acc = group->macc;
+
+    goo_group_precomp_mont(group, group->mtable_p1, b);
+    goo_group_precomp_mont(group, group->mtable_n1, bi);
+
+    goo_mont_set_one(&group->mont, acc);
+
+    for (i = 0; i < bits; i++) {
+      long w = group->wnaf0[i];
+
+      if (i != 0)
+        goo_mont_sqr(&group->mont, acc, acc);
+
+      goo_group_one_mul_mont(group, acc, w, group->mtable_p1,
+                                            group->mtable_n1);
+    }
+
+    goo_group_mont_get(group, ret, acc);
+
+    return 1;
+  }
+
+  goo_group_precomp_wnaf(group, p, n, b, bi);
+
   mpz_set_ui(ret, 1);
 
   for (i = 0; i < bits; i++) {
@@ -2128,7 +2765,8 @@ goo_group_pow2(goo_group_t *group,
                const mpz_t b2,
                const mpz_t b2i,
                const mpz_t e2) {
-  /* Compute b1^e1 * b2^e2 mod n. */
+  /* Compute b1^e1 * b2^e2 mod n. If `b1i` is NULL, e1 is recoded */
+  /* with positive windows and no inverse of b1 is needed. */
   mpz_t *p1 = &group->table_p1[0];
   mpz_t *n1 = &group->table_n1[0];
   mpz_t *p2 = &group->table_p2[0];
@@ -2144,12 +2782,50 @@ goo_group_pow2(goo_group_t *group,
   if (mpz_sgn(e1) < 0 || mpz_sgn(e2) < 0)
     return 0;
 
-  goo_group_precomp_wnaf(group, p1, n1, b1, b1i);
-  goo_group_precomp_wnaf(group, p2, n2, b2, b2i);
+  if (b1i != NULL)
+    goo_group_wnaf(group, group->wnaf1, e1, bits);
+  else
+    goo_group_window(group, group->wnaf1, e1, bits);
 
-  goo_group_wnaf(group, group->wnaf1, e1, bits);
   goo_group_wnaf(group, group->wnaf2, e2, bits);
 
+  if (group->use_mont) {
+    goo_limb_t *acc = group->macc;
+
+    goo_group_precomp_mont(group, group->mtable_p1, b1);
+
+    if (b1i != NULL)
+      goo_group_precomp_mont(group, group->mtable_n1, b1i);
+    goo_group_precomp_mont(group, group->mtable_p2, b2);
+    goo_group_precomp_mont(group, group->mtable_n2, b2i);
+
+    goo_mont_set_one(&group->mont, acc);
+
+    for (i = 0; i < bits; i++) {
+      long w1 = group->wnaf1[i];
+      long w2 = group->wnaf2[i];
+
+      if (i != 0)
+        goo_mont_sqr(&group->mont, acc, acc);
+
+      goo_group_one_mul_mont(group, acc, w1, group->mtable_p1,
+                                             group->mtable_n1);
+      goo_group_one_mul_mont(group, acc, w2, group->mtable_p2,
+                                             group->mtable_n2);
+    }
+
+    goo_group_mont_get(group, ret, acc);
+
+    return 1;
+  }
+
+  if (b1i != NULL)
+    goo_group_precomp_wnaf(group, p1, n1, b1, b1i);
+  else
+    goo_group_precomp_table(group, p1, b1);
+
+  goo_group_precomp_wnaf(group, p2, n2, b2, b2i);
+
   mpz_set_ui(ret, 1);
 
   for (i = 0; i < bits; i++) {
@@ -2167,40 +2843,148 @@ goo_group_pow2(goo_group_t *group,
 }
 
 static int
-goo_group_recover(goo_group_t *group,
-                  mpz_t ret,
-                  const mpz_t b1,
-                  const mpz_t b1i,
-                  const mpz_t e1,
-                  const mpz_t b2,
-                  const mpz_t b2i,
-                  const mpz_t e2,
-                  const mpz_t e3,
-                  const mpz_t e4) {
-  /* Compute b1^e1 * g^e3 * h^e4 / b2^e2 mod n. */
+goo_group_pow2x4(goo_group_t *group,
+                 mpz_t *ret,
+                 mpz_srcptr *b1,
+                 const mpz_t e1,
+                 mpz_srcptr *b2,
+                 mpz_srcptr *b2i,
+                 mpz_srcptr *e2) {
+  /* Compute b1[j]^e1 * b2[j]^e2[j] mod n for four lanes at once.
+   *
+   * The shared exponent e1 is recoded once, with positive windows so
+   * that b1 needs no inverse, and each of its digits multiplies every
+   * lane by the same table entry. The four chains run in lockstep
+   * through the goo_mont4 kernels.
+   */
+  goo_mont_t *mont = &group->mont;
+  size_t words, bits;
+  goo_limb_t *p1, *p2, *n2, *acc;
+  size_t i, j;
+
+  if (!group->use_mont) {
+    for (j = 0; j < 4; j++) {
+      if (!goo_group_pow2(group, ret[j], b1[j], NULL, e1,
+                                         b2[j], b2i[j], e2[j])) {
+        return 0;
+      }
+    }
+
+    return 1;
+  }
+
+  if (mpz_sgn(e1) < 0)
+    return 0;
+
+  bits = goo_mpz_bitlen(e1);
+
+  for (j = 0; j < 4; j++) {
+    if (mpz_sgn(e2[j]) < 0)
+      return 0;
+
+    if (goo_mpz_bitlen(e2[j]) > bits)
+      bits = goo_mpz_bitlen(e2[j]);
+  }
+
+  bits += 1;
+
+  if (bits > GOO_ELL_BITS + 1)
+    return 0;
+
+  goo_group_window(group, group->wnaf1, e1, bits);
+
+  for (j = 0; j < 4; j++)
+    goo_group_wnaf(group, group->wnaf4[j], e2[j], bits);
+
+  words = goo_mont4_words(mont);
+  p1 = group->mtable4;
+  p2 = p1 + GOO_TABLEN * words;
+  n2 = p2 + GOO_TABLEN * words;
+  acc = n2 + GOO_TABLEN * words;
+
+  goo_group_precomp_mont4(group, p1, b1);
+  goo_group_precomp_mont4(group, p2, b2);
+  goo_group_precomp_mont4(group, n2, b2i);
+
+  goo_mont4_set_one(mont, acc);
+
+  for (i = 0; i < bits; i++) {
+    long w = group->wnaf1[i];
+    const goo_limb_t *lanes[4];
+    int any = 0;
+
+    if (i != 0)
+      goo_mont4_sqr(mont, acc, acc);
+
+    if (w != 0)
+      goo_mont4_mul(mont, acc, acc, &p1[((w - 1) >> 1) * words]);
+
+    for (j = 0; j < 4; j++) {
+      w = group->wnaf4[j][i];
+
+      if (w > 0)
+        lanes[j] = &p2[((w - 1) >> 1) * words];
+      else if (w < 0)
+        lanes[j] = &n2[((-1 - w) >> 1) * words];
+      else
+        lanes[j] = NULL;
+
+      any |= (w != 0);
+    }
+
+    if (any)
+      goo_mont4_mul_lanes(mont, acc, acc, lanes);
+  }
+
+  goo_group_mont4_get(group, ret, acc);
+
+  return 1;
+}
+
+static int
+goo_group_recover4(goo_group_t *group,
+                   mpz_ptr *ret,
+                   mpz_srcptr *b1,
+                   const mpz_t e1,
+                   mpz_srcptr *b2,
+                   mpz_srcptr *b2i,
+                   mpz_srcptr *e2,
+                   mpz_srcptr *e3,
+                   mpz_srcptr *e4) {
+  /* Compute b1[j]^e1 * g^e3[j] * h^e4[j] / b2[j]^e2[j] mod n. */
   int r = 0;
-  mpz_t a;
-  mpz_ptr b = ret;
+  mpz_t a[4];
+  size_t j;
 
-  mpz_init(a);
+  GOO_PROBE1(recover__entry, group->bits);
 
-  /* a = b1^e1 / b2^e2 mod n */
-  if (!goo_group_pow2(group, a, b1, b1i, e1, b2i, b2, e2))
-    goto fail;
+  for (j = 0; j < 4; j++)
+    mpz_init(a[j]);
 
-  /* b = g^e3 * h^e4 mod n */
-  if (!goo_group_powgh(group, b, e3, e4))
+  /* a[j] = b1[j]^e1 / b2[j]^e2[j] mod n */
+  if (!goo_group_pow2x4(group, a, b1, e1, b2i, b2, e2))
     goto fail;
 
-  /* ret = a * b mod n */
-  goo_group_mul(group, ret, a, b);
+  for (j = 0; j < 4; j++) {
+    mpz_ptr b = ret[j];
 
-  /* ret = n - ret if ret > n / 2 */
-  goo_group_reduce(group, ret, ret);
+    /* b = g^e3 * h^e4 mod n */
+    if (!goo_group_powgh(group, b, e3[j], e4[j]))
+      goto fail;
+
+    /* ret = a * b mod n */
+    goo_group_mul(group, ret[j], a[j], b);
+
+    /* ret = n - ret if ret > n / 2 */
+    goo_group_reduce(group, ret[j], ret[j]);
+  }
 
   r = 1;
 fail:
-  mpz_clear(a);
+  for (j = 0; j < 4; j++)
+    mpz_clear(a[j]);
+
+  GOO_PROBE2(recover__return, group->bits, r);
   return r;
 }
 
@@ -2275,14 +3059,21 @@ goo_group_derive(goo_group_t *group,
                  const mpz_t E,
                  const unsigned char *msg,
                  size_t msg_len) {
+  int r = 0;
+
+  GOO_PROBE1(derive__entry, group->bits);
+
   if (!goo_group_hash(group, key, C1, C2, C3, t, A, B, C, D, E, msg, msg_len))
-    return 0;
+    goto fail;
 
   goo_prng_seed(&group->prng, key, GOO_PRNG_DERIVE);
   goo_prng_random_bits(&group->prng, chal, GOO_CHAL_BITS);
   goo_prng_random_bits(&group->prng, ell, GOO_ELL_BITS);
 
-  return 1;
+  r = 1;
+fail:
+  GOO_PROBE2(derive__return, group->bits, r);
+  return r;
 }
 
 static void
@@ -2440,179 +3231,370 @@ fail:
   return r;
 }
 
-static int
-goo_group_sign(goo_group_t *group,
-               goo_sig_t *S,
-               const unsigned char *msg,
-               size_t msg_len,
-               const unsigned char *s_prime,
-               const mpz_t p,
-               const mpz_t q) {
-  int r = 0;
-  int found;
-  unsigned long primes[GOO_PRIMES_LEN];
-  unsigned char key[GOO_SHA256_HASH_SIZE];
-  goo_prng_t prng;
-  unsigned long i;
+static void
+goo_signer_init(goo_signer_t *S) {
+  size_t i;
 
-  mpz_t n, s, C1, w, a, s1, s2;
-  mpz_t t1, t2, t3, t4, t5;
-  mpz_t C1i, C2i;
-  mpz_t r_w, r_w2, r_s1, r_a, r_an, r_s1w, r_sa, r_s2;
-  mpz_t A, B, C, D, E;
+  mpz_init(S->gn);
+  mpz_init(S->gg);
+  mpz_init(S->gh);
+  mpz_init(S->p);
+  mpz_init(S->q);
+  mpz_init(S->n);
+  mpz_init(S->s);
+  mpz_init(S->C1);
+  mpz_init(S->C1i);
 
-  mpz_t *C2 = &S->C2;
-  mpz_t *C3 = &S->C3;
-  mpz_t *t = &S->t;
-  mpz_t *chal = &S->chal;
-  mpz_t *ell = &S->ell;
-  mpz_t *Aq = &S->Aq;
-  mpz_t *Bq = &S->Bq;
-  mpz_t *Cq = &S->Cq;
-  mpz_t *Dq = &S->Dq;
-  mpz_t *Eq = &S->Eq;
-  mpz_t *z_w = &S->z_w;
-  mpz_t *z_w2 = &S->z_w2;
-  mpz_t *z_s1 = &S->z_s1;
-  mpz_t *z_a = &S->z_a;
-  mpz_t *z_an = &S->z_an;
-  mpz_t *z_s1w = &S->z_s1w;
-  mpz_t *z_sa = &S->z_sa;
-  mpz_t *z_s2 = &S->z_s2;
+  memset(S->s_prime, 0, sizeof(S->s_prime));
 
-  goo_prng_init(&prng);
+  S->qr = goo_calloc(GOO_PRIMES_LEN, sizeof(signed char));
+  S->w = goo_calloc(GOO_PRIMES_LEN, sizeof(mpz_t));
+  S->a = goo_calloc(GOO_PRIMES_LEN, sizeof(mpz_t));
 
-  mpz_init(n);
-  mpz_init(s);
-  mpz_init(C1);
-  mpz_init(w);
-  mpz_init(a);
-  mpz_init(s1);
-  mpz_init(s2);
-  mpz_init(t1);
-  mpz_init(t2);
-  mpz_init(t3);
-  mpz_init(t4);
-  mpz_init(t5);
-  mpz_init(C1i);
-  mpz_init(C2i);
-  mpz_init(r_w);
-  mpz_init(r_w2);
-  mpz_init(r_s1);
-  mpz_init(r_a);
-  mpz_init(r_an);
-  mpz_init(r_s1w);
-  mpz_init(r_sa);
-  mpz_init(r_s2);
-  mpz_init(A);
-  mpz_init(B);
-  mpz_init(C);
-  mpz_init(D);
-  mpz_init(E);
+  for (i = 0; i < GOO_PRIMES_LEN; i++) {
+    mpz_init(S->w[i]);
+    mpz_init(S->a[i]);
+  }
+}
+
+static void
+goo_signer_uninit(goo_signer_t *S) {
+  size_t i;
+
+  mpz_clear(S->gn);
+  mpz_clear(S->gg);
+  mpz_clear(S->gh);
+  goo_mpz_clear(S->p);
+  goo_mpz_clear(S->q);
+  goo_mpz_clear(S->n);
+  goo_mpz_clear(S->s);
+  goo_mpz_clear(S->C1);
+  goo_mpz_clear(S->C1i);
+
+  for (i = 0; i < GOO_PRIMES_LEN; i++) {
+    goo_mpz_clear(S->w[i]);
+    goo_mpz_clear(S->a[i]);
+  }
+
+  goo_cleanse(S->s_prime, sizeof(S->s_prime));
+  goo_cleanse(S->qr, GOO_PRIMES_LEN * sizeof(signed char));
+
+  goo_free(S->qr);
+  goo_free(S->w);
+  goo_free(S->a);
+
+  S->qr = NULL;
+  S->w = NULL;
+  S->a = NULL;
+}
+
+static int
+goo_group_equal(goo_group_t *group,
+                const mpz_t n,
+                const mpz_t g,
+                const mpz_t h) {
+  return mpz_cmp(group->n, n) == 0
+      && mpz_cmp(group->g, g) == 0
+      && mpz_cmp(group->h, h) == 0;
+}
+
+static int
+goo_group_signer(goo_group_t *group,
+                 goo_signer_t *S,
+                 const unsigned char *s_prime,
+                 const mpz_t p,
+                 const mpz_t q) {
+  int r = 0;
+
+  mpz_set(S->gn, group->n);
+  mpz_set(S->gg, group->g);
+  mpz_set(S->gh, group->h);
 
   if (!goo_is_valid_prime(p) || !goo_is_valid_prime(q)) {
     /* Invalid RSA public key. */
     goto fail;
   }
 
-  mpz_mul(n, p, q);
+  mpz_mul(S->n, p, q);
 
-  if (!goo_is_valid_modulus(n)) {
+  if (!goo_is_valid_modulus(S->n)) {
     /* Invalid RSA public key. */
     goto fail;
   }
 
-  /* Seed the PRNG using the primes and message as entropy. */
-  if (!goo_prng_seed_sign(&prng, p, q, s_prime, msg, msg_len, group->slab))
+  mpz_set(S->p, p);
+  mpz_set(S->q, q);
+  memcpy(S->s_prime, s_prime, 32);
+
+  /* Commit to `n` with:
+   *
+   *   C1 = g^n * h^s in G
+   *
+   * Where `s` is expanded from `s_prime`.
+   */
+  goo_group_expand_sprime(group, S->s, s_prime);
+
+  if (!goo_group_powgh(group, S->C1, S->n, S->s))
     goto fail;
 
-  /* Find a small quadratic residue prime `t`. */
-  found = 0;
+  goo_group_reduce(group, S->C1, S->C1);
 
-  memcpy(primes, goo_primes, sizeof(goo_primes));
+  /* The inverse of `C1` is left to the first presignature, */
+  /* which computes it along with that of its `C2`. */
+  mpz_set_ui(S->C1i, 0);
 
-  for (i = 0; i < GOO_PRIMES_LEN; i++) {
-    /* Fisher-Yates shuffle to choose random `t`. */
-    unsigned long j = goo_prng_random_num(&prng, GOO_PRIMES_LEN - i);
+  r = 1;
+fail:
+  goo_group_cleanse(group);
+  return r;
+}
+
+static int
+goo_signer_sqrt(goo_signer_t *S, size_t index) {
+  /* Find `w` and `a` for t = goo_primes[index]. */
+  int r = 0;
+  mpz_t t, t1, t2;
 
-    goo_swap(&primes[i], &primes[i + j]);
+  if (S->qr[index] != 0)
+    return S->qr[index] > 0;
 
-    mpz_set_ui(*t, primes[i]);
+  mpz_init(t);
+  mpz_init(t1);
+  mpz_init(t2);
 
-    /* w = t^(1 / 2) in F(p * q) */
-    if (goo_mpz_sqrtpq(w, *t, p, q)) {
-      found = 1;
-      break;
-    }
-  }
+  mpz_set_ui(t, goo_primes[index]);
 
-  if (!found) {
-    /* No prime quadratic residue less than `1000 mod n`! */
+  /* w = t^(1 / 2) in F(p * q) */
+  if (!goo_mpz_sqrtpq(S->w[index], t, S->p, S->q)) {
+    S->qr[index] = -1;
     goto fail;
   }
 
-  assert(mpz_sgn(w) > 0);
+  assert(mpz_sgn(S->w[index]) > 0);
 
   /* a = (w^2 - t) / n */
-  mpz_mul(a, w, w);
-  mpz_sub(a, a, *t);
-  mpz_fdiv_q(a, a, n);
+  mpz_mul(S->a[index], S->w[index], S->w[index]);
+  mpz_sub(S->a[index], S->a[index], t);
+  mpz_fdiv_q(S->a[index], S->a[index], S->n);
 
-  assert(mpz_sgn(a) >= 0);
+  assert(mpz_sgn(S->a[index]) >= 0);
 
   /* `w` and `a` must satisfy `w^2 = t + a * n`. */
-  mpz_mul(t1, a, n);
-  mpz_mul(t2, w, w);
-  mpz_sub(t2, t2, *t);
+  mpz_mul(t1, S->a[index], S->n);
+  mpz_mul(t2, S->w[index], S->w[index]);
+  mpz_sub(t2, t2, t);
 
   if (mpz_cmp(t1, t2) != 0) {
     /* `w^2 - t` was not divisible by `n`! */
     goto fail;
   }
 
-  /* Commit to `n`, `w`, and `a` with:
-   *
-   *   C1 = g^n * h^s in G
-   *   C2 = g^w * h^s1 in G
-   *   C3 = g^a * h^s2 in G
-   *
-   * Where `s`, `s1`, and `s2` are
-   * random 2048-bit integers.
-   */
-  goo_group_expand_sprime(group, s, s_prime);
+  S->qr[index] = 1;
 
-  if (!goo_group_powgh(group, C1, n, s))
+  r = 1;
+fail:
+  mpz_clear(t);
+  goo_mpz_clear(t1);
+  goo_mpz_clear(t2);
+  return r;
+}
+
+static void
+goo_presig_init(goo_presig_t *P) {
+  P->used = 0;
+
+  goo_prng_init(&P->prng);
+
+  mpz_init(P->gn);
+  mpz_init(P->gg);
+  mpz_init(P->gh);
+  mpz_init(P->n);
+  mpz_init(P->s);
+  mpz_init(P->C1);
+  mpz_init(P->w);
+  mpz_init(P->a);
+  mpz_init(P->s1);
+  mpz_init(P->s2);
+  mpz_init(P->t);
+  mpz_init(P->C2);
+  mpz_init(P->C3);
+  mpz_init(P->C1i);
+  mpz_init(P->C2i);
+  mpz_init(P->r_w);
+  mpz_init(P->r_w2);
+  mpz_init(P->r_s1);
+  mpz_init(P->r_a);
+  mpz_init(P->r_an);
+  mpz_init(P->r_s1w);
+  mpz_init(P->r_sa);
+  mpz_init(P->r_s2);
+  mpz_init(P->A);
+  mpz_init(P->B);
+  mpz_init(P->C);
+  mpz_init(P->D);
+  mpz_init(P->E);
+}
+
+static void
+goo_presig_uninit(goo_presig_t *P) {
+  goo_prng_uninit(&P->prng);
+
+  mpz_clear(P->gn);
+  mpz_clear(P->gg);
+  mpz_clear(P->gh);
+  goo_mpz_clear(P->n);
+  goo_mpz_clear(P->s);
+  goo_mpz_clear(P->C1);
+  goo_mpz_clear(P->w);
+  goo_mpz_clear(P->a);
+  goo_mpz_clear(P->s1);
+  goo_mpz_clear(P->s2);
+  goo_mpz_clear(P->t);
+  goo_mpz_clear(P->C2);
+  goo_mpz_clear(P->C3);
+  goo_mpz_clear(P->C1i);
+  goo_mpz_clear(P->C2i);
+  goo_mpz_clear(P->r_w);
+  goo_mpz_clear(P->r_w2);
+  goo_mpz_clear(P->r_s1);
+  goo_mpz_clear(P->r_a);
+  goo_mpz_clear(P->r_an);
+  goo_mpz_clear(P->r_s1w);
+  goo_mpz_clear(P->r_sa);
+  goo_mpz_clear(P->r_s2);
+  goo_mpz_clear(P->A);
+  goo_mpz_clear(P->B);
+  goo_mpz_clear(P->C);
+  goo_mpz_clear(P->D);
+  goo_mpz_clear(P->E);
+
+  goo_cleanse(&P->prng, sizeof(goo_prng_t));
+
+  P->used = 1;
+}
+
+static int
+goo_group_presign(goo_group_t *group,
+                  goo_presig_t *P,
+                  goo_signer_t *K,
+                  const unsigned char *entropy,
+                  size_t entropy_len) {
+  int r = 0;
+  int found;
+  unsigned long order[GOO_PRIMES_LEN];
+  unsigned long i;
+  mpz_t t1, t2;
+
+  mpz_init(t1);
+  mpz_init(t2);
+
+  /* The key must have been prepared in this group. */
+  if (!goo_group_equal(group, K->gn, K->gg, K->gh))
     goto fail;
 
-  goo_group_reduce(group, C1, C1);
+  /* Remember which group we belong to. */
+  mpz_set(P->gn, group->n);
+  mpz_set(P->gg, group->g);
+  mpz_set(P->gh, group->h);
+
+  mpz_set(P->n, K->n);
+  mpz_set(P->s, K->s);
+  mpz_set(P->C1, K->C1);
+
+  /* Seed the PRNG using the primes and message (or */
+  /* caller-provided entropy when presigning). */
+  if (!goo_prng_seed_sign(&P->prng, K->p, K->q, K->s_prime,
+                          entropy, entropy_len, group->slab)) {
+    goto fail;
+  }
+
+  /* Find a small quadratic residue prime `t`. */
+  found = 0;
+
+  for (i = 0; i < GOO_PRIMES_LEN; i++)
+    order[i] = i;
+
+  for (i = 0; i < GOO_PRIMES_LEN; i++) {
+    /* Fisher-Yates shuffle to choose random `t`. */
+    unsigned long j = goo_prng_random_num(&P->prng, GOO_PRIMES_LEN - i);
+
+    goo_swap(&order[i], &order[i + j]);
+
+    /* w = t^(1 / 2) in F(p * q) */
+    if (goo_signer_sqrt(K, order[i])) {
+      found = 1;
+      break;
+    }
 
-  goo_group_random_scalar(group, &prng, s1);
+    if (K->qr[order[i]] == 0) {
+      /* `w^2 - t` was not divisible by `n`! */
+      goto fail;
+    }
+  }
 
-  if (!goo_group_powgh(group, *C2, w, s1))
+  if (!found) {
+    /* No prime quadratic residue less than `1000 mod n`! */
     goto fail;
+  }
 
-  goo_group_reduce(group, *C2, *C2);
+  mpz_set_ui(P->t, goo_primes[order[i]]);
+  mpz_set(P->w, K->w[order[i]]);
+  mpz_set(P->a, K->a[order[i]]);
 
-  goo_group_random_scalar(group, &prng, s2);
+  /* Commit to `w` and `a` with:
+   *
+   *   C2 = g^w * h^s1 in G
+   *   C3 = g^a * h^s2 in G
+   *
+   * Where `s1` and `s2` are
+   * random 2048-bit integers.
+   */
+  goo_group_random_scalar(group, &P->prng, P->s1);
 
-  if (!goo_group_powgh(group, *C3, a, s2))
+  if (!goo_group_powgh(group, P->C2, P->w, P->s1))
     goto fail;
 
-  goo_group_reduce(group, *C3, *C3);
+  goo_group_reduce(group, P->C2, P->C2);
+
+  goo_group_random_scalar(group, &P->prng, P->s2);
 
-  /* Inverses of `C1` and `C2`. */
-  if (!goo_group_inv2(group, C1i, C2i, C1, *C2))
+  if (!goo_group_powgh(group, P->C3, P->a, P->s2))
     goto fail;
 
+  goo_group_reduce(group, P->C3, P->C3);
+
+  /* Inverse of `C2`, and of `C1` the first time */
+  /* this signer is used. */
+  if (mpz_sgn(K->C1i) == 0) {
+    mpz_srcptr in[2];
+    mpz_ptr out[2];
+
+    in[0] = K->C1;
+    in[1] = P->C2;
+
+    out[0] = K->C1i;
+    out[1] = P->C2i;
+
+    if (!goo_group_inv_batch(group, out, in, 2)) {
+      mpz_set_ui(K->C1i, 0);
+      goto fail;
+    }
+  } else {
+    if (!goo_group_inv(group, P->C2i, P->C2))
+      goto fail;
+  }
+
+  mpz_set(P->C1i, K->C1i);
+
   /* Eight random 2048-bit integers: */
   /*   r_w, r_w2, r_s1, r_a, r_an, r_s1w, r_sa, r_s2 */
-  goo_group_random_scalar(group, &prng, r_w);
-  goo_group_random_scalar(group, &prng, r_w2);
-  goo_group_random_scalar(group, &prng, r_a);
-  goo_group_random_scalar(group, &prng, r_an);
-  goo_group_random_scalar(group, &prng, r_s1w);
-  goo_group_random_scalar(group, &prng, r_sa);
-  goo_group_random_scalar(group, &prng, r_s2);
+  goo_group_random_scalar(group, &P->prng, P->r_w);
+  goo_group_random_scalar(group, &P->prng, P->r_w2);
+  goo_group_random_scalar(group, &P->prng, P->r_a);
+  goo_group_random_scalar(group, &P->prng, P->r_an);
+  goo_group_random_scalar(group, &P->prng, P->r_s1w);
+  goo_group_random_scalar(group, &P->prng, P->r_sa);
+  goo_group_random_scalar(group, &P->prng, P->r_s2);
 
   /* Compute:
    *
@@ -2622,50 +3604,113 @@ goo_group_sign(goo_group_t *group,
    *   D = g^r_an * h^r_sa / C1^r_a in G
    *   E = r_w2 - r_an
    *
-   * `A` must be recomputed until a prime
-   * `ell` is found within range.
+   * None of these depend on the message. `A` is
+   * only a first attempt: it must be recomputed
+   * (online) until a prime `ell` is found within
+   * range.
    */
-  if (!goo_group_powgh(group, B, r_a, r_s2))
+  if (!goo_group_powgh(group, P->B, P->r_a, P->r_s2))
     goto fail;
 
-  goo_group_reduce(group, B, B);
+  goo_group_reduce(group, P->B, P->B);
 
-  goo_group_pow(group, t1, C2i, *C2, r_w);
+  goo_group_pow(group, t1, P->C2i, P->C2, P->r_w);
 
-  if (!goo_group_powgh(group, t2, r_w2, r_s1w))
+  if (!goo_group_powgh(group, t2, P->r_w2, P->r_s1w))
     goto fail;
 
-  goo_group_mul(group, C, t1, t2);
-  goo_group_reduce(group, C, C);
+  goo_group_mul(group, P->C, t1, t2);
+  goo_group_reduce(group, P->C, P->C);
 
-  goo_group_pow(group, t1, C1i, C1, r_a);
+  goo_group_pow(group, t1, P->C1i, P->C1, P->r_a);
 
-  if (!goo_group_powgh(group, t2, r_an, r_sa))
+  if (!goo_group_powgh(group, t2, P->r_an, P->r_sa))
     goto fail;
 
-  goo_group_mul(group, D, t1, t2);
-  goo_group_reduce(group, D, D);
+  goo_group_mul(group, P->D, t1, t2);
+  goo_group_reduce(group, P->D, P->D);
+
+  mpz_sub(P->E, P->r_w2, P->r_an);
 
-  mpz_sub(E, r_w2, r_an);
+  goo_group_random_scalar(group, &P->prng, P->r_s1);
 
-  mpz_set_ui(*ell, 0);
+  if (!goo_group_powgh(group, P->A, P->r_w, P->r_s1))
+    goto fail;
 
-  while (goo_mpz_bitlen(*ell) != GOO_ELL_BITS) {
-    goo_group_random_scalar(group, &prng, r_s1);
+  goo_group_reduce(group, P->A, P->A);
 
-    if (!goo_group_powgh(group, A, r_w, r_s1))
-      goto fail;
+  r = 1;
+fail:
+  goo_mpz_clear(t1);
+  goo_mpz_clear(t2);
+  goo_cleanse(order, sizeof(order));
+  goo_cleanse(&i, sizeof(i));
+  goo_group_cleanse(group);
+  return r;
+}
+
+static int
+goo_group_sign_presig(goo_group_t *group,
+                      goo_sig_t *S,
+                      goo_presig_t *P,
+                      const unsigned char *msg,
+                      size_t msg_len) {
+  int r = 0;
+  unsigned char key[GOO_SHA256_HASH_SIZE];
+  mpz_t t1, t2, t3, t4, t5;
+
+  mpz_t *chal = &S->chal;
+  mpz_t *ell = &S->ell;
+  mpz_t *Aq = &S->Aq;
+  mpz_t *Bq = &S->Bq;
+  mpz_t *Cq = &S->Cq;
+  mpz_t *Dq = &S->Dq;
+  mpz_t *Eq = &S->Eq;
+  mpz_t *z_w = &S->z_w;
+  mpz_t *z_w2 = &S->z_w2;
+  mpz_t *z_s1 = &S->z_s1;
+  mpz_t *z_a = &S->z_a;
+  mpz_t *z_an = &S->z_an;
+  mpz_t *z_s1w = &S->z_s1w;
+  mpz_t *z_sa = &S->z_sa;
+  mpz_t *z_s2 = &S->z_s2;
+
+  mpz_init(t1);
+  mpz_init(t2);
+  mpz_init(t3);
+  mpz_init(t4);
+  mpz_init(t5);
+
+  if (P->used)
+    goto fail;
 
-    goo_group_reduce(group, A, A);
+  /* A presignature is only valid for the group it was made in. */
+  if (mpz_cmp(P->gn, group->n) != 0
+      || mpz_cmp(P->gg, group->g) != 0
+      || mpz_cmp(P->gh, group->h) != 0) {
+    goto fail;
+  }
 
+  for (;;) {
     if (!goo_group_derive(group,
-                          *chal, *ell, key, C1, *C2, *C3,
-                          *t, A, B, C, D, E, msg, msg_len)) {
+                          *chal, *ell, key, P->C1, P->C2, P->C3,
+                          P->t, P->A, P->B, P->C, P->D, P->E,
+                          msg, msg_len)) {
       goto fail;
     }
 
     if (!goo_next_prime(*ell, *ell, key, GOO_ELLDIFF_MAX))
       mpz_set_ui(*ell, 0);
+
+    if (goo_mpz_bitlen(*ell) == GOO_ELL_BITS)
+      break;
+
+    goo_group_random_scalar(group, &P->prng, P->r_s1);
+
+    if (!goo_group_powgh(group, P->A, P->r_w, P->r_s1))
+      goto fail;
+
+    goo_group_reduce(group, P->A, P->A);
   }
 
   /* Compute the integer vector `z`:
@@ -2679,33 +3724,33 @@ goo_group_sign(goo_group_t *group,
    *   z_sa = chal * s * a + r_sa
    *   z_s2 = chal * s2 + r_s2
    */
-  mpz_mul(*z_w, *chal, w);
-  mpz_add(*z_w, *z_w, r_w);
+  mpz_mul(*z_w, *chal, P->w);
+  mpz_add(*z_w, *z_w, P->r_w);
 
-  mpz_mul(*z_w2, *chal, w);
-  mpz_mul(*z_w2, *z_w2, w);
-  mpz_add(*z_w2, *z_w2, r_w2);
+  mpz_mul(*z_w2, *chal, P->w);
+  mpz_mul(*z_w2, *z_w2, P->w);
+  mpz_add(*z_w2, *z_w2, P->r_w2);
 
-  mpz_mul(*z_s1, *chal, s1);
-  mpz_add(*z_s1, *z_s1, r_s1);
+  mpz_mul(*z_s1, *chal, P->s1);
+  mpz_add(*z_s1, *z_s1, P->r_s1);
 
-  mpz_mul(*z_a, *chal, a);
-  mpz_add(*z_a, *z_a, r_a);
+  mpz_mul(*z_a, *chal, P->a);
+  mpz_add(*z_a, *z_a, P->r_a);
 
-  mpz_mul(*z_an, *chal, a);
-  mpz_mul(*z_an, *z_an, n);
-  mpz_add(*z_an, *z_an, r_an);
+  mpz_mul(*z_an, *chal, P->a);
+  mpz_mul(*z_an, *z_an, P->n);
+  mpz_add(*z_an, *z_an, P->r_an);
 
-  mpz_mul(*z_s1w, *chal, s1);
-  mpz_mul(*z_s1w, *z_s1w, w);
-  mpz_add(*z_s1w, *z_s1w, r_s1w);
+  mpz_mul(*z_s1w, *chal, P->s1);
+  mpz_mul(*z_s1w, *z_s1w, P->w);
+  mpz_add(*z_s1w, *z_s1w, P->r_s1w);
 
-  mpz_mul(*z_sa, *chal, s);
-  mpz_mul(*z_sa, *z_sa, a);
-  mpz_add(*z_sa, *z_sa, r_sa);
+  mpz_mul(*z_sa, *chal, P->s);
+  mpz_mul(*z_sa, *z_sa, P->a);
+  mpz_add(*z_sa, *z_sa, P->r_sa);
 
-  mpz_mul(*z_s2, *chal, s2);
-  mpz_add(*z_s2, *z_s2, r_s2);
+  mpz_mul(*z_s2, *chal, P->s2);
+  mpz_add(*z_s2, *z_s2, P->r_s2);
 
   /* Compute quotient commitments:
    *
@@ -2734,7 +3779,7 @@ goo_group_sign(goo_group_t *group,
   mpz_fdiv_q(t1, *z_w, *ell);
   mpz_fdiv_q(t2, *z_w2, *ell);
   mpz_fdiv_q(t3, *z_s1w, *ell);
-  goo_group_pow(group, t4, C2i, *C2, t1);
+  goo_group_pow(group, t4, P->C2i, P->C2, t1);
 
   if (!goo_group_powgh(group, t5, t2, t3))
     goto fail;
@@ -2745,7 +3790,7 @@ goo_group_sign(goo_group_t *group,
   mpz_fdiv_q(t1, *z_a, *ell);
   mpz_fdiv_q(t2, *z_an, *ell);
   mpz_fdiv_q(t3, *z_sa, *ell);
-  goo_group_pow(group, t4, C1i, C1, t1);
+  goo_group_pow(group, t4, P->C1i, P->C1, t1);
 
   if (!goo_group_powgh(group, t5, t2, t3))
     goto fail;
@@ -2768,52 +3813,62 @@ goo_group_sign(goo_group_t *group,
   mpz_mod(*z_sa, *z_sa, *ell);
   mpz_mod(*z_s2, *z_s2, *ell);
 
+  mpz_set(S->C2, P->C2);
+  mpz_set(S->C3, P->C3);
+  mpz_set(S->t, P->t);
+
   /* S = (C2, C3, t, chal, ell, Aq, Bq, Cq, Dq, Eq, z') */
   r = 1;
 fail:
-  goo_prng_uninit(&prng);
-  goo_mpz_clear(n);
-  goo_mpz_clear(s);
-  goo_mpz_clear(C1);
-  goo_mpz_clear(w);
-  goo_mpz_clear(a);
-  goo_mpz_clear(s1);
-  goo_mpz_clear(s2);
   goo_mpz_clear(t1);
   goo_mpz_clear(t2);
   goo_mpz_clear(t3);
   goo_mpz_clear(t4);
   goo_mpz_clear(t5);
-  goo_mpz_clear(C1i);
-  goo_mpz_clear(C2i);
-  goo_mpz_clear(r_w);
-  goo_mpz_clear(r_w2);
-  goo_mpz_clear(r_s1);
-  goo_mpz_clear(r_a);
-  goo_mpz_clear(r_an);
-  goo_mpz_clear(r_s1w);
-  goo_mpz_clear(r_sa);
-  goo_mpz_clear(r_s2);
-  goo_mpz_clear(A);
-  goo_mpz_clear(B);
-  goo_mpz_clear(C);
-  goo_mpz_clear(D);
-  goo_mpz_clear(E);
-  goo_cleanse(&prng, sizeof(goo_prng_t));
-  goo_cleanse(primes, sizeof(primes));
-  goo_cleanse(&i, sizeof(i));
   goo_cleanse(key, sizeof(key));
   goo_group_cleanse(group);
   return r;
 }
 
 static int
-goo_group_verify(goo_group_t *group,
-                 const unsigned char *msg,
-                 size_t msg_len,
-                 const goo_sig_t *S,
-                 const mpz_t C1) {
+goo_group_sign(goo_group_t *group,
+               goo_sig_t *S,
+               const unsigned char *msg,
+               size_t msg_len,
+               const unsigned char *s_prime,
+               const mpz_t p,
+               const mpz_t q) {
   int r = 0;
+  goo_signer_t K;
+  goo_presig_t P;
+
+  goo_signer_init(&K);
+  goo_presig_init(&P);
+
+  if (!goo_group_signer(group, &K, s_prime, p, q))
+    goto fail;
+
+  /* The message doubles as the PRNG entropy, */
+  /* keeping signatures deterministic. */
+  if (!goo_group_presign(group, &P, &K, msg, msg_len))
+    goto fail;
+
+  if (!goo_group_sign_presig(group, S, &P, msg, msg_len))
+    goto fail;
+
+  r = 1;
+fail:
+  goo_presig_uninit(&P);
+  goo_signer_uninit(&K);
+  return r;
+}
+
+static int
+goo_group_verify_check(goo_group_t *group,
+                       const goo_sig_t *S,
+                       const mpz_t C1) {
+  /* The range checks of goo_group_verify, which need */
+  /* no exponentiations (nor inverses). */
   const mpz_t *C2 = &S->C2;
   const mpz_t *C3 = &S->C3;
   const mpz_t *t = &S->t;
@@ -2832,32 +3887,9 @@ goo_group_verify(goo_group_t *group,
   const mpz_t *z_s1w = &S->z_s1w;
   const mpz_t *z_sa = &S->z_sa;
   const mpz_t *z_s2 = &S->z_s2;
-
-  mpz_t C1i, C2i, C3i, Aqi, Bqi, Cqi, Dqi;
-  mpz_t A, B, C, D, E;
-  mpz_t tmp, chal0, ell0, ell1;
-
-  unsigned char key[GOO_SHA256_HASH_SIZE];
   size_t i;
   int found;
 
-  mpz_init(C1i);
-  mpz_init(C2i);
-  mpz_init(C3i);
-  mpz_init(Aqi);
-  mpz_init(Bqi);
-  mpz_init(Cqi);
-  mpz_init(Dqi);
-  mpz_init(A);
-  mpz_init(B);
-  mpz_init(C);
-  mpz_init(D);
-  mpz_init(E);
-  mpz_init(tmp);
-  mpz_init(chal0);
-  mpz_init(ell0);
-  mpz_init(ell1);
-
   VERIFY_POS(C1);
   VERIFY_POS(*C2);
   VERIFY_POS(*C3);
@@ -2926,11 +3958,60 @@ goo_group_verify(goo_group_t *group,
     goto fail;
   }
 
-  /* Compute inverses of C1, C2, C3, Aq, Bq, Cq, Dq. */
-  if (!goo_group_inv7(group, C1i, C2i, C3i, Aqi, Bqi, Cqi, Dqi,
-                             C1, *C2, *C3, *Aq, *Bq, *Cq, *Dq)) {
-    goto fail;
-  }
+  return 1;
+fail:
+  return 0;
+}
+
+static int
+goo_group_verify_proof(goo_group_t *group,
+                       unsigned char *key,
+                       const unsigned char *msg,
+                       size_t msg_len,
+                       const goo_sig_t *S,
+                       const mpz_t C1,
+                       const mpz_t C1i,
+                       const mpz_t C2i,
+                       const mpz_t C3i) {
+  /* Everything but the primality of `ell`, which is left to the */
+  /* caller along with the 32 byte key to test it under. `S` must */
+  /* have passed goo_group_verify_check, and C1i, C2i and C3i are */
+  /* the inverses of C1, C2 and C3. */
+  int r = 0;
+  const mpz_t *C2 = &S->C2;
+  const mpz_t *C3 = &S->C3;
+  const mpz_t *t = &S->t;
+  const mpz_t *chal = &S->chal;
+  const mpz_t *ell = &S->ell;
+  const mpz_t *Aq = &S->Aq;
+  const mpz_t *Bq = &S->Bq;
+  const mpz_t *Cq = &S->Cq;
+  const mpz_t *Dq = &S->Dq;
+  const mpz_t *Eq = &S->Eq;
+  const mpz_t *z_w = &S->z_w;
+  const mpz_t *z_w2 = &S->z_w2;
+  const mpz_t *z_s1 = &S->z_s1;
+  const mpz_t *z_a = &S->z_a;
+  const mpz_t *z_an = &S->z_an;
+  const mpz_t *z_s1w = &S->z_s1w;
+  const mpz_t *z_sa = &S->z_sa;
+  const mpz_t *z_s2 = &S->z_s2;
+
+  mpz_t A, B, C, D, E;
+  mpz_t tmp, chal0, ell0, ell1;
+
+  mpz_ptr out[4];
+  mpz_srcptr bq[4], bc[4], bci[4], ec[4], eg[4], eh[4];
+
+  mpz_init(A);
+  mpz_init(B);
+  mpz_init(C);
+  mpz_init(D);
+  mpz_init(E);
+  mpz_init(tmp);
+  mpz_init(chal0);
+  mpz_init(ell0);
+  mpz_init(ell1);
 
   /* Reconstruct A, B, C, D, and E from signature:
    *
@@ -2939,26 +4020,46 @@ goo_group_verify(goo_group_t *group,
    *   C = Cq^ell * g^z_w2 * h^z_s1w / C2^z_w in G
    *   D = Dq^ell * g^z_an * h^z_sa / C1^z_a in G
    *   E = Eq * ell + ((z_w2 - z_an) mod ell) - t * chal
+   *
+   * The first four share `ell` and are computed together.
    */
-  if (!goo_group_recover(group, A, *Aq, Aqi, *ell,
-                         *C2, C2i, *chal, *z_w, *z_s1)) {
-    goto fail;
-  }
-
-  if (!goo_group_recover(group, B, *Bq, Bqi, *ell,
-                         *C3, C3i, *chal, *z_a, *z_s2)) {
-    goto fail;
-  }
-
-  if (!goo_group_recover(group, C, *Cq, Cqi, *ell,
-                         *C2, C2i, *z_w, *z_w2, *z_s1w)) {
-    goto fail;
-  }
-
-  if (!goo_group_recover(group, D, *Dq, Dqi, *ell,
-                         C1, C1i, *z_a, *z_an, *z_sa)) {
+  out[0] = A;
+  out[1] = B;
+  out[2] = C;
+  out[3] = D;
+
+  bq[0] = *Aq;
+  bq[1] = *Bq;
+  bq[2] = *Cq;
+  bq[3] = *Dq;
+
+  bc[0] = *C2;
+  bc[1] = *C3;
+  bc[2] = *C2;
+  bc[3] = C1;
+
+  bci[0] = C2i;
+  bci[1] = C3i;
+  bci[2] = C2i;
+  bci[3] = C1i;
+
+  ec[0] = *chal;
+  ec[1] = *chal;
+  ec[2] = *z_w;
+  ec[3] = *z_a;
+
+  eg[0] = *z_w;
+  eg[1] = *z_a;
+  eg[2] = *z_w2;
+  eg[3] = *z_an;
+
+  eh[0] = *z_s1;
+  eh[1] = *z_s2;
+  eh[2] = *z_s1w;
+  eh[3] = *z_sa;
+
+  if (!goo_group_recover4(group, out, bq, *ell, bc, bci, ec, eg, eh))
     goto fail;
-  }
 
   mpz_mul(E, *Eq, *ell);
   mpz_sub(tmp, *z_w2, *z_an);
@@ -2984,19 +4085,8 @@ goo_group_verify(goo_group_t *group,
   if (mpz_cmp(*ell, ell0) < 0 || mpz_cmp(*ell, ell1) > 0)
     goto fail;
 
-  /* `ell` must be prime. */
-  if (!goo_is_prime(*ell, key))
-    goto fail;
-
   r = 1;
 fail:
-  mpz_clear(C1i);
-  mpz_clear(C2i);
-  mpz_clear(C3i);
-  mpz_clear(Aqi);
-  mpz_clear(Bqi);
-  mpz_clear(Cqi);
-  mpz_clear(Dqi);
   mpz_clear(A);
   mpz_clear(B);
   mpz_clear(C);
@@ -3009,28 +4099,155 @@ fail:
   return r;
 }
 
-/*
- * RSA
- */
+static int
+goo_group_verify(goo_group_t *group,
+                 const unsigned char *msg,
+                 size_t msg_len,
+                 const goo_sig_t *S,
+                 const mpz_t C1) {
+  unsigned char key[GOO_SHA256_HASH_SIZE];
+  mpz_t C1i, C2i, C3i;
+  mpz_srcptr in[3];
+  mpz_ptr out[3];
+  int r = 0;
 
-static void
-goo_mgf1xor(unsigned char *out,
-            size_t out_len,
-            const unsigned char *seed,
-            size_t seed_len) {
-  /* [RFC8017] Page 67, Section B.2.1. */
-  unsigned char ctr[4] = {0, 0, 0, 0};
-  unsigned char digest[GOO_SHA256_HASH_SIZE];
-  goo_sha256_t ctx, sha;
-  size_t i = 0;
-  size_t j;
-  int k;
+  mpz_init(C1i);
+  mpz_init(C2i);
+  mpz_init(C3i);
 
-  goo_sha256_init(&ctx);
-  goo_sha256_update(&ctx, seed, seed_len);
+  if (!goo_group_verify_check(group, S, C1))
+    goto fail;
 
-  while (i < out_len) {
-    memcpy(&sha, &ctx, sizeof(goo_sha256_t));
+  /* Compute inverses of C1, C2, C3. */
+  in[0] = C1;
+  in[1] = S->C2;
+  in[2] = S->C3;
+
+  out[0] = C1i;
+  out[1] = C2i;
+  out[2] = C3i;
+
+  if (!goo_group_inv_batch(group, out, in, 3))
+    goto fail;
+
+  if (!goo_group_verify_proof(group, key, msg, msg_len, S, C1, C1i, C2i, C3i))
+    goto fail;
+
+  /* `ell` must be prime. */
+  r = goo_is_prime(S->ell, key);
+fail:
+  mpz_clear(C1i);
+  mpz_clear(C2i);
+  mpz_clear(C3i);
+  return r;
+}
+
+static void
+goo_group_verify_batch(goo_group_t *group,
+                       int *ok,
+                       const unsigned char *const *msgs,
+                       const size_t *msg_lens,
+                       const goo_sig_t *sigs,
+                       const mpz_t *C1s,
+                       size_t len) {
+  /* goo_group_verify for `len` signatures. The inverses of every */
+  /* C1, C2 and C3 share one inversion, and the primality tests of */
+  /* the surviving `ell`s run four at a time. */
+  unsigned char *keys = goo_malloc(len * GOO_SHA256_HASH_SIZE);
+  mpz_t *invs = goo_calloc(3 * len, sizeof(mpz_t));
+  mpz_srcptr *in = goo_malloc(3 * len * sizeof(mpz_srcptr));
+  mpz_ptr *out = goo_malloc(3 * len * sizeof(mpz_ptr));
+  mpz_srcptr *ells = goo_malloc(len * sizeof(mpz_srcptr));
+  size_t *idx = goo_malloc(len * sizeof(size_t));
+  int *res = goo_malloc(len * sizeof(int));
+  size_t i, j;
+  size_t m = 0;
+  size_t k = 0;
+
+  for (i = 0; i < 3 * len; i++) {
+    mpz_init(invs[i]);
+    out[i] = invs[i];
+  }
+
+  for (i = 0; i < len; i++) {
+    ok[i] = goo_group_verify_check(group, &sigs[i], C1s[i]);
+
+    if (ok[i]) {
+      in[m * 3 + 0] = C1s[i];
+      in[m * 3 + 1] = sigs[i].C2;
+      in[m * 3 + 2] = sigs[i].C3;
+      idx[m++] = i;
+    }
+  }
+
+  /* Should the batch fail to invert (an element shares a factor */
+  /* with n), invert per signature so that the others still pass. */
+  if (m > 0 && !goo_group_inv_batch(group, out, in, m * 3)) {
+    for (j = 0; j < m; j++) {
+      if (!goo_group_inv_batch(group, out + j * 3, in + j * 3, 3))
+        ok[idx[j]] = 0;
+    }
+  }
+
+  for (j = 0; j < m; j++) {
+    unsigned char *key = keys + k * GOO_SHA256_HASH_SIZE;
+
+    i = idx[j];
+
+    if (!ok[i])
+      continue;
+
+    ok[i] = goo_group_verify_proof(group, key, msgs[i], msg_lens[i],
+                                   &sigs[i], C1s[i], invs[j * 3 + 0],
+                                   invs[j * 3 + 1], invs[j * 3 + 2]);
+
+    if (ok[i]) {
+      ells[k] = sigs[i].ell;
+      idx[k++] = i;
+    }
+  }
+
+  /* `ell` must be prime. */
+  if (k > 0)
+    goo_is_prime_batch(res, ells, keys, k, group->cpu);
+
+  for (j = 0; j < k; j++)
+    ok[idx[j]] = res[j];
+
+  for (i = 0; i < 3 * len; i++)
+    mpz_clear(invs[i]);
+
+  goo_free(keys);
+  goo_free(invs);
+  goo_free(in);
+  goo_free(out);
+  goo_free(ells);
+  goo_free(idx);
+  goo_free(res);
+}
+
+/*
+ * RSA
+ */
+
+static void
+goo_mgf1xor(unsigned char *out,
+            size_t out_len,
+            const unsigned char *seed,
+            size_t seed_len) {
+  /* [RFC8017] Page 67, Section B.2.1. */
+  unsigned char ctr[4] = {0, 0, 0, 0};
+  unsigned char digest[GOO_SHA256_HASH_SIZE];
+  goo_sha256_t ctx, sha;
+  size_t i = 0;
+  size_t j;
+  int k;
+
+  goo_sha256_init(&ctx);
+  goo_sha256_update(&ctx, seed, seed_len);
+
+  while (i < out_len) {
+    memcpy(&sha, &ctx, sizeof(goo_sha256_t));
     goo_sha256_update(&sha, ctr, sizeof(ctr));
     goo_sha256_final(&sha, digest);
 
@@ -3197,7 +4414,7 @@ goo_encrypt_oaep(unsigned char **out,
   if (!goo_veil(m, m, n, GOO_MAX_RSA_BITS + 8, &prng))
     goto fail;
 
-  *out_len = (GOO_MAX_RSA_BITS + 8 + 7) / 8;
+  *out_len = GOO_CIPHERTEXT_SIZE;
   *out = goo_mpz_pad(NULL, *out_len, m);
 
   if (*out == NULL)
@@ -3212,45 +4429,49 @@ fail:
   return r;
 }
 
+static void
+goo_rsakey_init(goo_rsakey_t *key) {
+  mpz_init(key->n);
+  mpz_init(key->e);
+  mpz_init(key->p);
+  mpz_init(key->q);
+  mpz_init(key->dp);
+  mpz_init(key->dq);
+  mpz_init(key->qinv);
+  key->klen = 0;
+}
+
+static void
+goo_rsakey_uninit(goo_rsakey_t *key) {
+  goo_mpz_clear(key->n);
+  goo_mpz_clear(key->e);
+  goo_mpz_clear(key->p);
+  goo_mpz_clear(key->q);
+  goo_mpz_clear(key->dp);
+  goo_mpz_clear(key->dq);
+  goo_mpz_clear(key->qinv);
+  key->klen = 0;
+}
+
 static int
-goo_decrypt_oaep(unsigned char **out,
-                 size_t *out_len,
-                 const unsigned char *msg,
-                 size_t msg_len,
-                 const mpz_t p,
-                 const mpz_t q,
-                 const mpz_t e,
-                 const unsigned char *label,
-                 size_t label_len,
-                 const unsigned char *entropy) {
-  /* [RFC8017] Page 25, Section 7.1.2. */
+goo_rsakey_set(goo_rsakey_t *key,
+               const mpz_t p,
+               const mpz_t q,
+               const mpz_t e) {
   int r = 0;
-  goo_prng_t prng;
-  mpz_t n, t, d, m, s, b, bi;
-  unsigned char *em = NULL;
-  unsigned char *seed, *db, *rest, *lhash;
-  size_t i, klen, slen, dlen, rlen;
-  size_t hlen = GOO_SHA256_HASH_SIZE;
-  uint32_t zero, lvalid, looking, index, invalid, valid;
-  unsigned char expect[GOO_SHA256_HASH_SIZE];
-
-  goo_prng_init(&prng);
+  mpz_t t, d, x;
 
-  mpz_init(n);
   mpz_init(t);
   mpz_init(d);
-  mpz_init(m);
-  mpz_init(s);
-  mpz_init(b);
-  mpz_init(bi);
+  mpz_init(x);
 
   if (!goo_is_valid_prime(p) || !goo_is_valid_prime(q))
     goto fail;
 
   /* n = p * q */
-  mpz_mul(n, p, q);
+  mpz_mul(key->n, p, q);
 
-  if (!goo_is_valid_modulus(n))
+  if (!goo_is_valid_modulus(key->n))
     goto fail;
 
   if (!goo_is_valid_exponent(e))
@@ -3258,26 +4479,97 @@ goo_decrypt_oaep(unsigned char **out,
 
   /* t = (p - 1) * (q - 1) */
   mpz_sub_ui(t, p, 1);
-  mpz_sub_ui(d, q, 1);
-  mpz_mul(t, t, d);
+  mpz_sub_ui(x, q, 1);
+  mpz_mul(t, t, x);
 
   /* d = e^-1 mod t */
   if (!mpz_invert(d, e, t))
     goto fail;
 
-  klen = goo_mpz_bytelen(n);
+  /* qinv = q^-1 mod p */
+  if (!mpz_invert(key->qinv, q, p))
+    goto fail;
+
+  /* dp = d mod (p - 1) */
+  mpz_sub_ui(x, p, 1);
+  mpz_mod(key->dp, d, x);
+
+  /* dq = d mod (q - 1) */
+  mpz_sub_ui(x, q, 1);
+  mpz_mod(key->dq, d, x);
+
+  mpz_set(key->e, e);
+  mpz_set(key->p, p);
+  mpz_set(key->q, q);
+
+  key->klen = goo_mpz_bytelen(key->n);
+
+  r = 1;
+fail:
+  goo_mpz_clear(t);
+  goo_mpz_clear(d);
+  goo_mpz_clear(x);
+  return r;
+}
+
+static void
+goo_rsakey_powm(mpz_t y, const mpz_t x, const mpz_t d, const mpz_t m) {
+#if defined(GOO_HAS_GMP)
+  if (mpz_sgn(d) > 0 && mpz_odd_p(m))
+    mpz_powm_sec(y, x, d, m);
+  else
+    mpz_powm(y, x, d, m);
+#elif defined(GOO_HAS_DLGMP)
+  if (goo_mpz_table.powm_sec != NULL && mpz_sgn(d) > 0 && mpz_odd_p(m))
+    goo_mpz_table.powm_sec(y, x, d, m);
+  else
+    mpz_powm(y, x, d, m);
+#else
+  mpz_powm(y, x, d, m);
+#endif
+}
+
+static int
+goo_decrypt_oaep_key(const goo_rsakey_t *key,
+                     unsigned char **out,
+                     size_t *out_len,
+                     const unsigned char *msg,
+                     size_t msg_len,
+                     const unsigned char *label,
+                     size_t label_len,
+                     const unsigned char *entropy) {
+  /* [RFC8017] Page 25, Section 7.1.2. */
+  int r = 0;
+  goo_prng_t prng;
+  mpz_t t, m, m1, m2, s, b, bi;
+  unsigned char *em = NULL;
+  unsigned char *seed, *db, *rest, *lhash;
+  size_t i, slen, dlen, rlen;
+  size_t hlen = GOO_SHA256_HASH_SIZE;
+  uint32_t zero, lvalid, looking, index, invalid, valid;
+  unsigned char expect[GOO_SHA256_HASH_SIZE];
+
+  goo_prng_init(&prng);
+
+  mpz_init(t);
+  mpz_init(m);
+  mpz_init(m1);
+  mpz_init(m2);
+  mpz_init(s);
+  mpz_init(b);
+  mpz_init(bi);
 
-  if (klen < hlen * 2 + 2)
+  if (key->klen < hlen * 2 + 2)
     goto fail;
 
-  if (!goo_unveil(m, msg, msg_len, n, GOO_MAX_RSA_BITS + 8))
+  if (!goo_unveil(m, msg, msg_len, key->n, GOO_MAX_RSA_BITS + 8))
     goto fail;
 
   /* Seed PRNG with user-provided entropy. */
   goo_prng_seed(&prng, entropy, GOO_PRNG_DECRYPT);
 
   /* t = n - 1 */
-  mpz_sub_ui(t, n, 1);
+  mpz_sub_ui(t, key->n, 1);
 
   /* Generate blinding factor. */
   for (;;) {
@@ -3286,35 +4578,41 @@ goo_decrypt_oaep(unsigned char **out,
     mpz_add_ui(s, s, 1);
 
     /* bi = s^-1 mod n */
-    if (!mpz_invert(bi, s, n))
+    if (!mpz_invert(bi, s, key->n))
       continue;
 
     /* b = s^e mod n */
-    mpz_powm(b, s, e, n);
+    mpz_powm(b, s, key->e, key->n);
 
     break;
   }
 
   /* c' = c * b mod n (blind) */
   mpz_mul(m, m, b);
-  mpz_mod(m, m, n);
+  mpz_mod(m, m, key->n);
 
-  /* m' = c'^d mod n */
-#ifdef GOO_HAS_GMP
-  if (mpz_sgn(d) > 0 && mpz_odd_p(n))
-    mpz_powm_sec(m, m, d, n);
-  else
-    mpz_powm(m, m, d, n);
-#else
-  mpz_powm(m, m, d, n);
-#endif
+  /* m' = c'^d mod n, by way of the CRT:
+   *
+   *   m1 = c'^dp mod p
+   *   m2 = c'^dq mod q
+   *   h = (m1 - m2) * qinv mod p
+   *   m' = m2 + h * q
+   */
+  goo_rsakey_powm(m1, m, key->dp, key->p);
+  goo_rsakey_powm(m2, m, key->dq, key->q);
+
+  mpz_sub(m, m1, m2);
+  mpz_mul(m, m, key->qinv);
+  mpz_mod(m, m, key->p);
+  mpz_mul(m, m, key->q);
+  mpz_add(m, m, m2);
 
   /* m = m' * bi mod n (unblind) */
   mpz_mul(m, m, bi);
-  mpz_mod(m, m, n);
+  mpz_mod(m, m, key->n);
 
   /* EM = 0x00 || (seed) || (Hash(L) || PS || 0x01 || M) */
-  em = goo_mpz_pad(NULL, klen, m);
+  em = goo_mpz_pad(NULL, key->klen, m);
 
   if (em == NULL)
     goto fail;
@@ -3324,7 +4622,7 @@ goo_decrypt_oaep(unsigned char **out,
   seed = &em[1];
   slen = hlen;
   db = &em[hlen + 1];
-  dlen = klen - (hlen + 1);
+  dlen = key->klen - (hlen + 1);
 
   goo_mgf1xor(seed, slen, db, dlen);
   goo_mgf1xor(db, dlen, seed, slen);
@@ -3356,16 +4654,16 @@ goo_decrypt_oaep(unsigned char **out,
   *out = goo_malloc(*out_len);
   memcpy(*out, rest + index + 1, *out_len);
 
-  goo_cleanse(em, klen);
+  goo_cleanse(em, key->klen);
 
   r = 1;
 fail:
   goo_prng_uninit(&prng);
   goo_cleanse(&prng, sizeof(goo_prng_t));
-  goo_mpz_clear(n);
   goo_mpz_clear(t);
-  goo_mpz_clear(d);
   goo_mpz_clear(m);
+  goo_mpz_clear(m1);
+  goo_mpz_clear(m2);
   goo_mpz_clear(s);
   goo_mpz_clear(b);
   goo_mpz_clear(bi);
@@ -3373,6 +4671,36 @@ fail:
   return r;
 }
 
+static int
+goo_decrypt_oaep(unsigned char **out,
+                 size_t *out_len,
+                 const unsigned char *msg,
+                 size_t msg_len,
+                 const mpz_t p,
+                 const mpz_t q,
+                 const mpz_t e,
+                 const unsigned char *label,
+                 size_t label_len,
+                 const unsigned char *entropy) {
+  goo_rsakey_t key;
+  int r = 0;
+
+  goo_rsakey_init(&key);
+
+  if (!goo_rsakey_set(&key, p, q, e))
+    goto fail;
+
+  if (!goo_decrypt_oaep_key(&key, out, out_len, msg, msg_len,
+                            label, label_len, entropy)) {
+    goto fail;
+  }
+
+  r = 1;
+fail:
+  goo_rsakey_uninit(&key);
+  return r;
+}
+
 /*
  * API
  */
@@ -3405,6 +4733,42 @@ fail:
   return ret;
 }
 
+int
+goo_load_gmp(void) {
+#if defined(GOO_HAS_GMP)
+  return 1;
+#elif defined(GOO_HAS_DLGMP)
+  return goo_dlgmp_load();
+#else
+  return 0;
+#endif
+}
+
+const char *
+goo_backend(void) {
+#if defined(GOO_HAS_GMP)
+  return "gmp";
+#elif defined(GOO_HAS_DLGMP)
+  return goo_dlgmp_loaded() ? "gmp" : "mini-gmp";
+#else
+  return "mini-gmp";
+#endif
+}
+
+goo_group_t *
+goo_clone(const goo_group_t *ctx) {
+  goo_group_t *ret;
+
+  if (ctx == NULL)
+    return NULL;
+
+  ret = goo_malloc(sizeof(goo_group_t));
+
+  goo_group_clone(ret, ctx);
+
+  return ret;
+}
+
 void
 goo_destroy(goo_group_t *ctx) {
   if (ctx != NULL) {
@@ -3413,6 +4777,60 @@ goo_destroy(goo_group_t *ctx) {
   }
 }
 
+size_t
+goo_size(const goo_group_t *ctx) {
+  return ctx->size;
+}
+
+size_t
+goo_signature_size(const goo_group_t *ctx) {
+  return goo_sig_size(NULL, ctx->bits);
+}
+
+static size_t
+goo_comb_memory(const goo_group_t *ctx, const goo_comb_t *comb) {
+  size_t size = 0;
+  unsigned long i;
+
+  /* Window scratch is always ours. */
+  size += comb->shifts * sizeof(unsigned long *);
+  size += comb->shifts * comb->adds_per_shift * sizeof(unsigned long);
+
+  if (comb->shared)
+    return size;
+
+  if (comb->mitems != NULL)
+    size += comb->size * ctx->mont.limbs * sizeof(goo_limb_t);
+
+  if (comb->items == NULL)
+    return size;
+
+  size += comb->size * sizeof(mpz_t);
+
+  for (i = 0; i < comb->size; i++)
+    size += mpz_size(comb->items[i]) * sizeof(mp_limb_t);
+
+  return size;
+}
+
+size_t
+goo_memory(const goo_group_t *ctx) {
+  size_t size = sizeof(goo_group_t);
+  size_t i;
+
+  if (ctx->mtable4 != NULL)
+    size += goo_group_mtable4_size(ctx);
+
+  for (i = 0; i < ctx->combs_len; i++) {
+    size += goo_comb_memory(ctx, &ctx->combs[i].g);
+
+    if (!ctx->combs[i].joint)
+      size += goo_comb_memory(ctx, &ctx->combs[i].h);
+  }
+
+  return size;
+}
+
 int
 goo_generate(goo_group_t *ctx,
              unsigned char *s_prime,
@@ -3438,22 +4856,18 @@ goo_generate(goo_group_t *ctx,
 }
 
 int
-goo_challenge(goo_group_t *ctx,
-              unsigned char **C1,
-              size_t *C1_len,
-              const unsigned char *s_prime,
-              const unsigned char *n,
-              size_t n_len) {
+goo_challenge_into(goo_group_t *ctx,
+                   unsigned char *C1,
+                   const unsigned char *s_prime,
+                   const unsigned char *n,
+                   size_t n_len) {
   int r = 0;
   mpz_t C1_n, n_n;
 
-  if (ctx == NULL
-      || s_prime == NULL
-      || C1 == NULL
-      || C1_len == NULL
-      || n == NULL) {
+  if (ctx == NULL || s_prime == NULL || C1 == NULL || n == NULL)
     return 0;
-  }
+
+  GOO_PROBE1(challenge__entry, ctx->bits);
 
   mpz_init(C1_n);
   mpz_init(n_n);
@@ -3463,49 +4877,166 @@ goo_challenge(goo_group_t *ctx,
   if (!goo_group_challenge(ctx, C1_n, s_prime, n_n))
     goto fail;
 
-  *C1_len = ctx->size;
-  *C1 = goo_mpz_pad(NULL, *C1_len, C1_n);
-
-  if (*C1 == NULL)
+  if (goo_mpz_pad(C1, ctx->size, C1_n) == NULL)
     goto fail;
 
   r = 1;
 fail:
   goo_mpz_clear(C1_n);
   goo_mpz_clear(n_n);
+  GOO_PROBE2(challenge__return, ctx->bits, r);
   return r;
 }
 
 int
-goo_validate(goo_group_t *ctx,
-             const unsigned char *s_prime,
-             const unsigned char *C1,
-             size_t C1_len,
-             const unsigned char *p,
-             size_t p_len,
-             const unsigned char *q,
-             size_t q_len) {
-  int r = 0;
-  mpz_t C1_n, p_n, q_n;
+goo_challenge(goo_group_t *ctx,
+              unsigned char **C1,
+              size_t *C1_len,
+              const unsigned char *s_prime,
+              const unsigned char *n,
+              size_t n_len) {
+  unsigned char *data;
 
-  if (ctx == NULL
-      || s_prime == NULL
-      || C1 == NULL
-      || p == NULL
-      || q == NULL) {
+  if (ctx == NULL || C1 == NULL || C1_len == NULL)
     return 0;
-  }
 
-  if (C1_len != ctx->size)
-    return 0;
+  data = goo_malloc(ctx->size);
 
-  mpz_init(C1_n);
-  mpz_init(p_n);
-  mpz_init(q_n);
+  if (!goo_challenge_into(ctx, data, s_prime, n, n_len)) {
+    goo_free(data);
+    return 0;
+  }
 
-  goo_mpz_import(C1_n, C1, C1_len);
-  goo_mpz_import(p_n, p, p_len);
-  goo_mpz_import(q_n, q, q_len);
+  *C1 = data;
+  *C1_len = ctx->size;
+
+  return 1;
+}
+
+int
+goo_derive_sprime(goo_group_t *ctx,
+                  unsigned char *s_prime,
+                  const unsigned char *seed,
+                  unsigned long index) {
+  unsigned char ctr[8];
+  goo_sha256_t sha;
+  int i;
+
+  (void)ctx;
+
+  if (s_prime == NULL || seed == NULL)
+    return 0;
+
+  for (i = 7; i >= 0; i--) {
+    ctr[i] = index & 0xff;
+    index >>= 8;
+  }
+
+  goo_sha256_init(&sha);
+  goo_sha256_update(&sha, GOO_PRNG_BATCH, sizeof(GOO_PRNG_BATCH));
+  goo_sha256_update(&sha, seed, 32);
+  goo_sha256_update(&sha, ctr, sizeof(ctr));
+  goo_sha256_final(&sha, s_prime);
+
+  goo_cleanse(&sha, sizeof(goo_sha256_t));
+
+  return 1;
+}
+
+int
+goo_challenge_batch(goo_group_t *ctx,
+                    unsigned char *out,
+                    unsigned char *s_primes,
+                    const unsigned char *seed,
+                    unsigned long offset,
+                    const unsigned char *const *ns,
+                    const size_t *n_lens,
+                    size_t len) {
+  unsigned char derived[32];
+  const unsigned char *s_prime;
+  unsigned char *C1;
+  int r = 1;
+  mpz_t C1_n, n_n;
+  size_t i;
+
+  if (ctx == NULL
+      || out == NULL
+      || (seed == NULL && s_primes == NULL)
+      || ns == NULL
+      || n_lens == NULL) {
+    return 0;
+  }
+
+  mpz_init(C1_n);
+  mpz_init(n_n);
+
+  for (i = 0; i < len; i++) {
+    C1 = out + i * ctx->size;
+
+    if (seed != NULL) {
+      goo_derive_sprime(ctx, derived, seed, offset + i);
+
+      if (s_primes != NULL)
+        memcpy(s_primes + i * 32, derived, 32);
+
+      s_prime = derived;
+    } else {
+      s_prime = s_primes + i * 32;
+    }
+
+    GOO_PROBE1(challenge__entry, ctx->bits);
+
+    goo_mpz_import(n_n, ns[i], n_lens[i]);
+
+    if (goo_group_challenge(ctx, C1_n, s_prime, n_n)) {
+      goo_mpz_pad(C1, ctx->size, C1_n);
+      GOO_PROBE2(challenge__return, ctx->bits, 1);
+    } else {
+      memset(C1, 0x00, ctx->size);
+      GOO_PROBE2(challenge__return, ctx->bits, 0);
+      r = 0;
+    }
+  }
+
+  goo_cleanse(derived, sizeof(derived));
+  goo_mpz_clear(C1_n);
+  goo_mpz_clear(n_n);
+
+  return r;
+}
+
+int
+goo_validate(goo_group_t *ctx,
+             const unsigned char *s_prime,
+             const unsigned char *C1,
+             size_t C1_len,
+             const unsigned char *p,
+             size_t p_len,
+             const unsigned char *q,
+             size_t q_len) {
+  int r = 0;
+  mpz_t C1_n, p_n, q_n;
+
+  if (ctx == NULL
+      || s_prime == NULL
+      || C1 == NULL
+      || p == NULL
+      || q == NULL) {
+    return 0;
+  }
+
+  if (C1_len != ctx->size)
+    return 0;
+
+  GOO_PROBE1(validate__entry, ctx->bits);
+
+  mpz_init(C1_n);
+  mpz_init(p_n);
+  mpz_init(q_n);
+
+  goo_mpz_import(C1_n, C1, C1_len);
+  goo_mpz_import(p_n, p, p_len);
+  goo_mpz_import(q_n, q, q_len);
 
   if (!goo_group_validate(ctx, s_prime, C1_n, p_n, q_n))
     goto fail;
@@ -3515,35 +5046,34 @@ fail:
   goo_mpz_clear(C1_n);
   goo_mpz_clear(p_n);
   goo_mpz_clear(q_n);
+  GOO_PROBE2(validate__return, ctx->bits, r);
   return r;
 }
 
 int
-goo_sign(goo_group_t *ctx,
-         unsigned char **out,
-         size_t *out_len,
-         const unsigned char *msg,
-         size_t msg_len,
-         const unsigned char *s_prime,
-         const unsigned char *p,
-         size_t p_len,
-         const unsigned char *q,
-         size_t q_len) {
+goo_sign_into(goo_group_t *ctx,
+              unsigned char *out,
+              const unsigned char *msg,
+              size_t msg_len,
+              const unsigned char *s_prime,
+              const unsigned char *p,
+              size_t p_len,
+              const unsigned char *q,
+              size_t q_len) {
   int r = 0;
   mpz_t p_n, q_n;
   goo_sig_t S;
-  size_t size;
-  unsigned char *data = NULL;
 
   if (ctx == NULL
       || out == NULL
-      || out_len == NULL
       || s_prime == NULL
       || p == NULL
       || q == NULL) {
     return 0;
   }
 
+  GOO_PROBE1(sign__entry, ctx->bits);
+
   mpz_init(p_n);
   mpz_init(q_n);
   goo_sig_init(&S);
@@ -3554,25 +5084,281 @@ goo_sign(goo_group_t *ctx,
   if (!goo_group_sign(ctx, &S, msg, msg_len, s_prime, p_n, q_n))
     goto fail;
 
-  size = goo_sig_size(&S, ctx->bits);
+  if (!goo_sig_export(out, &S, ctx->bits))
+    goto fail;
+
+  r = 1;
+fail:
+  goo_mpz_clear(p_n);
+  goo_mpz_clear(q_n);
+  goo_sig_uninit(&S);
+  GOO_PROBE2(sign__return, ctx->bits, r);
+  return r;
+}
+
+int
+goo_sign(goo_group_t *ctx,
+         unsigned char **out,
+         size_t *out_len,
+         const unsigned char *msg,
+         size_t msg_len,
+         const unsigned char *s_prime,
+         const unsigned char *p,
+         size_t p_len,
+         const unsigned char *q,
+         size_t q_len) {
+  unsigned char *data;
+  size_t size;
+
+  if (ctx == NULL || out == NULL || out_len == NULL)
+    return 0;
+
+  size = goo_signature_size(ctx);
   data = goo_malloc(size);
 
-  if (!goo_sig_export(data, &S, ctx->bits))
-    goto fail;
+  if (!goo_sign_into(ctx, data, msg, msg_len, s_prime,
+                     p, p_len, q, q_len)) {
+    goo_free(data);
+    return 0;
+  }
 
   *out = data;
   *out_len = size;
-  data = NULL;
 
-  r = 1;
+  return 1;
+}
+
+goo_signer_t *
+goo_signer_create(goo_group_t *ctx,
+                  const unsigned char *s_prime,
+                  const unsigned char *p,
+                  size_t p_len,
+                  const unsigned char *q,
+                  size_t q_len) {
+  goo_signer_t *K = NULL;
+  goo_signer_t *ret = NULL;
+  mpz_t p_n, q_n;
+
+  if (ctx == NULL || s_prime == NULL || p == NULL || q == NULL)
+    return NULL;
+
+  mpz_init(p_n);
+  mpz_init(q_n);
+
+  goo_mpz_import(p_n, p, p_len);
+  goo_mpz_import(q_n, q, q_len);
+
+  K = goo_malloc(sizeof(goo_signer_t));
+
+  goo_signer_init(K);
+
+  if (!goo_group_signer(ctx, K, s_prime, p_n, q_n))
+    goto fail;
+
+  ret = K;
+  K = NULL;
 fail:
   goo_mpz_clear(p_n);
   goo_mpz_clear(q_n);
+  goo_signer_destroy(K);
+  return ret;
+}
+
+void
+goo_signer_destroy(goo_signer_t *signer) {
+  if (signer != NULL) {
+    goo_signer_uninit(signer);
+    goo_free(signer);
+  }
+}
+
+int
+goo_signer_sign_into(goo_group_t *ctx,
+                     unsigned char *out,
+                     goo_signer_t *signer,
+                     const unsigned char *msg,
+                     size_t msg_len) {
+  int r = 0;
+  goo_presig_t P;
+  goo_sig_t S;
+
+  if (ctx == NULL || out == NULL || signer == NULL)
+    return 0;
+
+  GOO_PROBE1(sign__entry, ctx->bits);
+
+  goo_presig_init(&P);
+  goo_sig_init(&S);
+
+  if (!goo_group_presign(ctx, &P, signer, msg, msg_len))
+    goto fail;
+
+  if (!goo_group_sign_presig(ctx, &S, &P, msg, msg_len))
+    goto fail;
+
+  if (!goo_sig_export(out, &S, ctx->bits))
+    goto fail;
+
+  r = 1;
+fail:
+  goo_presig_uninit(&P);
   goo_sig_uninit(&S);
-  goo_free(data);
+  GOO_PROBE2(sign__return, ctx->bits, r);
   return r;
 }
 
+int
+goo_signer_sign(goo_group_t *ctx,
+                unsigned char **out,
+                size_t *out_len,
+                goo_signer_t *signer,
+                const unsigned char *msg,
+                size_t msg_len) {
+  unsigned char *data;
+  size_t size;
+
+  if (ctx == NULL || out == NULL || out_len == NULL)
+    return 0;
+
+  size = goo_signature_size(ctx);
+  data = goo_malloc(size);
+
+  if (!goo_signer_sign_into(ctx, data, signer, msg, msg_len)) {
+    goo_free(data);
+    return 0;
+  }
+
+  *out = data;
+  *out_len = size;
+
+  return 1;
+}
+
+int
+goo_signer_presign(goo_group_t *ctx,
+                   goo_presig_t **presig,
+                   goo_signer_t *signer,
+                   const unsigned char *entropy) {
+  int r = 0;
+  goo_presig_t *P = NULL;
+
+  if (ctx == NULL || presig == NULL || signer == NULL || entropy == NULL)
+    return 0;
+
+  P = goo_malloc(sizeof(goo_presig_t));
+
+  goo_presig_init(P);
+
+  if (!goo_group_presign(ctx, P, signer, entropy, 32))
+    goto fail;
+
+  *presig = P;
+  P = NULL;
+
+  r = 1;
+fail:
+  goo_presig_destroy(P);
+  return r;
+}
+
+int
+goo_presign(goo_group_t *ctx,
+            goo_presig_t **presig,
+            const unsigned char *s_prime,
+            const unsigned char *p,
+            size_t p_len,
+            const unsigned char *q,
+            size_t q_len,
+            const unsigned char *entropy) {
+  goo_signer_t *K;
+  int r;
+
+  if (presig == NULL || entropy == NULL)
+    return 0;
+
+  K = goo_signer_create(ctx, s_prime, p, p_len, q, q_len);
+
+  if (K == NULL)
+    return 0;
+
+  r = goo_signer_presign(ctx, presig, K, entropy);
+
+  goo_signer_destroy(K);
+
+  return r;
+}
+
+int
+goo_sign_with_presig_into(goo_group_t *ctx,
+                          unsigned char *out,
+                          goo_presig_t *presig,
+                          const unsigned char *msg,
+                          size_t msg_len) {
+  int r = 0;
+  goo_sig_t S;
+
+  if (ctx == NULL || out == NULL || presig == NULL)
+    return 0;
+
+  if (presig->used)
+    return 0;
+
+  GOO_PROBE1(sign__entry, ctx->bits);
+
+  goo_sig_init(&S);
+
+  if (!goo_group_sign_presig(ctx, &S, presig, msg, msg_len))
+    goto fail;
+
+  if (!goo_sig_export(out, &S, ctx->bits))
+    goto fail;
+
+  r = 1;
+fail:
+  /* Never reuse the nonces, even on failure. */
+  goo_presig_uninit(presig);
+  goo_sig_uninit(&S);
+  GOO_PROBE2(sign__return, ctx->bits, r);
+  return r;
+}
+
+int
+goo_sign_with_presig(goo_group_t *ctx,
+                     unsigned char **out,
+                     size_t *out_len,
+                     goo_presig_t *presig,
+                     const unsigned char *msg,
+                     size_t msg_len) {
+  unsigned char *data;
+  size_t size;
+
+  if (ctx == NULL || out == NULL || out_len == NULL || presig == NULL)
+    return 0;
+
+  size = goo_signature_size(ctx);
+  data = goo_malloc(size);
+
+  if (!goo_sign_with_presig_into(ctx, data, presig, msg, msg_len)) {
+    goo_free(data);
+    return 0;
+  }
+
+  *out = data;
+  *out_len = size;
+
+  return 1;
+}
+
+void
+goo_presig_destroy(goo_presig_t *presig) {
+  if (presig != NULL) {
+    if (!presig->used)
+      goo_presig_uninit(presig);
+
+    goo_free(presig);
+  }
+}
+
 int
 goo_verify(goo_group_t *ctx,
            const unsigned char *msg,
@@ -3591,6 +5377,8 @@ goo_verify(goo_group_t *ctx,
   if (C1_len != ctx->size)
     return 0;
 
+  GOO_PROBE1(verify__entry, ctx->bits);
+
   goo_sig_init(&S);
   mpz_init(C1_n);
 
@@ -3606,6 +5394,92 @@ goo_verify(goo_group_t *ctx,
 fail:
   goo_sig_uninit(&S);
   mpz_clear(C1_n);
+  GOO_PROBE2(verify__return, ctx->bits, r);
+  return r;
+}
+
+int
+goo_verify_batch(goo_group_t *ctx,
+                 int *ok,
+                 const unsigned char *const *msgs,
+                 const size_t *msg_lens,
+                 const unsigned char *const *sigs,
+                 const size_t *sig_lens,
+                 const unsigned char *const *C1s,
+                 const size_t *C1_lens,
+                 size_t len) {
+  const unsigned char **ms;
+  size_t *ml, *idx;
+  goo_sig_t *S;
+  mpz_t *C1_n;
+  int *res;
+  size_t i;
+  size_t m = 0;
+  int r = 1;
+
+  if (ctx == NULL
+      || ok == NULL
+      || msgs == NULL
+      || msg_lens == NULL
+      || sigs == NULL
+      || sig_lens == NULL
+      || C1s == NULL
+      || C1_lens == NULL) {
+    return 0;
+  }
+
+  GOO_PROBE1(verify_batch__entry, ctx->bits);
+
+  ms = goo_malloc(len * sizeof(unsigned char *));
+  ml = goo_malloc(len * sizeof(size_t));
+  idx = goo_malloc(len * sizeof(size_t));
+  S = goo_malloc(len * sizeof(goo_sig_t));
+  C1_n = goo_malloc(len * sizeof(mpz_t));
+  res = goo_malloc(len * sizeof(int));
+
+  /* Signatures which fail to parse drop out here. */
+  for (i = 0; i < len; i++) {
+    ok[i] = 0;
+
+    if (sigs[i] == NULL || C1s[i] == NULL || C1_lens[i] != ctx->size)
+      continue;
+
+    goo_sig_init(&S[m]);
+
+    if (!goo_sig_import(&S[m], sigs[i], sig_lens[i], ctx->bits)) {
+      goo_sig_uninit(&S[m]);
+      continue;
+    }
+
+    mpz_init(C1_n[m]);
+    goo_mpz_import(C1_n[m], C1s[i], C1_lens[i]);
+
+    ms[m] = msgs[i];
+    ml[m] = msg_lens[i];
+    idx[m++] = i;
+  }
+
+  if (m > 0)
+    goo_group_verify_batch(ctx, res, ms, ml, S, (const mpz_t *)C1_n, m);
+
+  for (i = 0; i < m; i++) {
+    ok[idx[i]] = res[i];
+    goo_sig_uninit(&S[i]);
+    mpz_clear(C1_n[i]);
+  }
+
+  for (i = 0; i < len; i++)
+    r &= ok[i];
+
+  goo_free(ms);
+  goo_free(ml);
+  goo_free(idx);
+  goo_free(S);
+  goo_free(C1_n);
+  goo_free(res);
+
+  GOO_PROBE2(verify_batch__return, ctx->bits, r);
+
   return r;
 }
 
@@ -3703,3 +5577,191 @@ fail:
   goo_mpz_clear(e_n);
   return r;
 }
+
+goo_rsakey_t *
+goo_rsakey_create(const unsigned char *p,
+                  size_t p_len,
+                  const unsigned char *q,
+                  size_t q_len,
+                  const unsigned char *e,
+                  size_t e_len) {
+  goo_rsakey_t *key;
+  mpz_t p_n, q_n, e_n;
+
+  if (p == NULL || q == NULL || e == NULL)
+    return NULL;
+
+  key = goo_malloc(sizeof(goo_rsakey_t));
+
+  goo_rsakey_init(key);
+
+  mpz_init(p_n);
+  mpz_init(q_n);
+  mpz_init(e_n);
+
+  goo_mpz_import(p_n, p, p_len);
+  goo_mpz_import(q_n, q, q_len);
+  goo_mpz_import(e_n, e, e_len);
+
+  if (!goo_rsakey_set(key, p_n, q_n, e_n)) {
+    goo_rsakey_uninit(key);
+    goo_free(key);
+    key = NULL;
+  }
+
+  goo_mpz_clear(p_n);
+  goo_mpz_clear(q_n);
+  goo_mpz_clear(e_n);
+
+  return key;
+}
+
+void
+goo_rsakey_destroy(goo_rsakey_t *key) {
+  if (key != NULL) {
+    goo_rsakey_uninit(key);
+    goo_free(key);
+  }
+}
+
+int
+goo_rsakey_decrypt(goo_group_t *ctx,
+                   unsigned char **out,
+                   size_t *out_len,
+                   const goo_rsakey_t *key,
+                   const unsigned char *msg,
+                   size_t msg_len,
+                   const unsigned char *label,
+                   size_t label_len,
+                   const unsigned char *entropy) {
+  (void)ctx;
+
+  if (out == NULL
+      || out_len == NULL
+      || key == NULL
+      || msg == NULL
+      || entropy == NULL) {
+    return 0;
+  }
+
+  return goo_decrypt_oaep_key(key, out, out_len, msg, msg_len,
+                              label, label_len, entropy);
+}
+
+int
+goo_rsakey_scan(goo_group_t *ctx,
+                size_t *index,
+                unsigned char *out,
+                const goo_rsakey_t *key,
+                const unsigned char *data,
+                size_t len,
+                size_t msg_len,
+                const unsigned char *entropy) {
+  unsigned char seed[GOO_SHA256_HASH_SIZE];
+  unsigned char ctr[8];
+  unsigned char *pt;
+  size_t pt_len;
+  goo_sha256_t sha;
+  size_t i, j, k;
+  int r = 0;
+
+  (void)ctx;
+
+  if (index == NULL
+      || out == NULL
+      || key == NULL
+      || (data == NULL && len > 0)
+      || entropy == NULL) {
+    return 0;
+  }
+
+  for (i = 0; i < len; i++) {
+    const unsigned char *ct = data + i * GOO_CIPHERTEXT_SIZE;
+
+    /* Every attempt gets its own blinding seed. */
+    for (j = 0, k = i; j < 8; j++, k >>= 8)
+      ctr[7 - j] = k & 0xff;
+
+    goo_sha256_init(&sha);
+    goo_sha256_update(&sha, entropy, 32);
+    goo_sha256_update(&sha, ctr, sizeof(ctr));
+    goo_sha256_final(&sha, seed);
+
+    if (!goo_decrypt_oaep_key(key, &pt, &pt_len, ct, GOO_CIPHERTEXT_SIZE,
+                              NULL, 0, seed)) {
+      continue;
+    }
+
+    if (pt_len == msg_len) {
+      memcpy(out, pt, msg_len);
+      *index = i;
+      r = 1;
+    }
+
+    goo_cleanse(pt, pt_len);
+    goo_free(pt);
+
+    if (r)
+      break;
+  }
+
+  goo_cleanse(&sha, sizeof(goo_sha256_t));
+  goo_cleanse(seed, sizeof(seed));
+
+  return r;
+}
+
+int
+goo_encrypt_batch(goo_group_t *ctx,
+                  unsigned char *out,
+                  const unsigned char *msgs,
+                  size_t msg_len,
+                  const unsigned char *const *ns,
+                  const size_t *n_lens,
+                  const unsigned char *const *es,
+                  const size_t *e_lens,
+                  const unsigned char *entropy,
+                  size_t len) {
+  unsigned char *ct, *rec;
+  size_t ct_len;
+  int r = 1;
+  mpz_t n_n, e_n;
+  size_t i;
+
+  (void)ctx;
+
+  if (out == NULL
+      || (msgs == NULL && msg_len > 0)
+      || ns == NULL
+      || n_lens == NULL
+      || es == NULL
+      || e_lens == NULL
+      || entropy == NULL) {
+    return 0;
+  }
+
+  mpz_init(n_n);
+  mpz_init(e_n);
+
+  for (i = 0; i < len; i++) {
+    rec = out + i * GOO_CIPHERTEXT_SIZE;
+
+    goo_mpz_import(n_n, ns[i], n_lens[i]);
+    goo_mpz_import(e_n, es[i], e_lens[i]);
+
+    if (goo_encrypt_oaep(&ct, &ct_len, msgs + i * msg_len, msg_len,
+                         n_n, e_n, NULL, 0, entropy + i * 32)) {
+      assert(ct_len == GOO_CIPHERTEXT_SIZE);
+      memcpy(rec, ct, GOO_CIPHERTEXT_SIZE);
+      goo_free(ct);
+    } else {
+      memset(rec, 0x00, GOO_CIPHERTEXT_SIZE);
+      r = 0;
+    }
+  }
+
+  goo_mpz_clear(n_n);
+  goo_mpz_clear(e_n);
+
+  return r;
+}
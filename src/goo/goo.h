@@ -13,7 +13,22 @@
 extern "C" {
 #endif
 
+/* Size of a veiled ciphertext: (4096 + 8 + 7) / 8. */
+#define GOO_CIPHERTEXT_SIZE 513
+
 typedef struct goo_group_s goo_ctx_t;
+typedef struct goo_signer_s goo_signer_t;
+typedef struct goo_presig_s goo_presig_t;
+typedef struct goo_rsakey_s goo_rsakey_t;
+
+/* Builds without GMP try to load a system libgmp at runtime. Call this
+ * once, before any other function. Returns 1 if GMP is in use. */
+int
+goo_load_gmp(void);
+
+/* Active bignum backend: "gmp" or "mini-gmp". */
+const char *
+goo_backend(void);
 
 goo_ctx_t *
 goo_create(const unsigned char *n,
@@ -22,9 +37,28 @@ goo_create(const unsigned char *n,
            unsigned long h,
            unsigned long bits);
 
+/* Create a context sharing the (read-only) precomputed tables of `ctx`.
+ * Each context may be used by one thread at a time; a context and its
+ * clones may be used concurrently. `ctx` must outlive its clones. */
+goo_ctx_t *
+goo_clone(const goo_ctx_t *ctx);
+
 void
 goo_destroy(goo_ctx_t *ctx);
 
+/* Size of a group element (and of a challenge) in bytes. */
+size_t
+goo_size(const goo_ctx_t *ctx);
+
+/* Size of a serialized signature in bytes. */
+size_t
+goo_signature_size(const goo_ctx_t *ctx);
+
+/* Approximate heap usage of a context in bytes. Tables shared with
+ * the context it was cloned from are not counted. */
+size_t
+goo_memory(const goo_ctx_t *ctx);
+
 int
 goo_generate(goo_ctx_t *ctx,
              unsigned char *s_prime,
@@ -38,6 +72,40 @@ goo_challenge(goo_ctx_t *ctx,
               const unsigned char *n,
               size_t n_len);
 
+/* Write a goo_size() byte challenge to `C1`. */
+int
+goo_challenge_into(goo_ctx_t *ctx,
+                   unsigned char *C1,
+                   const unsigned char *s_prime,
+                   const unsigned char *n,
+                   size_t n_len);
+
+/* Derive the `index`th s_prime from a 32 byte master seed:
+ *
+ *   s_prime = SHA256(SHA256("Goo Batch") || seed || index (64 bit BE))
+ */
+int
+goo_derive_sprime(goo_ctx_t *ctx,
+                  unsigned char *s_prime,
+                  const unsigned char *seed,
+                  unsigned long index);
+
+/* Compute `len` challenges into `out` as fixed-width records of the
+ * group modulus' byte length. If `seed` is non-NULL, the s_primes are
+ * derived from it (at indices `offset` onward) and written to `s_primes`
+ * when that is non-NULL. Otherwise `s_primes` holds `len` 32 byte
+ * s_primes. The record of an invalid modulus is zeroed and the call
+ * returns 0, but every other record is still computed. */
+int
+goo_challenge_batch(goo_ctx_t *ctx,
+                    unsigned char *out,
+                    unsigned char *s_primes,
+                    const unsigned char *seed,
+                    unsigned long offset,
+                    const unsigned char *const *ns,
+                    const size_t *n_lens,
+                    size_t len);
+
 int
 goo_validate(goo_ctx_t *ctx,
              const unsigned char *s_prime,
@@ -60,6 +128,89 @@ goo_sign(goo_ctx_t *ctx,
          const unsigned char *q,
          size_t q_len);
 
+/* Write a goo_signature_size() byte signature to `out`. */
+int
+goo_sign_into(goo_ctx_t *ctx,
+              unsigned char *out,
+              const unsigned char *msg,
+              size_t msg_len,
+              const unsigned char *s_prime,
+              const unsigned char *p,
+              size_t p_len,
+              const unsigned char *q,
+              size_t q_len);
+
+/* Prepare a key for repeated signing: validates p and q once and caches
+ * n, s and C1. The inverse of C1 and the square roots of the small primes
+ * are computed (and cached) as signing needs them. Signing with a prepared
+ * key gives the same signatures as goo_sign. A signer is bound to the group
+ * it was made in (including clones) and may be used by one thread at a
+ * time. */
+goo_signer_t *
+goo_signer_create(goo_ctx_t *ctx,
+                  const unsigned char *s_prime,
+                  const unsigned char *p,
+                  size_t p_len,
+                  const unsigned char *q,
+                  size_t q_len);
+
+void
+goo_signer_destroy(goo_signer_t *signer);
+
+int
+goo_signer_sign(goo_ctx_t *ctx,
+                unsigned char **out,
+                size_t *out_len,
+                goo_signer_t *signer,
+                const unsigned char *msg,
+                size_t msg_len);
+
+int
+goo_signer_sign_into(goo_ctx_t *ctx,
+                     unsigned char *out,
+                     goo_signer_t *signer,
+                     const unsigned char *msg,
+                     size_t msg_len);
+
+int
+goo_signer_presign(goo_ctx_t *ctx,
+                   goo_presig_t **presig,
+                   goo_signer_t *signer,
+                   const unsigned char *entropy);
+
+/* Offline half of `goo_sign`: computes every message-independent
+ * commitment for (s_prime, p, q) using 32 bytes of fresh entropy. */
+int
+goo_presign(goo_ctx_t *ctx,
+            goo_presig_t **presig,
+            const unsigned char *s_prime,
+            const unsigned char *p,
+            size_t p_len,
+            const unsigned char *q,
+            size_t q_len,
+            const unsigned char *entropy);
+
+/* Online half: signs `msg` with a presignature made in the same group.
+ * The presignature is wiped whether or not signing succeeds and can
+ * never be used again; it must still be freed with goo_presig_destroy. */
+int
+goo_sign_with_presig(goo_ctx_t *ctx,
+                     unsigned char **out,
+                     size_t *out_len,
+                     goo_presig_t *presig,
+                     const unsigned char *msg,
+                     size_t msg_len);
+
+int
+goo_sign_with_presig_into(goo_ctx_t *ctx,
+                          unsigned char *out,
+                          goo_presig_t *presig,
+                          const unsigned char *msg,
+                          size_t msg_len);
+
+void
+goo_presig_destroy(goo_presig_t *presig);
+
 int
 goo_verify(goo_ctx_t *ctx,
            const unsigned char *msg,
@@ -69,6 +220,21 @@ goo_verify(goo_ctx_t *ctx,
            const unsigned char *C1,
            size_t C1_len);
 
+/* Verify `len` signatures, writing each result to `ok`. The primality
+ * tests on `ell` run four signatures at a time in SIMD lockstep, so
+ * this is cheaper than `len` calls to goo_verify. Returns 1 if every
+ * signature is valid. */
+int
+goo_verify_batch(goo_ctx_t *ctx,
+                 int *ok,
+                 const unsigned char *const *msgs,
+                 const size_t *msg_lens,
+                 const unsigned char *const *sigs,
+                 const size_t *sig_lens,
+                 const unsigned char *const *C1s,
+                 const size_t *C1_lens,
+                 size_t len);
+
 int
 goo_encrypt(goo_ctx_t *ctx,
             unsigned char **out,
@@ -99,6 +265,62 @@ goo_decrypt(goo_ctx_t *ctx,
             size_t label_len,
             const unsigned char *entropy);
 
+/* Prepare an RSA private key for repeated decryption. The CRT
+ * exponents and coefficient are computed once; returns NULL if the key
+ * is invalid. */
+goo_rsakey_t *
+goo_rsakey_create(const unsigned char *p,
+                  size_t p_len,
+                  const unsigned char *q,
+                  size_t q_len,
+                  const unsigned char *e,
+                  size_t e_len);
+
+void
+goo_rsakey_destroy(goo_rsakey_t *key);
+
+/* Equivalent to goo_decrypt with a prepared key. */
+int
+goo_rsakey_decrypt(goo_ctx_t *ctx,
+                   unsigned char **out,
+                   size_t *out_len,
+                   const goo_rsakey_t *key,
+                   const unsigned char *msg,
+                   size_t msg_len,
+                   const unsigned char *label,
+                   size_t label_len,
+                   const unsigned char *entropy);
+
+/* Trial-decrypt `len` consecutive GOO_CIPHERTEXT_SIZE byte records
+ * with `key`, stopping at the first which decrypts to a `msg_len` byte
+ * message. Its index is written to `index` and the message to `out`.
+ * Returns 0 if no record matches. */
+int
+goo_rsakey_scan(goo_ctx_t *ctx,
+                size_t *index,
+                unsigned char *out,
+                const goo_rsakey_t *key,
+                const unsigned char *data,
+                size_t len,
+                size_t msg_len,
+                const unsigned char *entropy);
+
+/* Encrypt `len` messages of `msg_len` bytes each (stored contiguously)
+ * to the corresponding public keys, writing GOO_CIPHERTEXT_SIZE byte
+ * records to `out`. `entropy` holds 32 bytes per message. The record of
+ * a failed encryption is zeroed and the call returns 0. */
+int
+goo_encrypt_batch(goo_ctx_t *ctx,
+                  unsigned char *out,
+                  const unsigned char *msgs,
+                  size_t msg_len,
+                  const unsigned char *const *ns,
+                  const size_t *n_lens,
+                  const unsigned char *const *es,
+                  const size_t *e_lens,
+                  const unsigned char *entropy,
+                  size_t len);
+
 /**
  * Moduli of unknown factorization.
  */
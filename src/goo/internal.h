@@ -13,9 +13,23 @@
 #include <gmp.h>
 #else
 #include "mini-gmp.h"
+#ifdef GOO_HAS_DLGMP
+#include "dlgmp.h"
+#endif
 #endif
 
 #include "drbg.h"
+#include "mont.h"
+
+/* Static tracepoints (systemtap/USDT). */
+#ifdef GOO_HAS_SDT
+#include <sys/sdt.h>
+#define GOO_PROBE1(name, a) DTRACE_PROBE1(goosig, name, a)
+#define GOO_PROBE2(name, a, b) DTRACE_PROBE2(goosig, name, a, b)
+#else
+#define GOO_PROBE1(name, a) do { } while (0)
+#define GOO_PROBE2(name, a, b) do { } while (0)
+#endif
 
 #define GOO_DEFAULT_G 2
 #define GOO_DEFAULT_H 3
@@ -24,6 +38,9 @@
 #define GOO_EXP_BITS 2048
 #define GOO_WINDOW_SIZE 6
 #define GOO_MAX_COMB_SIZE 512
+#ifndef GOO_MAX_JOINT_COMB_SIZE
+#define GOO_MAX_JOINT_COMB_SIZE 4096 /* 0 disables joint combs */
+#endif
 #define GOO_CHAL_BITS 128
 #define GOO_ELL_BITS 136
 #define GOO_ELLDIFF_MAX 512
@@ -113,6 +130,14 @@ static const unsigned char GOO_PRNG_DECRYPT[32] = {
   0xf4, 0x1a, 0x01, 0xc7, 0x8d, 0x58, 0x3e, 0xe7
 };
 
+/* SHA256("Goo Batch") */
+static const unsigned char GOO_PRNG_BATCH[32] = {
+  0xb5, 0x34, 0x61, 0x54, 0x27, 0x67, 0xb7, 0xe7,
+  0x43, 0x0d, 0x2f, 0x68, 0x1b, 0xb5, 0x5b, 0xbd,
+  0xdd, 0x0b, 0x14, 0x8b, 0xa3, 0xe9, 0x13, 0x6b,
+  0x30, 0x28, 0x3e, 0xdb, 0xdc, 0xc0, 0x91, 0x86
+};
+
 /* SHA256("Goo Local") */
 static const unsigned char GOO_PRNG_LOCAL[32] = {
   0x21, 0x15, 0x7f, 0x0d, 0xbe, 0x3e, 0x90, 0x38,
@@ -137,11 +162,15 @@ typedef struct goo_comb_s {
   unsigned long bits;
   unsigned long points_per_subcomb;
   unsigned long size;
+  unsigned long bases; /* 2 if the points are g^i * h^j */
+  int shared;
   mpz_t *items;
+  goo_limb_t *mitems;
   unsigned long **wins;
 } goo_comb_t;
 
 typedef struct goo_comb_item_s {
+  int joint; /* `g` is a joint comb of g and h, `h` is unused */
   goo_comb_t g;
   goo_comb_t h;
 } goo_comb_item_t;
@@ -174,6 +203,87 @@ typedef struct goo_sig_s {
   mpz_t z_s2;
 } goo_sig_t;
 
+/* Typedef'd as goo_rsakey_t in goo.h. */
+struct goo_rsakey_s {
+  mpz_t n;
+  mpz_t e;
+  mpz_t p;
+  mpz_t q;
+  mpz_t dp;
+  mpz_t dq;
+  mpz_t qinv;
+  size_t klen;
+};
+
+/* Typedef'd as goo_signer_t in goo.h. */
+struct goo_signer_s {
+  /* Group the key was prepared in. */
+  mpz_t gn;
+  mpz_t gg;
+  mpz_t gh;
+
+  /* Key and seed. */
+  unsigned char s_prime[32];
+  mpz_t p;
+  mpz_t q;
+
+  /* Key-dependent values. */
+  mpz_t n;
+  mpz_t s;
+  mpz_t C1;
+  mpz_t C1i;
+
+  /* Square roots of the small primes, computed on demand:
+   * qr[i] is 0 (unknown), 1 (w[i] and a[i] are set) or -1
+   * (goo_primes[i] is not a quadratic residue mod n). */
+  signed char *qr;
+  mpz_t *w;
+  mpz_t *a;
+};
+
+/* Typedef'd as goo_presig_t in goo.h. */
+struct goo_presig_s {
+  /* Set once consumed (or wiped). */
+  int used;
+
+  /* Group the bundle was computed in. */
+  mpz_t gn;
+  mpz_t gg;
+  mpz_t gh;
+
+  /* PRNG state, continued by the online half. */
+  goo_prng_t prng;
+
+  /* Key-dependent values. */
+  mpz_t n;
+  mpz_t s;
+  mpz_t C1;
+  mpz_t w;
+  mpz_t a;
+  mpz_t s1;
+  mpz_t s2;
+  mpz_t t;
+  mpz_t C2;
+  mpz_t C3;
+  mpz_t C1i;
+  mpz_t C2i;
+
+  /* Message-independent commitments. */
+  mpz_t r_w;
+  mpz_t r_w2;
+  mpz_t r_s1;
+  mpz_t r_a;
+  mpz_t r_an;
+  mpz_t r_s1w;
+  mpz_t r_sa;
+  mpz_t r_s2;
+  mpz_t A;
+  mpz_t B;
+  mpz_t C;
+  mpz_t D;
+  mpz_t E;
+};
+
 typedef struct goo_group_s {
   /* Group parameters */
   mpz_t n;
@@ -198,6 +308,18 @@ typedef struct goo_group_s {
   long wnaf0[GOO_MAX_RSA_BITS + 1];
   long wnaf1[GOO_ELL_BITS + 1];
   long wnaf2[GOO_ELL_BITS + 1];
+  long wnaf4[4][GOO_ELL_BITS + 1];
+
+  /* Montgomery (fixed-width hot path) */
+  unsigned int cpu; /* goo_mont_cpu() */
+  int use_mont;
+  goo_mont_t mont;
+  goo_limb_t mtable_p1[GOO_TABLEN * GOO_MONT_MAX_LIMBS];
+  goo_limb_t mtable_n1[GOO_TABLEN * GOO_MONT_MAX_LIMBS];
+  goo_limb_t mtable_p2[GOO_TABLEN * GOO_MONT_MAX_LIMBS];
+  goo_limb_t mtable_n2[GOO_TABLEN * GOO_MONT_MAX_LIMBS];
+  goo_limb_t macc[GOO_MONT_MAX_LIMBS];
+  goo_limb_t *mtable4; /* four-lane tables for verify (goo_mont4) */
 
   /* Combs */
   size_t combs_len;
@@ -129,6 +129,18 @@ see https://www.gnu.org/licenses/.  */
     (sl) = __x;								\
   } while (0)
 
+#if defined(__SIZEOF_INT128__) && !defined(MINI_GMP_NO_INT128)
+/* A double-width type turns the four half-limb products below into a
+   single hardware multiplication on 64-bit targets. */
+#define gmp_umul_ppmm(w1, w0, u, v)					\
+  do {									\
+    int LOCAL_GMP_LIMB_BITS = GMP_LIMB_BITS;				\
+    __extension__ unsigned __int128 __ww =				\
+      (unsigned __int128) (u) * (v);					\
+    w0 = (mp_limb_t) __ww;						\
+    w1 = (mp_limb_t) (__ww >> LOCAL_GMP_LIMB_BITS);			\
+  } while (0)
+#else
 #define gmp_umul_ppmm(w1, w0, u, v)					\
   do {									\
     int LOCAL_GMP_LIMB_BITS = GMP_LIMB_BITS;				\
@@ -168,6 +180,7 @@ see https://www.gnu.org/licenses/.  */
       (w0) = (__x1 << (GMP_LIMB_BITS / 2)) + (__x0 & GMP_LLIMB_MASK);	\
     }									\
   } while (0)
+#endif
 
 #define gmp_udiv_qrnnd_preinv(q, r, nh, nl, d, di)			\
   do {									\
@@ -604,14 +617,24 @@ mpn_submul_1 (mp_ptr rp, mp_srcptr up, mp_size_t n, mp_limb_t vl)
   return cl;
 }
 
-mp_limb_t
-mpn_mul (mp_ptr rp, mp_srcptr up, mp_size_t un, mp_srcptr vp, mp_size_t vn)
-{
-  assert (un >= vn);
-  assert (vn >= 1);
-  assert (!GMP_MPN_OVERLAP_P(rp, un + vn, up, un));
-  assert (!GMP_MPN_OVERLAP_P(rp, un + vn, vp, vn));
+/* Operand sizes (in limbs) from which Karatsuba beats the schoolbook
+   loops. Below them, and for the odd limb, we fall back to the base
+   cases. */
+#ifndef GMP_MUL_KARATSUBA_THRESHOLD
+#define GMP_MUL_KARATSUBA_THRESHOLD 24
+#endif
 
+#ifndef GMP_SQR_KARATSUBA_THRESHOLD
+#define GMP_SQR_KARATSUBA_THRESHOLD 32
+#endif
+
+/* Scratch needed by the Karatsuba routines below for n limbs. */
+#define GMP_KARATSUBA_ITCH(n) (4 * (n) + 2 * GMP_LIMB_BITS)
+
+static mp_limb_t
+mpn_mul_basecase (mp_ptr rp, mp_srcptr up, mp_size_t un,
+		  mp_srcptr vp, mp_size_t vn)
+{
   /* We first multiply by the low order limb. This result can be
      stored, not added, to rp. We also avoid a loop for zeroing this
      way. */
@@ -629,6 +652,188 @@ mpn_mul (mp_ptr rp, mp_srcptr up, mp_size_t un, mp_srcptr vp, mp_size_t vn)
   return rp[un];
 }
 
+static void
+mpn_sqr_basecase (mp_ptr rp, mp_srcptr up, mp_size_t n)
+{
+  mp_size_t i;
+  mp_limb_t cy;
+
+  /* Each cross product u_i u_j (i < j) is computed once, then the sum
+     is doubled and the squares u_i^2 are added on the diagonal. */
+  rp[0] = 0;
+  rp[2 * n - 1] = 0;
+
+  if (n > 1)
+    {
+      rp[n] = mpn_mul_1 (rp + 1, up + 1, n - 1, up[0]);
+      for (i = 1; i + 1 < n; i++)
+	rp[n + i] = mpn_addmul_1 (rp + 2 * i + 1, up + i + 1, n - i - 1, up[i]);
+      rp[2 * n - 1] = mpn_lshift (rp + 1, rp + 1, 2 * n - 2, 1);
+    }
+
+  cy = 0;
+  for (i = 0; i < n; i++)
+    {
+      mp_limb_t hi, lo;
+      gmp_umul_ppmm (hi, lo, up[i], up[i]);
+
+      lo += cy;
+      hi += lo < cy;
+      rp[2 * i] += lo;
+      hi += rp[2 * i] < lo;
+      rp[2 * i + 1] += hi;
+      cy = rp[2 * i + 1] < hi;
+    }
+  assert (cy == 0);
+}
+
+static int
+mpn_absdiff_n (mp_ptr rp, mp_srcptr ap, mp_srcptr bp, mp_size_t n)
+{
+  /* rp = |a - b|, returning 1 if a < b. */
+  if (mpn_cmp (ap, bp, n) >= 0)
+    {
+      mpn_sub_n (rp, ap, bp, n);
+      return 0;
+    }
+  mpn_sub_n (rp, bp, ap, n);
+  return 1;
+}
+
+static void
+mpn_karatsuba_fold (mp_ptr rp, mp_ptr tp, mp_srcptr pp, int neg, mp_size_t h)
+{
+  /* rp holds z0 + z2 B^2h. Add (z0 + z2 -/+ p) B^h, where p (2h
+     limbs) is the product of the half differences. */
+  mp_limb_t cy;
+
+  tp[2 * h] = mpn_add_n (tp, rp, rp + 2 * h, 2 * h);
+
+  if (neg)
+    tp[2 * h] -= mpn_sub_n (tp, tp, pp, 2 * h);
+  else
+    tp[2 * h] += mpn_add_n (tp, tp, pp, 2 * h);
+
+  cy = mpn_add_n (rp + h, rp + h, tp, 2 * h + 1);
+  if (h > 1)
+    cy = mpn_add_1 (rp + 3 * h + 1, rp + 3 * h + 1, h - 1, cy);
+  assert (cy == 0);
+}
+
+static void
+mpn_karatsuba_mul_n (mp_ptr rp, mp_srcptr ap, mp_srcptr bp, mp_size_t n,
+		     mp_ptr tp)
+{
+  mp_size_t h;
+  int neg;
+
+  if (n < GMP_MUL_KARATSUBA_THRESHOLD)
+    {
+      mpn_mul_basecase (rp, ap, n, bp, n);
+      return;
+    }
+
+  if (n & 1)
+    {
+      /* Peel off the top limb of each operand. */
+      n -= 1;
+      mpn_karatsuba_mul_n (rp, ap, bp, n, tp);
+      rp[2 * n] = mpn_addmul_1 (rp + n, bp, n, ap[n]);
+      rp[2 * n + 1] = mpn_addmul_1 (rp + n, ap, n + 1, bp[n]);
+      return;
+    }
+
+  h = n >> 1;
+
+  /* a0 b1 + a1 b0 = z0 + z2 + (a0 - a1) (b1 - b0) */
+  neg = mpn_absdiff_n (tp, ap, ap + h, h);
+  neg ^= mpn_absdiff_n (tp + h, bp + h, bp, h);
+
+  mpn_karatsuba_mul_n (rp, ap, bp, h, tp + 4 * h);
+  mpn_karatsuba_mul_n (rp + 2 * h, ap + h, bp + h, h, tp + 4 * h);
+  mpn_karatsuba_mul_n (tp + 2 * h, tp, tp + h, h, tp + 4 * h);
+
+  mpn_karatsuba_fold (rp, tp + 4 * h, tp + 2 * h, neg, h);
+}
+
+static void
+mpn_karatsuba_sqr (mp_ptr rp, mp_srcptr ap, mp_size_t n, mp_ptr tp)
+{
+  mp_size_t h;
+
+  if (n < GMP_SQR_KARATSUBA_THRESHOLD)
+    {
+      mpn_sqr_basecase (rp, ap, n);
+      return;
+    }
+
+  if (n & 1)
+    {
+      n -= 1;
+      mpn_karatsuba_sqr (rp, ap, n, tp);
+      rp[2 * n] = mpn_addmul_1 (rp + n, ap, n, ap[n]);
+      rp[2 * n + 1] = mpn_addmul_1 (rp + n, ap, n + 1, ap[n]);
+      return;
+    }
+
+  h = n >> 1;
+
+  /* 2 a0 a1 = z0 + z2 - (a0 - a1)^2 */
+  mpn_absdiff_n (tp, ap, ap + h, h);
+
+  mpn_karatsuba_sqr (rp, ap, h, tp + 4 * h);
+  mpn_karatsuba_sqr (rp + 2 * h, ap + h, h, tp + 4 * h);
+  mpn_karatsuba_sqr (tp + 2 * h, tp, h, tp + 4 * h);
+
+  mpn_karatsuba_fold (rp, tp + 4 * h, tp + 2 * h, 1, h);
+}
+
+mp_limb_t
+mpn_mul (mp_ptr rp, mp_srcptr up, mp_size_t un, mp_srcptr vp, mp_size_t vn)
+{
+  mp_ptr tp, pp;
+  mp_size_t rn;
+
+  assert (un >= vn);
+  assert (vn >= 1);
+  assert (!GMP_MPN_OVERLAP_P(rp, un + vn, up, un));
+  assert (!GMP_MPN_OVERLAP_P(rp, un + vn, vp, vn));
+
+  if (vn < GMP_MUL_KARATSUBA_THRESHOLD)
+    return mpn_mul_basecase (rp, up, un, vp, vn);
+
+  tp = gmp_xalloc_limbs (GMP_KARATSUBA_ITCH (vn) + 2 * vn);
+  pp = tp + GMP_KARATSUBA_ITCH (vn);
+
+  /* Multiply vn-limb chunks of u, accumulating into rp. */
+  mpn_karatsuba_mul_n (rp, up, vp, vn, tp);
+  rn = 2 * vn;
+  up += vn;
+  un -= vn;
+
+  while (un > 0)
+    {
+      mp_size_t pn = GMP_MIN (un, vn) + vn;
+      mp_size_t off = rn - vn;
+
+      if (un >= vn)
+	mpn_karatsuba_mul_n (pp, up, vp, vn, tp);
+      else
+	mpn_mul (pp, vp, vn, up, un);
+
+      gmp_assert_nocarry (mpn_add (pp, pp, pn, rp + off, vn));
+      mpn_copyi (rp + off, pp, pn);
+
+      rn = off + pn;
+      up += GMP_MIN (un, vn);
+      un -= GMP_MIN (un, vn);
+    }
+
+  gmp_free (tp);
+
+  return rp[rn - 1];
+}
+
 void
 mpn_mul_n (mp_ptr rp, mp_srcptr ap, mp_srcptr bp, mp_size_t n)
 {
@@ -638,7 +843,20 @@ mpn_mul_n (mp_ptr rp, mp_srcptr ap, mp_srcptr bp, mp_size_t n)
 void
 mpn_sqr (mp_ptr rp, mp_srcptr ap, mp_size_t n)
 {
-  mpn_mul (rp, ap, n, ap, n);
+  mp_ptr tp;
+
+  assert (n >= 1);
+  assert (!GMP_MPN_OVERLAP_P(rp, 2 * n, ap, n));
+
+  if (n < GMP_SQR_KARATSUBA_THRESHOLD)
+    {
+      mpn_sqr_basecase (rp, ap, n);
+      return;
+    }
+
+  tp = gmp_xalloc_limbs (GMP_KARATSUBA_ITCH (n));
+  mpn_karatsuba_sqr (rp, ap, n, tp);
+  gmp_free (tp);
 }
 
 mp_limb_t
@@ -2056,7 +2274,9 @@ mpz_mul (mpz_t r, const mpz_t u, const mpz_t v)
   mpz_init2 (t, (un + vn) * GMP_LIMB_BITS);
 
   tp = t->_mp_d;
-  if (un >= vn)
+  if (u->_mp_d == v->_mp_d)
+    mpn_sqr (tp, u->_mp_d, un);
+  else if (un >= vn)
     mpn_mul (tp, u->_mp_d, un, v->_mp_d, vn);
   else
     mpn_mul (tp, v->_mp_d, vn, u->_mp_d, un);
@@ -2693,11 +2913,119 @@ mpz_make_odd (mpz_t r)
   return shift;
 }
 
+/* Lehmer's algorithm (Knuth, TAOCP vol. 2, 4.5.2, Algorithm L): run
+   Euclid on the leading bits of a and b in single precision for as long
+   as the quotients are certain to match the multiprecision ones, then
+   apply the accumulated 2x2 matrix to the full numbers at once. */
+static void
+mpz_lehmer_combine (mpz_t r, const mpz_t a, long ca, const mpz_t b, long cb,
+		    mpz_t t)
+{
+  /* r = ca a + cb b */
+  mpz_mul_si (r, a, ca);
+  mpz_mul_si (t, b, cb);
+  mpz_add (r, r, t);
+}
+
+static void
+mpz_lehmer (mpz_t a, mpz_t b, mpz_t xa, mpz_t xb)
+{
+  /* On entry a >= b >= 0, on return a = gcd and b = 0. If xa and xb
+     are non-NULL, they get the same row operations as a and b. */
+  const mp_bitcnt_t p = GMP_LIMB_BITS - 2;
+  mpz_t q, t0, t1, t2;
+
+  mpz_init (q);
+  mpz_init (t0);
+  mpz_init (t1);
+  mpz_init (t2);
+
+  while (b->_mp_size != 0)
+    {
+      mp_bitcnt_t abits;
+      long A = 1, B = 0, C = 0, D = 1;
+
+      if (xa == NULL && b->_mp_size == 1)
+	{
+	  mp_limb_t vl = b->_mp_d[0];
+	  mp_limb_t ul = mpz_tdiv_ui (a, vl);
+	  mpz_set_ui (a, mpn_gcd_11 (ul, vl));
+	  b->_mp_size = 0;
+	  break;
+	}
+
+      abits = mpz_sizeinbase (a, 2);
+
+      if (abits > p)
+	{
+	  long x, y;
+
+	  mpz_tdiv_q_2exp (t0, a, abits - p);
+	  x = (long) mpz_get_ui (t0);
+	  mpz_tdiv_q_2exp (t0, b, abits - p);
+	  y = (long) mpz_get_ui (t0);
+
+	  for (;;)
+	    {
+	      long qa, qb, tt;
+
+	      if (y + C <= 0 || y + D <= 0)
+		break;
+
+	      qa = (x + A) / (y + C);
+	      qb = (x + B) / (y + D);
+
+	      if (qa != qb)
+		break;
+
+	      tt = A - qa * C; A = C; C = tt;
+	      tt = B - qa * D; B = D; D = tt;
+	      tt = x - qa * y; x = y; y = tt;
+	    }
+	}
+
+      if (B == 0)
+	{
+	  /* No progress in single precision, take one full step. */
+	  mpz_tdiv_qr (q, t0, a, b);
+	  mpz_swap (a, b);
+	  mpz_swap (b, t0);
+
+	  if (xa)
+	    {
+	      mpz_mul (t0, q, xb);
+	      mpz_sub (t0, xa, t0);
+	      mpz_swap (xa, xb);
+	      mpz_swap (xb, t0);
+	    }
+	}
+      else
+	{
+	  mpz_lehmer_combine (t0, a, A, b, B, t2);
+	  mpz_lehmer_combine (t1, a, C, b, D, t2);
+	  mpz_swap (a, t0);
+	  mpz_swap (b, t1);
+
+	  if (xa)
+	    {
+	      mpz_lehmer_combine (t0, xa, A, xb, B, t2);
+	      mpz_lehmer_combine (t1, xa, C, xb, D, t2);
+	      mpz_swap (xa, t0);
+	      mpz_swap (xb, t1);
+	    }
+	}
+    }
+
+  mpz_clear (q);
+  mpz_clear (t0);
+  mpz_clear (t1);
+  mpz_clear (t2);
+}
+
 void
 mpz_gcd (mpz_t g, const mpz_t u, const mpz_t v)
 {
   mpz_t tu, tv;
-  mp_bitcnt_t uz, vz, gz;
 
   if (u->_mp_size == 0)
     {
@@ -2714,46 +3042,16 @@ mpz_gcd (mpz_t g, const mpz_t u, const mpz_t v)
   mpz_init (tv);
 
   mpz_abs (tu, u);
-  uz = mpz_make_odd (tu);
   mpz_abs (tv, v);
-  vz = mpz_make_odd (tv);
-  gz = GMP_MIN (uz, vz);
 
-  if (tu->_mp_size < tv->_mp_size)
+  if (mpz_cmp (tu, tv) < 0)
     mpz_swap (tu, tv);
 
-  mpz_tdiv_r (tu, tu, tv);
-  if (tu->_mp_size == 0)
-    {
-      mpz_swap (g, tv);
-    }
-  else
-    for (;;)
-      {
-	int c;
+  mpz_lehmer (tu, tv, NULL, NULL);
+  mpz_swap (g, tu);
 
-	mpz_make_odd (tu);
-	c = mpz_cmp (tu, tv);
-	if (c == 0)
-	  {
-	    mpz_swap (g, tu);
-	    break;
-	  }
-	if (c < 0)
-	  mpz_swap (tu, tv);
-
-	if (tv->_mp_size == 1)
-	  {
-	    mp_limb_t vl = tv->_mp_d[0];
-	    mp_limb_t ul = mpz_tdiv_ui (tu, vl);
-	    mpz_set_ui (g, mpn_gcd_11 (ul, vl));
-	    break;
-	  }
-	mpz_sub (tu, tu, tv);
-      }
   mpz_clear (tu);
   mpz_clear (tv);
-  mpz_mul_2exp (g, g, gz);
 }
 
 void
@@ -2978,32 +3276,34 @@ mpz_lcm_ui (mpz_t r, const mpz_t u, unsigned long v)
 int
 mpz_invert (mpz_t r, const mpz_t u, const mpz_t m)
 {
-  mpz_t g, tr;
+  mpz_t a, b, xa, xb;
   int invertible;
 
   if (u->_mp_size == 0 || mpz_cmpabs_ui (m, 1) <= 0)
     return 0;
 
-  mpz_init (g);
-  mpz_init (tr);
+  mpz_init (a);
+  mpz_init (b);
+  mpz_init (xa);
+  mpz_init_set_ui (xb, 1);
 
-  mpz_gcdext (g, tr, NULL, u, m);
-  invertible = (mpz_cmp_ui (g, 1) == 0);
+  /* Track a = xa u, b = xb u (mod m), starting from a = m, b = u. */
+  mpz_abs (a, m);
+  mpz_mod (b, u, a);
+
+  mpz_lehmer (a, b, xa, xb);
+  invertible = (mpz_cmp_ui (a, 1) == 0);
 
   if (invertible)
     {
-      if (tr->_mp_size < 0)
-	{
-	  if (m->_mp_size >= 0)
-	    mpz_add (tr, tr, m);
-	  else
-	    mpz_sub (tr, tr, m);
-	}
-      mpz_swap (r, tr);
+      mpz_abs (a, m);
+      mpz_mod (r, xa, a);
     }
 
-  mpz_clear (g);
-  mpz_clear (tr);
+  mpz_clear (a);
+  mpz_clear (b);
+  mpz_clear (xa);
+  mpz_clear (xb);
   return invertible;
 }
 
@@ -3041,15 +3341,42 @@ mpz_ui_pow_ui (mpz_t r, unsigned long blimb, unsigned long e)
   mpz_clear (b);
 }
 
+/* Window sizes for mpz_powm: use k + 1 bits once the exponent is
+   longer than gmp_powm_window_bits[k - 1]. */
+#define GMP_POWM_WINDOW_MAX 6
+
+static const mp_bitcnt_t gmp_powm_window_bits[GMP_POWM_WINDOW_MAX - 1] =
+  { 7, 25, 80, 240, 672 };
+
+static int
+mpn_powm_tstbit (mp_srcptr ep, mp_bitcnt_t bit)
+{
+  return (ep[bit / GMP_LIMB_BITS] >> (bit % GMP_LIMB_BITS)) & 1;
+}
+
+static void
+mpz_powm_reduce (mpz_t r, mp_srcptr mp, mp_size_t mn,
+		 const struct gmp_div_inverse *minv)
+{
+  /* Partially reduce r to at most mn limbs. */
+  if (r->_mp_size > mn)
+    {
+      mpn_div_qr_preinv (NULL, r->_mp_d, r->_mp_size, mp, mn, minv);
+      r->_mp_size = mpn_normalized_size (r->_mp_d, mn);
+    }
+}
+
 void
 mpz_powm (mpz_t r, const mpz_t b, const mpz_t e, const mpz_t m)
 {
   mpz_t tr;
   mpz_t base;
-  mp_size_t en, mn;
+  mpz_t table[1 << (GMP_POWM_WINDOW_MAX - 1)];
+  mp_size_t en, mn, tn, ti;
+  mp_bitcnt_t ebits, i;
   mp_srcptr mp;
   struct gmp_div_inverse minv;
-  unsigned shift;
+  unsigned shift, k;
   mp_ptr tp = NULL;
 
   en = GMP_ABS (e->_mp_size);
@@ -3110,27 +3437,69 @@ mpz_powm (mpz_t r, const mpz_t b, const mpz_t e, const mpz_t m)
     }
   mpz_init_set_ui (tr, 1);
 
-  while (--en >= 0)
+  /* Left-to-right sliding window over the odd powers of the base. */
+  ebits = (mp_bitcnt_t) (en - 1) * GMP_LIMB_BITS
+    + mpn_limb_size_in_base_2 (e->_mp_d[en - 1]);
+  k = 1;
+  while (k < GMP_POWM_WINDOW_MAX && ebits > gmp_powm_window_bits[k - 1])
+    k++;
+
+  tn = (mp_size_t) 1 << (k - 1);
+  for (ti = 0; ti < tn; ti++)
+    mpz_init (table[ti]);
+
+  mpz_set (table[0], base);
+  if (k > 1)
     {
-      mp_limb_t w = e->_mp_d[en];
-      mp_limb_t bit;
+      mpz_mul (tr, base, base);
+      mpz_powm_reduce (tr, mp, mn, &minv);
+      for (ti = 1; ti < tn; ti++)
+	{
+	  mpz_mul (table[ti], table[ti - 1], tr);
+	  mpz_powm_reduce (table[ti], mp, mn, &minv);
+	}
+      mpz_set_ui (tr, 1);
+    }
 
-      bit = GMP_LIMB_HIGHBIT;
-      do
+  i = ebits;
+  while (i > 0)
+    {
+      mp_bitcnt_t lo, j;
+      unsigned w;
+
+      if (!mpn_powm_tstbit (e->_mp_d, i - 1))
 	{
 	  mpz_mul (tr, tr, tr);
-	  if (w & bit)
-	    mpz_mul (tr, tr, base);
-	  if (tr->_mp_size > mn)
+	  mpz_powm_reduce (tr, mp, mn, &minv);
+	  i -= 1;
+	  continue;
+	}
+
+      /* Longest window of at most k bits ending in a one. */
+      lo = i > (mp_bitcnt_t) k ? i - k : 0;
+      while (!mpn_powm_tstbit (e->_mp_d, lo))
+	lo++;
+
+      w = 0;
+      for (j = i; j > lo; j--)
+	{
+	  w = (w << 1) | mpn_powm_tstbit (e->_mp_d, j - 1);
+	  if (tr->_mp_size != 1 || tr->_mp_d[0] != 1)
 	    {
-	      mpn_div_qr_preinv (NULL, tr->_mp_d, tr->_mp_size, mp, mn, &minv);
-	      tr->_mp_size = mpn_normalized_size (tr->_mp_d, mn);
+	      mpz_mul (tr, tr, tr);
+	      mpz_powm_reduce (tr, mp, mn, &minv);
 	    }
-	  bit >>= 1;
 	}
-      while (bit > 0);
+
+      mpz_mul (tr, tr, table[w >> 1]);
+      mpz_powm_reduce (tr, mp, mn, &minv);
+
+      i = lo;
     }
 
+  for (ti = 0; ti < tn; ti++)
+    mpz_clear (table[ti]);
+
   /* Final reduction */
   if (tr->_mp_size >= mn)
     {
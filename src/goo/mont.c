@@ -0,0 +1,1575 @@
+/*!
+ * mont.c - fixed-width montgomery arithmetic for C89
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ *
+ * Self-contained modular multiplication for the group hot loop, used
+ * regardless of which mpz library is linked. Products are computed with
+ * Karatsuba (and a dedicated squaring) down to a schoolbook base case,
+ * then reduced separately with word-by-word montgomery reduction.
+ *
+ * On CPUs with AVX-512 IFMA, 3072 and 4096 bit moduli instead keep
+ * elements as radix 2^52 digits and multiply with an interleaved
+ * (almost) montgomery multiplication, eight digits per vector.
+ *
+ * The goo_mont4_* functions work on four independent elements at once.
+ * With AVX2 (and no IFMA) they run a radix 2^26 multiplication with one
+ * element per 64 bit lane; otherwise they loop over the scalar kernels.
+ *
+ * Resources:
+ *   https://en.wikipedia.org/wiki/Montgomery_modular_multiplication
+ *   https://en.wikipedia.org/wiki/Karatsuba_algorithm
+ *   https://cacr.uwaterloo.ca/hac/about/chap14.pdf
+ *   https://eprint.iacr.org/2018/335.pdf
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "mont.h"
+
+#if GOO_LIMB_BITS == 64 && defined(__GNUC__) && defined(__x86_64__) \
+    && !defined(GOO_NO_ASM)
+#include <cpuid.h>
+#define GOO_MONT_HAVE_ADX
+#if defined(__clang__) || __GNUC__ >= 5
+#include <immintrin.h>
+#define GOO_MONT_HAVE_SIMD
+#endif
+#endif
+
+#if GOO_LIMB_BITS == 64
+__extension__ typedef unsigned __int128 goo_dlimb_t;
+#else
+typedef uint64_t goo_dlimb_t;
+#endif
+
+/* Below this many limbs, schoolbook wins. */
+#define GOO_MONT_KARATSUBA 16
+
+/* Karatsuba scratch: 2n + max(scratch(n / 2), n + 1) limbs. */
+#define GOO_MONT_SCRATCH (4 * GOO_MONT_MAX_LIMBS)
+
+/*
+ * Limb Vectors
+ */
+
+static goo_limb_t
+goo_mpn_add(goo_limb_t *r,
+            const goo_limb_t *a,
+            const goo_limb_t *b,
+            size_t n) {
+  goo_limb_t c = 0;
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    goo_dlimb_t s = (goo_dlimb_t)a[i] + b[i] + c;
+    r[i] = (goo_limb_t)s;
+    c = (goo_limb_t)(s >> GOO_LIMB_BITS);
+  }
+
+  return c;
+}
+
+static goo_limb_t
+goo_mpn_sub(goo_limb_t *r,
+            const goo_limb_t *a,
+            const goo_limb_t *b,
+            size_t n) {
+  goo_limb_t c = 0;
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    goo_dlimb_t s = (goo_dlimb_t)a[i] - b[i] - c;
+    r[i] = (goo_limb_t)s;
+    c = (goo_limb_t)(s >> GOO_LIMB_BITS) & 1;
+  }
+
+  return c;
+}
+
+static goo_limb_t
+goo_mpn_add_1(goo_limb_t *r, size_t n, goo_limb_t c) {
+  size_t i;
+
+  for (i = 0; i < n && c != 0; i++) {
+    r[i] += c;
+    c = r[i] < c;
+  }
+
+  return c;
+}
+
+static int
+goo_mpn_cmp(const goo_limb_t *a, const goo_limb_t *b, size_t n) {
+  while (n--) {
+    if (a[n] != b[n])
+      return a[n] < b[n] ? -1 : 1;
+  }
+
+  return 0;
+}
+
+typedef goo_limb_t goo_addmul_f(goo_limb_t *r,
+                                const goo_limb_t *a,
+                                size_t n,
+                                goo_limb_t b);
+
+static goo_limb_t
+goo_mpn_addmul_1(goo_limb_t *r, const goo_limb_t *a, size_t n, goo_limb_t b) {
+  goo_limb_t c = 0;
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    goo_dlimb_t s = (goo_dlimb_t)a[i] * b + r[i] + c;
+    r[i] = (goo_limb_t)s;
+    c = (goo_limb_t)(s >> GOO_LIMB_BITS);
+  }
+
+  return c;
+}
+
+#ifdef GOO_MONT_HAVE_ADX
+static goo_limb_t
+goo_mpn_addmul_1_adx(goo_limb_t *r,
+                     const goo_limb_t *a,
+                     size_t n,
+                     goo_limb_t b) {
+  /* Two independent carry chains: ADCX carries the high halves of the
+     previous products (CF), ADOX carries the additions into r (OF).
+     Only MOV, LEA and JRCXZ run between them, which leave both flags
+     alone. Four limbs per iteration, then one at a time. */
+  size_t q = n >> 2;
+  size_t m = n & 3;
+  goo_limb_t c = 0;
+  goo_limb_t lo, hi;
+
+  __asm__ __volatile__(
+    "xorl %k[lo], %k[lo]\n"
+    "jrcxz 2f\n"
+    "1:\n"
+    "mulxq 0(%[a]), %[lo], %[hi]\n"
+    "adcxq %[c], %[lo]\n"
+    "adoxq 0(%[r]), %[lo]\n"
+    "movq %[lo], 0(%[r])\n"
+    "mulxq 8(%[a]), %[lo], %[c]\n"
+    "adcxq %[hi], %[lo]\n"
+    "adoxq 8(%[r]), %[lo]\n"
+    "movq %[lo], 8(%[r])\n"
+    "mulxq 16(%[a]), %[lo], %[hi]\n"
+    "adcxq %[c], %[lo]\n"
+    "adoxq 16(%[r]), %[lo]\n"
+    "movq %[lo], 16(%[r])\n"
+    "mulxq 24(%[a]), %[lo], %[c]\n"
+    "adcxq %[hi], %[lo]\n"
+    "adoxq 24(%[r]), %[lo]\n"
+    "movq %[lo], 24(%[r])\n"
+    "leaq 32(%[a]), %[a]\n"
+    "leaq 32(%[r]), %[r]\n"
+    "leaq -1(%%rcx), %%rcx\n"
+    "jrcxz 2f\n"
+    "jmp 1b\n"
+    "2:\n"
+    "movq %[m], %%rcx\n"
+    "jrcxz 4f\n"
+    "3:\n"
+    "mulxq 0(%[a]), %[lo], %[hi]\n"
+    "adcxq %[c], %[lo]\n"
+    "adoxq 0(%[r]), %[lo]\n"
+    "movq %[lo], 0(%[r])\n"
+    "movq %[hi], %[c]\n"
+    "leaq 8(%[a]), %[a]\n"
+    "leaq 8(%[r]), %[r]\n"
+    "leaq -1(%%rcx), %%rcx\n"
+    "jrcxz 4f\n"
+    "jmp 3b\n"
+    "4:\n"
+    "movl $0, %k[lo]\n"
+    "adcxq %[lo], %[c]\n"
+    "adoxq %[lo], %[c]\n"
+    : [r] "+r" (r), [a] "+r" (a), [c] "+r" (c),
+      [lo] "=&r" (lo), [hi] "=&r" (hi), "+c" (q)
+    : [m] "r" (m), "d" (b)
+    : "cc", "memory"
+  );
+
+  return c;
+}
+
+/*
+ * CPU Features
+ */
+
+#ifdef GOO_MONT_HAVE_SIMD
+static unsigned int
+goo_cpu_xcr0(void) {
+  /* Register state the OS saves (0 without OSXSAVE). */
+  unsigned int eax, ebx, ecx, edx, lo, hi;
+
+  __cpuid(1, eax, ebx, ecx, edx);
+
+  if (((ecx >> 27) & 1) == 0)
+    return 0;
+
+  __asm__ __volatile__("xgetbv" : "=a" (lo), "=d" (hi) : "c" (0));
+
+  (void)hi;
+
+  return lo;
+}
+#endif
+#endif
+
+static goo_addmul_f *
+goo_mont_addmul(const goo_mont_t *mont) {
+#ifdef GOO_MONT_HAVE_ADX
+  if (mont->adx)
+    return goo_mpn_addmul_1_adx;
+#endif
+  (void)mont;
+  return goo_mpn_addmul_1;
+}
+
+/*
+ * Multiplication
+ */
+
+static void
+goo_mpn_mul_basecase(goo_addmul_f *addmul,
+                     goo_limb_t *r,
+                     const goo_limb_t *a,
+                     const goo_limb_t *b,
+                     size_t n) {
+  size_t i;
+
+  memset(r, 0, n * sizeof(goo_limb_t));
+
+  for (i = 0; i < n; i++)
+    r[i + n] = addmul(r + i, a, n, b[i]);
+}
+
+static void
+goo_mpn_sqr_basecase(goo_addmul_f *addmul,
+                     goo_limb_t *r,
+                     const goo_limb_t *a,
+                     size_t n) {
+  goo_limb_t c = 0;
+  size_t i;
+
+  memset(r, 0, 2 * n * sizeof(goo_limb_t));
+
+  /* Cross products, once. */
+  for (i = 0; i + 1 < n; i++)
+    r[i + n] = addmul(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+
+  /* Double them. */
+  for (i = 0; i < 2 * n; i++) {
+    goo_limb_t x = r[i];
+    r[i] = (x << 1) | c;
+    c = x >> (GOO_LIMB_BITS - 1);
+  }
+
+  /* Add the squares. */
+  c = 0;
+
+  for (i = 0; i < n; i++) {
+    goo_dlimb_t s = (goo_dlimb_t)a[i] * a[i];
+    goo_dlimb_t lo = (goo_dlimb_t)r[2 * i] + (goo_limb_t)s + c;
+    goo_dlimb_t hi = (goo_dlimb_t)r[2 * i + 1]
+                   + (goo_limb_t)(s >> GOO_LIMB_BITS)
+                   + (goo_limb_t)(lo >> GOO_LIMB_BITS);
+
+    r[2 * i] = (goo_limb_t)lo;
+    r[2 * i + 1] = (goo_limb_t)hi;
+    c = (goo_limb_t)(hi >> GOO_LIMB_BITS);
+  }
+
+  assert(c == 0);
+}
+
+static void
+goo_mpn_absdiff(goo_limb_t *r,
+                int *sign,
+                const goo_limb_t *a,
+                const goo_limb_t *b,
+                size_t n) {
+  if (goo_mpn_cmp(a, b, n) >= 0) {
+    goo_mpn_sub(r, a, b, n);
+  } else {
+    goo_mpn_sub(r, b, a, n);
+    *sign ^= 1;
+  }
+}
+
+static void
+goo_mpn_karatsuba_fold(goo_limb_t *r,
+                       goo_limb_t *m,
+                       const goo_limb_t *p,
+                       int sign,
+                       size_t h) {
+  /* r = z0 + z2 * B^2h (in place), p = |z1'|.
+     Add (z0 + z2 -/+ p) * B^h into r. */
+  goo_limb_t c;
+
+  m[2 * h] = goo_mpn_add(m, r, r + 2 * h, 2 * h);
+
+  if (sign)
+    m[2 * h] -= goo_mpn_sub(m, m, p, 2 * h);
+  else
+    m[2 * h] += goo_mpn_add(m, m, p, 2 * h);
+
+  c = goo_mpn_add(r + h, r + h, m, 2 * h + 1);
+  c = goo_mpn_add_1(r + 3 * h + 1, h - 1, c);
+
+  assert(c == 0);
+  (void)c;
+}
+
+static void
+goo_mpn_mul(goo_addmul_f *addmul,
+            goo_limb_t *r,
+            const goo_limb_t *a,
+            const goo_limb_t *b,
+            size_t n,
+            goo_limb_t *tmp) {
+  goo_limb_t *da, *db, *p, *m;
+  int sign = 0;
+  size_t h;
+
+  if (n < GOO_MONT_KARATSUBA || (n & 1)) {
+    goo_mpn_mul_basecase(addmul, r, a, b, n);
+    return;
+  }
+
+  h = n >> 1;
+  da = tmp;
+  db = tmp + h;
+  p = tmp + 2 * h;
+  m = tmp + 4 * h;
+
+  /* (a0 - a1) * (b1 - b0) = a0 b1 + a1 b0 - z0 - z2 */
+  goo_mpn_absdiff(da, &sign, a, a + h, h);
+  goo_mpn_absdiff(db, &sign, b + h, b, h);
+
+  goo_mpn_mul(addmul, r, a, b, h, m);
+  goo_mpn_mul(addmul, r + 2 * h, a + h, b + h, h, m);
+  goo_mpn_mul(addmul, p, da, db, h, m);
+
+  goo_mpn_karatsuba_fold(r, m, p, sign, h);
+}
+
+static void
+goo_mpn_sqr(goo_addmul_f *addmul,
+            goo_limb_t *r,
+            const goo_limb_t *a,
+            size_t n,
+            goo_limb_t *tmp) {
+  goo_limb_t *d, *p, *m;
+  int sign = 0;
+  size_t h;
+
+  if (n < GOO_MONT_KARATSUBA || (n & 1)) {
+    goo_mpn_sqr_basecase(addmul, r, a, n);
+    return;
+  }
+
+  h = n >> 1;
+  d = tmp;
+  p = tmp + 2 * h;
+  m = tmp + 4 * h;
+
+  /* (a0 - a1)^2 = z0 + z2 - 2 a0 a1 */
+  goo_mpn_absdiff(d, &sign, a, a + h, h);
+
+  goo_mpn_sqr(addmul, r, a, h, m);
+  goo_mpn_sqr(addmul, r + 2 * h, a + h, h, m);
+  goo_mpn_sqr(addmul, p, d, h, m);
+
+  goo_mpn_karatsuba_fold(r, m, p, 1, h);
+}
+
+/*
+ * Reduction
+ */
+
+static void
+goo_mpn_redc(goo_addmul_f *addmul,
+             goo_limb_t *r,
+             goo_limb_t *t,
+             const goo_limb_t *m,
+             goo_limb_t k,
+             size_t n) {
+  /* r = t / R mod m, where t < m * R (t is clobbered) */
+  goo_limb_t c2 = 0;
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    goo_limb_t u = t[i] * k;
+    goo_limb_t c = addmul(t + i, m, n, u);
+    goo_dlimb_t s = (goo_dlimb_t)t[i + n] + c + c2;
+
+    t[i + n] = (goo_limb_t)s;
+    c2 = (goo_limb_t)(s >> GOO_LIMB_BITS);
+  }
+
+  if (c2 != 0 || goo_mpn_cmp(t + n, m, n) >= 0)
+    goo_mpn_sub(r, t + n, m, n);
+  else
+    memcpy(r, t + n, n * sizeof(goo_limb_t));
+}
+
+static void
+goo_mpn_double(goo_limb_t *x, const goo_limb_t *m, size_t n) {
+  /* x = 2 * x mod m */
+  goo_limb_t c = 0;
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    goo_limb_t y = x[i];
+    x[i] = (y << 1) | c;
+    c = y >> (GOO_LIMB_BITS - 1);
+  }
+
+  if (c != 0 || goo_mpn_cmp(x, m, n) >= 0)
+    goo_mpn_sub(x, x, m, n);
+}
+
+static goo_limb_t
+goo_mpn_inverse(goo_limb_t x) {
+  /* -x^-1 mod 2^w (newton, doubling the correct bits). */
+  goo_limb_t inv = x;
+  size_t i;
+
+  for (i = 0; i < 5; i++)
+    inv *= 2 - x * inv;
+
+  return -inv;
+}
+
+static void
+goo_mont_redc(const goo_mont_t *mont, goo_limb_t *r, goo_limb_t *t) {
+  goo_mpn_redc(goo_mont_addmul(mont), r, t, mont->n, mont->k, mont->limbs);
+}
+
+static void
+goo_mont_double(const goo_mont_t *mont, goo_limb_t *x) {
+  goo_mpn_double(x, mont->n, mont->limbs);
+}
+
+/*
+ * IFMA
+ */
+
+#ifdef GOO_MONT_HAVE_SIMD
+#define GOO_IFMA_TARGET __attribute__((target("avx512f,avx512ifma")))
+#define GOO_IFMA_MASK (((goo_limb_t)1 << 52) - 1)
+#define GOO_IFMA_VECS (GOO_MONT_MAX_LIMBS / 8)
+
+static GOO_IFMA_TARGET __inline__ __attribute__((always_inline)) void
+goo_ifma_amm(goo_limb_t *out,
+             const goo_limb_t *a,
+             const goo_limb_t *b,
+             const goo_limb_t *n,
+             goo_limb_t k,
+             size_t vecs) {
+  /* out = a * b / 2^(52 * d) mod 2n, for a, b < 2n and 4n < 2^(52 * d).
+   *
+   * One digit of `b` per step. The low halves of a * b[i] and n * m
+   * clear digit 0, the accumulator shifts down a digit, then the high
+   * halves land in place. Lanes are left unnormalized (each gains less
+   * than 2^54 per step) and carried once at the end.
+   */
+  __m512i A[GOO_IFMA_VECS];
+  __m512i N[GOO_IFMA_VECS];
+  __m512i R[GOO_IFMA_VECS];
+  __m512i zero = _mm512_setzero_si512();
+  goo_limb_t t[GOO_MONT_MAX_LIMBS];
+  size_t d = vecs * 8;
+  goo_limb_t c;
+  size_t i, j;
+
+  for (j = 0; j < vecs; j++) {
+    A[j] = _mm512_loadu_si512((const void *)&a[j * 8]);
+    N[j] = _mm512_loadu_si512((const void *)&n[j * 8]);
+    R[j] = zero;
+  }
+
+  for (i = 0; i < d; i++) {
+    goo_limb_t r0 = _mm_cvtsi128_si64(_mm512_castsi512_si128(R[0]));
+    goo_limb_t m = ((r0 + a[0] * b[i]) * k) & GOO_IFMA_MASK;
+    __m512i bi = _mm512_set1_epi64(b[i]);
+    __m512i mi = _mm512_set1_epi64(m);
+    __m512i cy;
+
+    for (j = 0; j < vecs; j++) {
+      R[j] = _mm512_madd52lo_epu64(R[j], A[j], bi);
+      R[j] = _mm512_madd52lo_epu64(R[j], N[j], mi);
+    }
+
+    cy = _mm512_maskz_srli_epi64(1, R[0], 52);
+
+    for (j = 0; j + 1 < vecs; j++)
+      R[j] = _mm512_alignr_epi64(R[j + 1], R[j], 1);
+
+    R[vecs - 1] = _mm512_alignr_epi64(zero, R[vecs - 1], 1);
+    R[0] = _mm512_add_epi64(R[0], cy);
+
+    for (j = 0; j < vecs; j++) {
+      R[j] = _mm512_madd52hi_epu64(R[j], A[j], bi);
+      R[j] = _mm512_madd52hi_epu64(R[j], N[j], mi);
+    }
+  }
+
+  for (j = 0; j < vecs; j++)
+    _mm512_storeu_si512((void *)&t[j * 8], R[j]);
+
+  c = 0;
+
+  for (i = 0; i < d; i++) {
+    c += t[i];
+    out[i] = c & GOO_IFMA_MASK;
+    c >>= 52;
+  }
+
+  assert(c == 0);
+}
+
+static GOO_IFMA_TARGET void
+goo_ifma_mul_3072(const goo_mont_t *mont,
+                  goo_limb_t *out,
+                  const goo_limb_t *a,
+                  const goo_limb_t *b) {
+  goo_ifma_amm(out, a, b, mont->n, mont->k, 8);
+}
+
+static GOO_IFMA_TARGET void
+goo_ifma_mul_4096(const goo_mont_t *mont,
+                  goo_limb_t *out,
+                  const goo_limb_t *a,
+                  const goo_limb_t *b) {
+  goo_ifma_amm(out, a, b, mont->n, mont->k, 10);
+}
+
+static void
+goo_ifma_mul(const goo_mont_t *mont,
+             goo_limb_t *out,
+             const goo_limb_t *a,
+             const goo_limb_t *b) {
+  if (mont->limbs == 64)
+    goo_ifma_mul_3072(mont, out, a, b);
+  else
+    goo_ifma_mul_4096(mont, out, a, b);
+}
+
+static size_t
+goo_ifma_digits(size_t width) {
+  /* Digits per element: 4n < 2^(52 * d), rounded up to whole vectors. */
+  return width == 3072 ? 64 : 80;
+}
+
+#endif
+
+/*
+ * AVX2
+ */
+
+#ifdef GOO_MONT_HAVE_SIMD
+#define GOO_AVX2_TARGET __attribute__((target("avx2")))
+#define GOO_AVX2_MASK (((goo_limb_t)1 << 26) - 1)
+
+static size_t
+goo_avx2_digits(size_t width) {
+  /* Digits per lane: 4n < 2^(26 * d), rounded up to blocks of four. */
+  return (((width + 2 + 25) / 26) + 3) & ~(size_t)3;
+}
+
+static GOO_AVX2_TARGET __inline__ __m256i
+goo_avx2_row(const goo_limb_t *const *b, size_t i, int same) {
+  /* Digit i of lane j comes from b[j]. */
+  if (same)
+    return _mm256_loadu_si256((const __m256i *)&b[0][i * 4]);
+
+  return _mm256_set_epi64x(b[3][i * 4 + 3], b[2][i * 4 + 2],
+                           b[1][i * 4 + 1], b[0][i * 4 + 0]);
+}
+
+static GOO_AVX2_TARGET void
+goo_avx2_amm4(goo_limb_t *out,
+              const goo_limb_t *a,
+              const goo_limb_t *const *b,
+              const goo_limb_t *n,
+              goo_limb_t k,
+              size_t d) {
+  /* Four independent products, one per 64 bit lane:
+   *
+   *   out = a * b / 2^(26 * d) mod 2n, for a, b < 2n and 4n < 2^(26 * d)
+   *
+   * Digit i of lane j lives at 4 * i + j; `n` is a single lane and is
+   * broadcast. Rows of b are taken four at a time, so every pass over
+   * a and n feeds eight products into each column before it is stored.
+   * Columns stay below 2^61 and are carried once at the end.
+   */
+  __m256i t[2 * GOO_MONT4_MAX_DIGITS + 4];
+  __m256i mask = _mm256_set1_epi64x(GOO_AVX2_MASK);
+  __m256i kv = _mm256_set1_epi64x(k);
+  __m256i c = _mm256_setzero_si256();
+  int same = b[0] == b[1] && b[1] == b[2] && b[2] == b[3];
+  size_t i, r, q, s;
+
+  for (i = 0; i < 2 * d + 4; i++)
+    t[i] = c;
+
+  for (i = 0; i < d; i += 4) {
+    __m256i bv[4], mv[4];
+    __m256i a1, a2, a3, n1, n2, n3;
+
+    /* Clear digits i..i+3, picking each multiplier in turn. */
+    for (r = 0; r < 4; r++) {
+      __m256i x = t[i + r];
+
+      bv[r] = goo_avx2_row(b, i + r, same);
+
+      for (q = 0; q < r; q++) {
+        __m256i aq = _mm256_loadu_si256((const __m256i *)&a[(r - q) * 4]);
+        __m256i nq = _mm256_set1_epi64x(n[r - q]);
+
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(aq, bv[q]));
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(nq, mv[q]));
+      }
+
+      x = _mm256_add_epi64(x,
+        _mm256_mul_epu32(_mm256_loadu_si256((const __m256i *)a), bv[r]));
+
+      mv[r] = _mm256_and_si256(_mm256_mul_epu32(x, kv), mask);
+
+      x = _mm256_add_epi64(x,
+        _mm256_mul_epu32(_mm256_set1_epi64x(n[0]), mv[r]));
+
+      t[i + r + 1] = _mm256_add_epi64(t[i + r + 1], _mm256_srli_epi64(x, 26));
+    }
+
+    /* All four rows, sliding a and n through registers. */
+    a1 = _mm256_loadu_si256((const __m256i *)&a[3 * 4]);
+    a2 = _mm256_loadu_si256((const __m256i *)&a[2 * 4]);
+    a3 = _mm256_loadu_si256((const __m256i *)&a[1 * 4]);
+    n1 = _mm256_set1_epi64x(n[3]);
+    n2 = _mm256_set1_epi64x(n[2]);
+    n3 = _mm256_set1_epi64x(n[1]);
+
+    for (s = 4; s < d; s++) {
+      __m256i a0 = _mm256_loadu_si256((const __m256i *)&a[s * 4]);
+      __m256i n0 = _mm256_set1_epi64x(n[s]);
+      __m256i x = t[i + s];
+
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(a0, bv[0]));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(n0, mv[0]));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(a1, bv[1]));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(n1, mv[1]));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(a2, bv[2]));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(n2, mv[2]));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(a3, bv[3]));
+      x = _mm256_add_epi64(x, _mm256_mul_epu32(n3, mv[3]));
+
+      t[i + s] = x;
+
+      a3 = a2;
+      a2 = a1;
+      a1 = a0;
+      n3 = n2;
+      n2 = n1;
+      n1 = n0;
+    }
+
+    /* The rows which still reach past digit d - 1. */
+    for (s = d; s < d + 3; s++) {
+      __m256i x = t[i + s];
+
+      for (r = s - d + 1; r < 4; r++) {
+        __m256i ar = _mm256_loadu_si256((const __m256i *)&a[(s - r) * 4]);
+        __m256i nr = _mm256_set1_epi64x(n[s - r]);
+
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(ar, bv[r]));
+        x = _mm256_add_epi64(x, _mm256_mul_epu32(nr, mv[r]));
+      }
+
+      t[i + s] = x;
+    }
+  }
+
+  for (s = 0; s < d; s++) {
+    __m256i v = _mm256_add_epi64(t[d + s], c);
+
+    _mm256_storeu_si256((__m256i *)&out[s * 4], _mm256_and_si256(v, mask));
+
+    c = _mm256_srli_epi64(v, 26);
+  }
+}
+
+static GOO_AVX2_TARGET void
+goo_avx2_amm4x(goo_limb_t *out,
+               const goo_limb_t *a,
+               const goo_limb_t *const *b,
+               const goo_limb_t *n,
+               const goo_limb_t *k) {
+  /* As goo_avx2_amm4, for GOO_SMONT4_DIGITS digits with a modulus (and
+   * k) per lane, laid out like the operands. Everything fits in
+   * registers, so rows are taken one at a time.
+   */
+  __m256i t[GOO_SMONT4_DIGITS];
+  __m256i av[GOO_SMONT4_DIGITS];
+  __m256i nv[GOO_SMONT4_DIGITS];
+  __m256i mask = _mm256_set1_epi64x(GOO_AVX2_MASK);
+  __m256i kv = _mm256_loadu_si256((const __m256i *)k);
+  __m256i c = _mm256_setzero_si256();
+  int same = b[0] == b[1] && b[1] == b[2] && b[2] == b[3];
+  size_t i, j;
+
+  for (j = 0; j < GOO_SMONT4_DIGITS; j++) {
+    av[j] = _mm256_loadu_si256((const __m256i *)&a[j * 4]);
+    nv[j] = _mm256_loadu_si256((const __m256i *)&n[j * 4]);
+    t[j] = c;
+  }
+
+  for (i = 0; i < GOO_SMONT4_DIGITS; i++) {
+    __m256i bv = goo_avx2_row(b, i, same);
+    __m256i x = _mm256_add_epi64(t[0], _mm256_mul_epu32(av[0], bv));
+    __m256i m = _mm256_and_si256(_mm256_mul_epu32(x, kv), mask);
+
+    x = _mm256_add_epi64(x, _mm256_mul_epu32(nv[0], m));
+    x = _mm256_srli_epi64(x, 26);
+
+    for (j = 1; j < GOO_SMONT4_DIGITS; j++) {
+      __m256i y = _mm256_add_epi64(t[j], _mm256_mul_epu32(av[j], bv));
+      t[j - 1] = _mm256_add_epi64(y, _mm256_mul_epu32(nv[j], m));
+    }
+
+    t[0] = _mm256_add_epi64(t[0], x);
+    t[GOO_SMONT4_DIGITS - 1] = _mm256_setzero_si256();
+  }
+
+  for (j = 0; j < GOO_SMONT4_DIGITS; j++) {
+    __m256i v = _mm256_add_epi64(t[j], c);
+
+    _mm256_storeu_si256((__m256i *)&out[j * 4], _mm256_and_si256(v, mask));
+
+    c = _mm256_srli_epi64(v, 26);
+  }
+}
+#endif
+
+/*
+ * Radix Conversion
+ */
+
+#ifdef GOO_MONT_HAVE_SIMD
+static void
+goo_radix_split(goo_limb_t *r,
+                size_t d,
+                unsigned int bits,
+                const goo_limb_t *x,
+                size_t n) {
+  /* Regroup n 64 bit limbs into d digits of `bits` bits. */
+  goo_limb_t mask = ((goo_limb_t)1 << bits) - 1;
+  size_t i;
+
+  for (i = 0; i < d; i++) {
+    size_t w = (i * bits) / 64;
+    size_t s = (i * bits) % 64;
+    goo_limb_t v = 0;
+
+    if (w < n) {
+      v = x[w] >> s;
+
+      if (s > 64 - bits && w + 1 < n)
+        v |= x[w + 1] << (64 - s);
+    }
+
+    r[i] = v & mask;
+  }
+}
+
+static size_t
+goo_radix_join(goo_limb_t *r,
+               const goo_limb_t *x,
+               size_t d,
+               unsigned int bits) {
+  /* Inverse of goo_radix_split, returns the number of limbs. */
+  size_t n = (d * bits + 63) / 64;
+  size_t i;
+
+  memset(r, 0, n * sizeof(goo_limb_t));
+
+  for (i = 0; i < d; i++) {
+    size_t w = (i * bits) / 64;
+    size_t s = (i * bits) % 64;
+
+    r[w] |= x[i] << s;
+
+    if (s > 64 - bits)
+      r[w + 1] |= x[i] >> (64 - s);
+  }
+
+  return n;
+}
+
+static void
+goo_radix_reduce(goo_limb_t *x,
+                 const goo_limb_t *n,
+                 size_t d,
+                 unsigned int bits) {
+  /* x = x mod n, for x < 2n */
+  goo_limb_t mask = ((goo_limb_t)1 << bits) - 1;
+  goo_limb_t y[GOO_MONT4_MAX_DIGITS];
+  goo_limb_t b = 0;
+  size_t i;
+
+  for (i = 0; i < d; i++) {
+    goo_limb_t v = x[i] - n[i] - b;
+    y[i] = v & mask;
+    b = v >> 63;
+  }
+
+  if (b == 0)
+    memcpy(x, y, d * sizeof(goo_limb_t));
+}
+#endif
+
+static void
+goo_limbs_import(goo_limb_t *x, const unsigned char *raw, size_t raw_len) {
+  /* x must be zeroed, and hold raw_len bytes. */
+  size_t i;
+
+  for (i = 0; i < raw_len; i++) {
+    size_t j = raw_len - 1 - i;
+    x[j / sizeof(goo_limb_t)] |=
+      (goo_limb_t)raw[i] << ((j % sizeof(goo_limb_t)) * 8);
+  }
+}
+
+static void
+goo_limbs_export(unsigned char *raw,
+                 size_t raw_len,
+                 const goo_limb_t *x,
+                 size_t n) {
+  size_t i;
+
+  for (i = 0; i < raw_len; i++) {
+    size_t j = raw_len - 1 - i;
+
+    if (j / sizeof(goo_limb_t) < n)
+      raw[i] = x[j / sizeof(goo_limb_t)] >> ((j % sizeof(goo_limb_t)) * 8);
+    else
+      raw[i] = 0;
+  }
+}
+
+/*
+ * Montgomery
+ */
+
+unsigned int
+goo_mont_cpu(void) {
+  unsigned int cpu = 0;
+#ifdef GOO_MONT_HAVE_ADX
+  unsigned int eax, ebx, ecx, edx;
+
+  if (__get_cpuid_max(0, NULL) < 7)
+    return 0;
+
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+
+  /* BMI2 (MULX) and ADX (ADCX/ADOX). */
+  if (((ebx >> 8) & 1) && ((ebx >> 19) & 1))
+    cpu |= GOO_MONT_ADX;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  {
+    unsigned int xcr0 = goo_cpu_xcr0();
+
+    /* AVX2, with YMM state enabled. */
+    if (((ebx >> 5) & 1) && (xcr0 & 0x06) == 0x06)
+      cpu |= GOO_MONT_AVX2;
+
+    /* AVX-512F and AVX-512 IFMA, with opmask and ZMM state enabled. */
+    if (((ebx >> 16) & 1) && ((ebx >> 21) & 1) && (xcr0 & 0xe6) == 0xe6)
+      cpu |= GOO_MONT_IFMA;
+  }
+#endif
+#endif
+
+  return cpu;
+}
+
+int
+goo_mont_init(goo_mont_t *mont, const unsigned char *n, size_t n_len) {
+  return goo_mont_init_cpu(mont, n, n_len, goo_mont_cpu());
+}
+
+int
+goo_mont_init_cpu(goo_mont_t *mont,
+                  const unsigned char *n,
+                  size_t n_len,
+                  unsigned int cpu) {
+  size_t bits, width, rbits, i;
+
+  while (n_len > 0 && n[0] == 0x00) {
+    n += 1;
+    n_len -= 1;
+  }
+
+  if (n_len == 0 || (n[n_len - 1] & 1) == 0)
+    return 0;
+
+  bits = n_len * 8;
+
+  for (i = 0x80; (n[0] & i) == 0; i >>= 1)
+    bits -= 1;
+
+  if (bits <= 2048)
+    width = 2048;
+  else if (bits <= 3072)
+    width = 3072;
+  else if (bits <= 4096)
+    width = 4096;
+  else
+    return 0;
+
+  memset(mont, 0, sizeof(goo_mont_t));
+
+  mont->limbs = width / GOO_LIMB_BITS;
+  rbits = width;
+
+#ifdef GOO_MONT_HAVE_ADX
+  mont->adx = (cpu & GOO_MONT_ADX) != 0;
+#endif
+
+#ifdef GOO_MONT_HAVE_SIMD
+  mont->ifma = (cpu & GOO_MONT_IFMA) != 0 && width >= 3072;
+
+  if (mont->ifma)
+    rbits = goo_ifma_digits(width) * 52;
+
+  mont->avx2 = (cpu & GOO_MONT_AVX2) != 0 && !mont->ifma;
+#endif
+
+  (void)cpu;
+
+  goo_limbs_import(mont->n, n, n_len);
+
+  mont->k = goo_mpn_inverse(mont->n[0]);
+
+  /* one = R mod n, r2 = R^2 mod n */
+  mont->one[0] = 1;
+
+  for (i = 0; i < rbits; i++)
+    goo_mont_double(mont, mont->one);
+
+  memcpy(mont->r2, mont->one, sizeof(mont->one));
+
+  for (i = 0; i < rbits; i++)
+    goo_mont_double(mont, mont->r2);
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->avx2) {
+    size_t d = goo_avx2_digits(width);
+    goo_limb_t x[GOO_MONT_MAX_LIMBS];
+
+    /* Same again for the four-lane radix, 2^(26 * d). */
+    memset(x, 0, sizeof(x));
+    x[0] = 1;
+
+    for (i = 0; i < d * 26; i++)
+      goo_mont_double(mont, x);
+
+    goo_radix_split(mont->one26, d, 26, x, mont->limbs);
+
+    for (i = 0; i < d * 26; i++)
+      goo_mont_double(mont, x);
+
+    goo_radix_split(mont->r2_26, d, 26, x, mont->limbs);
+    goo_radix_split(mont->n26, d, 26, mont->n, mont->limbs);
+
+    mont->k26 = mont->k & GOO_AVX2_MASK;
+    mont->digits = d;
+  }
+
+  if (mont->ifma) {
+    size_t d = goo_ifma_digits(width);
+    goo_limb_t x[GOO_MONT_MAX_LIMBS];
+
+    memcpy(x, mont->n, sizeof(x));
+    goo_radix_split(mont->n, d, 52, x, mont->limbs);
+
+    memcpy(x, mont->one, sizeof(x));
+    goo_radix_split(mont->one, d, 52, x, mont->limbs);
+
+    memcpy(x, mont->r2, sizeof(x));
+    goo_radix_split(mont->r2, d, 52, x, mont->limbs);
+
+    mont->k &= GOO_IFMA_MASK;
+    mont->limbs = d;
+  }
+#endif
+
+  return 1;
+}
+
+void
+goo_mont_import(const goo_mont_t *mont,
+                goo_limb_t *out,
+                const unsigned char *raw,
+                size_t raw_len) {
+  goo_limb_t x[GOO_MONT_MAX_LIMBS];
+
+  assert(raw_len <= mont->limbs * sizeof(goo_limb_t));
+
+  memset(x, 0, sizeof(x));
+
+  goo_limbs_import(x, raw, raw_len);
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->ifma) {
+    goo_limb_t y[GOO_MONT_MAX_LIMBS];
+
+    goo_radix_split(y, mont->limbs, 52, x, GOO_MONT_MAX_LIMBS);
+    goo_ifma_mul(mont, out, y, mont->r2);
+
+    return;
+  }
+#endif
+
+  goo_mont_mul(mont, out, x, mont->r2);
+}
+
+void
+goo_mont_export(const goo_mont_t *mont,
+                unsigned char *raw,
+                size_t raw_len,
+                const goo_limb_t *x) {
+  goo_limb_t t[2 * GOO_MONT_MAX_LIMBS];
+  size_t n = mont->limbs;
+
+  memset(t, 0, sizeof(t));
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->ifma) {
+    goo_limb_t y[GOO_MONT_MAX_LIMBS];
+
+    memset(y, 0, sizeof(y));
+    y[0] = 1;
+
+    goo_ifma_mul(mont, y, x, y);
+    goo_radix_reduce(y, mont->n, n, 52);
+
+    n = goo_radix_join(t, y, n, 52);
+  } else
+#endif
+  {
+    memcpy(t, x, n * sizeof(goo_limb_t));
+    goo_mont_redc(mont, t, t);
+  }
+
+  goo_limbs_export(raw, raw_len, t, n);
+}
+
+void
+goo_mont_set_one(const goo_mont_t *mont, goo_limb_t *out) {
+  memcpy(out, mont->one, mont->limbs * sizeof(goo_limb_t));
+}
+
+void
+goo_mont_copy(const goo_mont_t *mont, goo_limb_t *out, const goo_limb_t *x) {
+  memcpy(out, x, mont->limbs * sizeof(goo_limb_t));
+}
+
+void
+goo_mont_mul(const goo_mont_t *mont,
+             goo_limb_t *out,
+             const goo_limb_t *a,
+             const goo_limb_t *b) {
+  goo_limb_t t[2 * GOO_MONT_MAX_LIMBS];
+  goo_limb_t tmp[GOO_MONT_SCRATCH];
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->ifma) {
+    goo_ifma_mul(mont, out, a, b);
+    return;
+  }
+#endif
+
+  goo_mpn_mul(goo_mont_addmul(mont), t, a, b, mont->limbs, tmp);
+  goo_mont_redc(mont, out, t);
+}
+
+void
+goo_mont_sqr(const goo_mont_t *mont, goo_limb_t *out, const goo_limb_t *a) {
+  goo_limb_t t[2 * GOO_MONT_MAX_LIMBS];
+  goo_limb_t tmp[GOO_MONT_SCRATCH];
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->ifma) {
+    goo_ifma_mul(mont, out, a, a);
+    return;
+  }
+#endif
+
+  goo_mpn_sqr(goo_mont_addmul(mont), t, a, mont->limbs, tmp);
+  goo_mont_redc(mont, out, t);
+}
+
+/*
+ * Four Lanes
+ */
+
+#ifdef GOO_MONT_HAVE_SIMD
+static void
+goo_mont4_spread(const goo_mont_t *mont, goo_limb_t *out, const goo_limb_t *x) {
+  /* Copy one radix 2^26 element into all four lanes. */
+  size_t i;
+
+  for (i = 0; i < mont->digits; i++) {
+    out[i * 4 + 0] = x[i];
+    out[i * 4 + 1] = x[i];
+    out[i * 4 + 2] = x[i];
+    out[i * 4 + 3] = x[i];
+  }
+}
+#endif
+
+size_t
+goo_mont4_words(const goo_mont_t *mont) {
+  if (mont->avx2)
+    return 4 * mont->digits;
+
+  return 4 * mont->limbs;
+}
+
+void
+goo_mont4_import(const goo_mont_t *mont,
+                 goo_limb_t *out,
+                 const unsigned char *raw,
+                 size_t raw_len) {
+  size_t k;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->avx2) {
+    goo_limb_t x[GOO_MONT_MAX_LIMBS];
+    goo_limb_t y[GOO_MONT4_MAX_DIGITS];
+    goo_limb_t z[GOO_MONT4_MAX_WORDS];
+    goo_limb_t r2[GOO_MONT4_MAX_WORDS];
+    const goo_limb_t *b[4];
+    size_t i;
+
+    assert(raw_len <= GOO_MONT_MAX_BITS / 8);
+
+    for (k = 0; k < 4; k++) {
+      memset(x, 0, sizeof(x));
+
+      goo_limbs_import(x, raw + k * raw_len, raw_len);
+      goo_radix_split(y, mont->digits, 26, x, GOO_MONT_MAX_LIMBS);
+
+      for (i = 0; i < mont->digits; i++)
+        z[i * 4 + k] = y[i];
+    }
+
+    goo_mont4_spread(mont, r2, mont->r2_26);
+
+    b[0] = b[1] = b[2] = b[3] = r2;
+
+    goo_avx2_amm4(out, z, b, mont->n26, mont->k26, mont->digits);
+
+    return;
+  }
+#endif
+
+  for (k = 0; k < 4; k++) {
+    goo_mont_import(mont, out + k * mont->limbs,
+                    raw + k * raw_len, raw_len);
+  }
+}
+
+void
+goo_mont4_export(const goo_mont_t *mont,
+                 unsigned char *raw,
+                 size_t raw_len,
+                 const goo_limb_t *x) {
+  size_t k;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->avx2) {
+    goo_limb_t t[GOO_MONT_MAX_LIMBS + 1];
+    goo_limb_t y[GOO_MONT4_MAX_DIGITS];
+    goo_limb_t z[GOO_MONT4_MAX_WORDS];
+    goo_limb_t e[GOO_MONT4_MAX_WORDS];
+    const goo_limb_t *b[4];
+    size_t i, n;
+
+    /* Multiply by one to leave montgomery form (result <= n). */
+    memset(e, 0, sizeof(e));
+
+    e[0] = e[1] = e[2] = e[3] = 1;
+    b[0] = b[1] = b[2] = b[3] = e;
+
+    goo_avx2_amm4(z, x, b, mont->n26, mont->k26, mont->digits);
+
+    for (k = 0; k < 4; k++) {
+      for (i = 0; i < mont->digits; i++)
+        y[i] = z[i * 4 + k];
+
+      goo_radix_reduce(y, mont->n26, mont->digits, 26);
+
+      n = goo_radix_join(t, y, mont->digits, 26);
+
+      goo_limbs_export(raw + k * raw_len, raw_len, t, n);
+    }
+
+    return;
+  }
+#endif
+
+  for (k = 0; k < 4; k++) {
+    goo_mont_export(mont, raw + k * raw_len, raw_len,
+                    x + k * mont->limbs);
+  }
+}
+
+void
+goo_mont4_set_one(const goo_mont_t *mont, goo_limb_t *out) {
+  size_t k;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->avx2) {
+    goo_mont4_spread(mont, out, mont->one26);
+    return;
+  }
+#endif
+
+  for (k = 0; k < 4; k++)
+    goo_mont_set_one(mont, out + k * mont->limbs);
+}
+
+void
+goo_mont4_mul(const goo_mont_t *mont,
+              goo_limb_t *out,
+              const goo_limb_t *a,
+              const goo_limb_t *b) {
+  const goo_limb_t *lanes[4];
+
+  lanes[0] = lanes[1] = lanes[2] = lanes[3] = b;
+
+  goo_mont4_mul_lanes(mont, out, a, lanes);
+}
+
+void
+goo_mont4_mul_lanes(const goo_mont_t *mont,
+                    goo_limb_t *out,
+                    const goo_limb_t *a,
+                    const goo_limb_t *const *b) {
+  size_t k;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->avx2) {
+    goo_limb_t one[GOO_MONT4_MAX_WORDS];
+    const goo_limb_t *lanes[4];
+
+    if (b[0] && b[1] && b[2] && b[3]) {
+      goo_avx2_amm4(out, a, b, mont->n26, mont->k26, mont->digits);
+      return;
+    }
+
+    goo_mont4_spread(mont, one, mont->one26);
+
+    for (k = 0; k < 4; k++)
+      lanes[k] = b[k] != NULL ? b[k] : one;
+
+    goo_avx2_amm4(out, a, lanes, mont->n26, mont->k26, mont->digits);
+
+    return;
+  }
+#endif
+
+  for (k = 0; k < 4; k++) {
+    size_t j = k * mont->limbs;
+
+    if (b[k] == NULL) {
+      if (out != a)
+        goo_mont_copy(mont, out + j, a + j);
+      continue;
+    }
+
+    goo_mont_mul(mont, out + j, a + j, b[k] + j);
+  }
+}
+
+void
+goo_mont4_sqr(const goo_mont_t *mont, goo_limb_t *out, const goo_limb_t *a) {
+  size_t k;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (mont->avx2) {
+    goo_mont4_mul(mont, out, a, a);
+    return;
+  }
+#endif
+
+  for (k = 0; k < 4; k++)
+    goo_mont_sqr(mont, out + k * mont->limbs, a + k * mont->limbs);
+}
+
+/*
+ * Small Moduli
+ */
+
+static void
+goo_smont_mul(goo_limb_t *out,
+              const goo_limb_t *a,
+              const goo_limb_t *b,
+              const goo_limb_t *n,
+              goo_limb_t k) {
+  /* Interleaved (CIOS) montgomery multiplication. The width is fixed,
+     so the loops unroll and the lanes overlap in the pipeline. */
+  goo_limb_t t[GOO_SMONT4_LIMBS + 2];
+  goo_dlimb_t s;
+  goo_limb_t c, m;
+  size_t i, j;
+
+  memset(t, 0, sizeof(t));
+
+  for (i = 0; i < GOO_SMONT4_LIMBS; i++) {
+    c = 0;
+
+    for (j = 0; j < GOO_SMONT4_LIMBS; j++) {
+      s = (goo_dlimb_t)a[j] * b[i] + t[j] + c;
+      t[j] = (goo_limb_t)s;
+      c = (goo_limb_t)(s >> GOO_LIMB_BITS);
+    }
+
+    s = (goo_dlimb_t)t[GOO_SMONT4_LIMBS] + c;
+    t[GOO_SMONT4_LIMBS] = (goo_limb_t)s;
+    t[GOO_SMONT4_LIMBS + 1] = (goo_limb_t)(s >> GOO_LIMB_BITS);
+
+    m = t[0] * k;
+    s = (goo_dlimb_t)n[0] * m + t[0];
+    c = (goo_limb_t)(s >> GOO_LIMB_BITS);
+
+    for (j = 1; j < GOO_SMONT4_LIMBS; j++) {
+      s = (goo_dlimb_t)n[j] * m + t[j] + c;
+      t[j - 1] = (goo_limb_t)s;
+      c = (goo_limb_t)(s >> GOO_LIMB_BITS);
+    }
+
+    s = (goo_dlimb_t)t[GOO_SMONT4_LIMBS] + c;
+    t[GOO_SMONT4_LIMBS - 1] = (goo_limb_t)s;
+    t[GOO_SMONT4_LIMBS] = t[GOO_SMONT4_LIMBS + 1]
+                        + (goo_limb_t)(s >> GOO_LIMB_BITS);
+  }
+
+  if (t[GOO_SMONT4_LIMBS] != 0 || goo_mpn_cmp(t, n, GOO_SMONT4_LIMBS) >= 0)
+    goo_mpn_sub(out, t, n, GOO_SMONT4_LIMBS);
+  else
+    memcpy(out, t, GOO_SMONT4_LIMBS * sizeof(goo_limb_t));
+}
+
+static void
+goo_smont4_put(const goo_smont4_t *sm,
+               goo_limb_t *out,
+               size_t j,
+               const goo_limb_t *x) {
+  /* Write lane j from GOO_SMONT4_LIMBS limbs. */
+#ifdef GOO_MONT_HAVE_SIMD
+  if (sm->avx2) {
+    goo_limb_t y[GOO_SMONT4_DIGITS];
+    size_t i;
+
+    goo_radix_split(y, GOO_SMONT4_DIGITS, 26, x, GOO_SMONT4_LIMBS);
+
+    for (i = 0; i < GOO_SMONT4_DIGITS; i++)
+      out[i * 4 + j] = y[i];
+
+    return;
+  }
+#endif
+
+  (void)sm;
+
+  memcpy(out + j * GOO_SMONT4_LIMBS, x, GOO_SMONT4_LIMBS * sizeof(goo_limb_t));
+}
+
+int
+goo_smont4_init(goo_smont4_t *sm,
+                const unsigned char *n,
+                size_t n_len,
+                unsigned int cpu) {
+  goo_limb_t m[GOO_SMONT4_LIMBS];
+  goo_limb_t x[GOO_SMONT4_LIMBS];
+  size_t rbits = GOO_SMONT4_BITS;
+  size_t i, j;
+
+  if (n_len > GOO_SMONT4_BITS / 8)
+    return 0;
+
+  memset(sm, 0, sizeof(goo_smont4_t));
+
+#ifdef GOO_MONT_HAVE_SIMD
+  sm->avx2 = (cpu & GOO_MONT_AVX2) != 0;
+
+  if (sm->avx2)
+    rbits = GOO_SMONT4_DIGITS * 26;
+#endif
+
+  (void)cpu;
+
+  for (j = 0; j < 4; j++) {
+    memset(m, 0, sizeof(m));
+    memset(x, 0, sizeof(x));
+
+    goo_limbs_import(m, n + j * n_len, n_len);
+
+    x[0] = 1;
+
+    if ((m[0] & 1) == 0 || goo_mpn_cmp(m, x, GOO_SMONT4_LIMBS) == 0)
+      return 0;
+
+    sm->k[j] = goo_mpn_inverse(m[0]);
+
+#ifdef GOO_MONT_HAVE_SIMD
+    if (sm->avx2)
+      sm->k[j] &= GOO_AVX2_MASK;
+#endif
+
+    goo_smont4_put(sm, sm->n, j, m);
+
+    /* one = R mod n, r2 = R^2 mod n */
+    for (i = 0; i < rbits; i++)
+      goo_mpn_double(x, m, GOO_SMONT4_LIMBS);
+
+    goo_smont4_put(sm, sm->one, j, x);
+
+    for (i = 0; i < rbits; i++)
+      goo_mpn_double(x, m, GOO_SMONT4_LIMBS);
+
+    goo_smont4_put(sm, sm->r2, j, x);
+  }
+
+  return 1;
+}
+
+void
+goo_smont4_import(const goo_smont4_t *sm,
+                  goo_limb_t *out,
+                  const unsigned char *raw,
+                  size_t raw_len) {
+  goo_limb_t x[GOO_SMONT4_WORDS];
+  size_t j;
+
+  assert(raw_len <= GOO_SMONT4_BITS / 8);
+
+  for (j = 0; j < 4; j++) {
+    goo_limb_t y[GOO_SMONT4_LIMBS];
+
+    memset(y, 0, sizeof(y));
+
+    goo_limbs_import(y, raw + j * raw_len, raw_len);
+    goo_smont4_put(sm, x, j, y);
+  }
+
+  goo_smont4_mul(sm, out, x, sm->r2);
+}
+
+void
+goo_smont4_export(const goo_smont4_t *sm,
+                  unsigned char *raw,
+                  size_t raw_len,
+                  const goo_limb_t *x) {
+  size_t j;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (sm->avx2) {
+    goo_limb_t e[GOO_SMONT4_WORDS];
+    goo_limb_t z[GOO_SMONT4_WORDS];
+    goo_limb_t y[GOO_SMONT4_DIGITS];
+    goo_limb_t m[GOO_SMONT4_DIGITS];
+    goo_limb_t t[GOO_SMONT4_LIMBS + 1];
+    size_t i, n;
+
+    /* Multiply by one to leave montgomery form (result <= n). */
+    memset(e, 0, sizeof(e));
+
+    e[0] = e[1] = e[2] = e[3] = 1;
+
+    goo_smont4_mul(sm, z, x, e);
+
+    for (j = 0; j < 4; j++) {
+      for (i = 0; i < GOO_SMONT4_DIGITS; i++) {
+        y[i] = z[i * 4 + j];
+        m[i] = sm->n[i * 4 + j];
+      }
+
+      goo_radix_reduce(y, m, GOO_SMONT4_DIGITS, 26);
+
+      n = goo_radix_join(t, y, GOO_SMONT4_DIGITS, 26);
+
+      goo_limbs_export(raw + j * raw_len, raw_len, t, n);
+    }
+
+    return;
+  }
+#endif
+
+  for (j = 0; j < 4; j++) {
+    goo_limb_t t[2 * GOO_SMONT4_LIMBS];
+    size_t i = j * GOO_SMONT4_LIMBS;
+
+    memset(t, 0, sizeof(t));
+    memcpy(t, x + i, GOO_SMONT4_LIMBS * sizeof(goo_limb_t));
+
+    goo_mpn_redc(goo_mpn_addmul_1, t, t, sm->n + i, sm->k[j],
+                 GOO_SMONT4_LIMBS);
+
+    goo_limbs_export(raw + j * raw_len, raw_len, t, GOO_SMONT4_LIMBS);
+  }
+}
+
+void
+goo_smont4_set_one(const goo_smont4_t *sm, goo_limb_t *out) {
+  memcpy(out, sm->one, sizeof(sm->one));
+}
+
+void
+goo_smont4_mul(const goo_smont4_t *sm,
+               goo_limb_t *out,
+               const goo_limb_t *a,
+               const goo_limb_t *b) {
+  const goo_limb_t *lanes[4];
+
+  lanes[0] = lanes[1] = lanes[2] = lanes[3] = b;
+
+  goo_smont4_mul_lanes(sm, out, a, lanes);
+}
+
+void
+goo_smont4_mul_lanes(const goo_smont4_t *sm,
+                     goo_limb_t *out,
+                     const goo_limb_t *a,
+                     const goo_limb_t *const *b) {
+  size_t j;
+
+#ifdef GOO_MONT_HAVE_SIMD
+  if (sm->avx2) {
+    goo_avx2_amm4x(out, a, b, sm->n, sm->k);
+    return;
+  }
+#endif
+
+  for (j = 0; j < 4; j++) {
+    size_t i = j * GOO_SMONT4_LIMBS;
+
+    goo_smont_mul(out + i, a + i, b[j] + i, sm->n + i, sm->k[j]);
+  }
+}
+
+void
+goo_smont4_sqr(const goo_smont4_t *sm, goo_limb_t *out, const goo_limb_t *a) {
+  goo_smont4_mul(sm, out, a, a);
+}
@@ -0,0 +1,215 @@
+/*!
+ * mont.h - fixed-width montgomery arithmetic for C89
+ * Copyright (c) 2018-2019, Christopher Jeffrey (MIT License).
+ * https://github.com/handshake-org/goosig
+ */
+
+#ifndef _GOOSIG_MONT_H
+#define _GOOSIG_MONT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#if defined(__SIZEOF_INT128__) && !defined(GOO_MONT_32BIT)
+#define GOO_LIMB_BITS 64
+typedef uint64_t goo_limb_t;
+#else
+#define GOO_LIMB_BITS 32
+typedef uint32_t goo_limb_t;
+#endif
+
+/* Moduli are padded to 2048, 3072 or 4096 bits. */
+#define GOO_MONT_MAX_BITS 4096
+
+#if GOO_LIMB_BITS == 64
+/* 4096 bits as 80 radix 2^52 digits (IFMA). */
+#define GOO_MONT_MAX_LIMBS 80
+#else
+#define GOO_MONT_MAX_LIMBS (GOO_MONT_MAX_BITS / GOO_LIMB_BITS)
+#endif
+
+/* Four lanes of 4096 bits as radix 2^26 digits (AVX2). */
+#define GOO_MONT4_MAX_DIGITS 160
+#define GOO_MONT4_MAX_WORDS (4 * GOO_MONT4_MAX_DIGITS)
+
+/* Four lanes of up to 192 bits, each with its own modulus (goo_smont4). */
+#define GOO_SMONT4_BITS 192
+#define GOO_SMONT4_LIMBS (GOO_SMONT4_BITS / GOO_LIMB_BITS)
+#define GOO_SMONT4_DIGITS 8
+#define GOO_SMONT4_WORDS (4 * GOO_SMONT4_DIGITS)
+
+/* CPU kernels (goo_mont_cpu). */
+#define GOO_MONT_ADX 1
+#define GOO_MONT_IFMA 2
+#define GOO_MONT_AVX2 4
+
+typedef struct goo_mont_s {
+  size_t limbs; /* words per element */
+  int adx; /* use the MULX/ADX kernel (x86-64, detected at init) */
+  int ifma; /* elements are radix 2^52 digits (AVX-512 IFMA) */
+  int avx2; /* goo_mont4_* use radix 2^26 lanes (AVX2) */
+  goo_limb_t k;
+  goo_limb_t n[GOO_MONT_MAX_LIMBS];
+  goo_limb_t one[GOO_MONT_MAX_LIMBS];
+  goo_limb_t r2[GOO_MONT_MAX_LIMBS];
+  size_t digits;
+  goo_limb_t k26;
+  goo_limb_t n26[GOO_MONT4_MAX_DIGITS];
+  goo_limb_t one26[GOO_MONT4_MAX_DIGITS];
+  goo_limb_t r2_26[GOO_MONT4_MAX_DIGITS];
+} goo_mont_t;
+
+typedef struct goo_smont4_s {
+  int avx2; /* lanes are radix 2^26 digits, interleaved (AVX2) */
+  goo_limb_t k[4];
+  goo_limb_t n[GOO_SMONT4_WORDS];
+  goo_limb_t r2[GOO_SMONT4_WORDS];
+  goo_limb_t one[GOO_SMONT4_WORDS];
+} goo_smont4_t;
+
+/* Kernels supported by this CPU. */
+unsigned int
+goo_mont_cpu(void);
+
+/* Prepare an odd modulus of at most 4096 bits (big endian). */
+int
+goo_mont_init(goo_mont_t *mont, const unsigned char *n, size_t n_len);
+
+/* As above, restricted to the kernels in `cpu`. */
+int
+goo_mont_init_cpu(goo_mont_t *mont,
+                  const unsigned char *n,
+                  size_t n_len,
+                  unsigned int cpu);
+
+/* Convert a big endian integer below R into montgomery form. */
+void
+goo_mont_import(const goo_mont_t *mont,
+                goo_limb_t *out,
+                const unsigned char *raw,
+                size_t raw_len);
+
+/* Convert out of montgomery form, as `raw_len` big endian bytes. */
+void
+goo_mont_export(const goo_mont_t *mont,
+                unsigned char *raw,
+                size_t raw_len,
+                const goo_limb_t *x);
+
+void
+goo_mont_set_one(const goo_mont_t *mont, goo_limb_t *out);
+
+void
+goo_mont_copy(const goo_mont_t *mont, goo_limb_t *out, const goo_limb_t *x);
+
+/* out = a * b / R mod n (out may alias a or b) */
+void
+goo_mont_mul(const goo_mont_t *mont,
+             goo_limb_t *out,
+             const goo_limb_t *a,
+             const goo_limb_t *b);
+
+/* out = a^2 / R mod n (out may alias a) */
+void
+goo_mont_sqr(const goo_mont_t *mont, goo_limb_t *out, const goo_limb_t *a);
+
+/*
+ * Four independent elements per vector, computed in lockstep. A vector
+ * holds goo_mont4_words() words; its layout depends on the kernel.
+ */
+
+size_t
+goo_mont4_words(const goo_mont_t *mont);
+
+/* Import four consecutive `raw_len` byte big endian integers. */
+void
+goo_mont4_import(const goo_mont_t *mont,
+                 goo_limb_t *out,
+                 const unsigned char *raw,
+                 size_t raw_len);
+
+/* Export four consecutive `raw_len` byte big endian integers. */
+void
+goo_mont4_export(const goo_mont_t *mont,
+                 unsigned char *raw,
+                 size_t raw_len,
+                 const goo_limb_t *x);
+
+void
+goo_mont4_set_one(const goo_mont_t *mont, goo_limb_t *out);
+
+/* Lane-wise out = a * b / R mod n (out may alias a or b). */
+void
+goo_mont4_mul(const goo_mont_t *mont,
+              goo_limb_t *out,
+              const goo_limb_t *a,
+              const goo_limb_t *b);
+
+/* As above, taking lane j of the multiplier from the vector b[j]
+   (NULL multiplies lane j by one). */
+void
+goo_mont4_mul_lanes(const goo_mont_t *mont,
+                    goo_limb_t *out,
+                    const goo_limb_t *a,
+                    const goo_limb_t *const *b);
+
+void
+goo_mont4_sqr(const goo_mont_t *mont, goo_limb_t *out, const goo_limb_t *a);
+
+/*
+ * Four small moduli, one per lane, computed in lockstep. Vectors hold
+ * GOO_SMONT4_WORDS words; their layout depends on the kernel.
+ */
+
+/* Prepare four consecutive `n_len` byte big endian odd moduli of at
+   most GOO_SMONT4_BITS bits, restricted to the kernels in `cpu`. */
+int
+goo_smont4_init(goo_smont4_t *sm,
+                const unsigned char *n,
+                size_t n_len,
+                unsigned int cpu);
+
+/* Import four consecutive `raw_len` byte big endian integers, each
+   below its lane's modulus. */
+void
+goo_smont4_import(const goo_smont4_t *sm,
+                  goo_limb_t *out,
+                  const unsigned char *raw,
+                  size_t raw_len);
+
+/* Export four consecutive `raw_len` byte big endian integers. */
+void
+goo_smont4_export(const goo_smont4_t *sm,
+                  unsigned char *raw,
+                  size_t raw_len,
+                  const goo_limb_t *x);
+
+void
+goo_smont4_set_one(const goo_smont4_t *sm, goo_limb_t *out);
+
+/* Lane-wise out = a * b / R mod n (out may alias a or b). */
+void
+goo_smont4_mul(const goo_smont4_t *sm,
+               goo_limb_t *out,
+               const goo_limb_t *a,
+               const goo_limb_t *b);
+
+/* As above, taking lane j of the multiplier from the vector b[j]. */
+void
+goo_smont4_mul_lanes(const goo_smont4_t *sm,
+                     goo_limb_t *out,
+                     const goo_limb_t *a,
+                     const goo_limb_t *const *b);
+
+void
+goo_smont4_sqr(const goo_smont4_t *sm, goo_limb_t *out, const goo_limb_t *a);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
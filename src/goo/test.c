@@ -1645,6 +1645,85 @@ run_primes_test(goo_prng_t *rng) {
     mpz_clear(n);
   }
 
+  printf("Testing batched primality...\n");
+
+  {
+    static const unsigned int kernels[2] = { 0, GOO_MONT_AVX2 };
+    enum { TOTAL = GOO_ARRAY_SIZE(primes) + GOO_ARRAY_SIZE(composites) };
+    unsigned int cpu = goo_mont_cpu();
+    unsigned char keys[TOTAL * 32];
+    mpz_t nums[TOTAL];
+    mpz_srcptr lanes[TOTAL];
+    int res[TOTAL];
+    size_t j, k, m;
+
+    for (i = 0; i < TOTAL; i++) {
+      mpz_init(nums[i]);
+      lanes[i] = nums[i];
+
+      if (i < GOO_ARRAY_SIZE(primes))
+        assert(mpz_set_str(nums[i], primes[i], 10) == 0);
+      else
+        assert(mpz_set_str(nums[i], composites[i - GOO_ARRAY_SIZE(primes)],
+                           10) == 0);
+
+      memcpy(keys + i * 32, (i & 1) ? zero : key, 32);
+    }
+
+    for (k = 0; k < 2; k++) {
+      if ((cpu & kernels[k]) != kernels[k])
+        continue;
+
+      /* Lockstep rounds agree with goo_is_prime_mr lane by lane, */
+      /* including the strong pseudoprimes to base 2. */
+      for (i = 7; i < 20000; i += 8) {
+        for (j = 0; j < 4; j++)
+          mpz_set_ui(nums[j], i + 2 * j);
+
+        assert(goo_is_prime_mr4(res, lanes, keys, 4, 1, 1, kernels[k]));
+
+        for (j = 0; j < 4; j++)
+          assert(res[j] == goo_is_prime_mr(nums[j], keys + j * 32, 1, 1));
+
+        assert(goo_is_prime_mr4(res, lanes, keys, 3, 3, 0, kernels[k]));
+
+        for (j = 0; j < 3; j++)
+          assert(res[j] == goo_is_prime_mr(nums[j], keys + j * 32, 3, 0));
+      }
+
+      /* Moduli wider than a lane are refused. */
+      mpz_set_ui(nums[0], 1);
+      mpz_mul_2exp(nums[0], nums[0], GOO_SMONT4_BITS);
+      mpz_add_ui(nums[0], nums[0], 1);
+
+      assert(!goo_is_prime_mr4(res, lanes, keys, 1, 1, 1, kernels[k]));
+
+      /* Everything above, in uneven batches. */
+      for (i = 0; i < TOTAL; i++) {
+        if (i < GOO_ARRAY_SIZE(primes))
+          assert(mpz_set_str(nums[i], primes[i], 10) == 0);
+        else
+          assert(mpz_set_str(nums[i], composites[i - GOO_ARRAY_SIZE(primes)],
+                             10) == 0);
+      }
+
+      for (i = 0; i < TOTAL; i += m) {
+        m = 1 + (i % 7);
+
+        if (i + m > TOTAL)
+          m = TOTAL - i;
+
+        goo_is_prime_batch(res, lanes + i, keys + i * 32, m, kernels[k]);
+
+        for (j = 0; j < m; j++)
+          assert(res[j] == goo_is_prime(nums[i + j], keys + (i + j) * 32));
+      }
+    }
+
+    for (i = 0; i < TOTAL; i++)
+      mpz_clear(nums[i]);
+  }
+
   /* test next_prime */
   {
     mpz_t n;
@@ -1688,6 +1767,366 @@ run_primes_test(goo_prng_t *rng) {
   }
 }
 
+static void
+run_mpz_test(goo_prng_t *rng) {
+  mpz_t a, b, c, d, e, m;
+  size_t i;
+
+  printf("Testing bignum arithmetic...\n");
+
+  mpz_init(a);
+  mpz_init(b);
+  mpz_init(c);
+  mpz_init(d);
+  mpz_init(e);
+  mpz_init(m);
+
+  for (i = 0; i < 64; i++) {
+    unsigned long bits = 64 + goo_prng_random_num(rng, 8192);
+
+    goo_prng_random_bits(rng, a, bits);
+    goo_prng_random_bits(rng, b, 8256 - bits);
+    mpz_setbit(b, 0);
+
+    /* Products (schoolbook, karatsuba and unbalanced). */
+    mpz_mul(c, a, b);
+    mpz_divexact(d, c, b);
+    assert(mpz_cmp(d, a) == 0);
+
+    mpz_set(d, a);
+    mpz_mul(c, a, a);
+    mpz_mul(d, d, a);
+    assert(mpz_cmp(c, d) == 0);
+
+    /* gcd(a c, b c) = c gcd(a, b) */
+    goo_prng_random_bits(rng, e, 128);
+    mpz_setbit(e, 127);
+    mpz_gcd(d, a, b);
+    mpz_mul(d, d, e);
+    mpz_mul(a, a, e);
+    mpz_mul(b, b, e);
+    mpz_gcd(c, a, b);
+    assert(mpz_cmp(c, d) == 0);
+    mpz_divexact(a, a, e);
+    mpz_divexact(b, b, e);
+
+    /* a a^-1 = 1 mod b */
+    if (mpz_invert(c, a, b)) {
+      mpz_mul(c, c, a);
+      mpz_mod(c, c, b);
+      assert(mpz_cmp_ui(c, 1) == 0);
+    } else {
+      mpz_gcd(c, a, b);
+      assert(mpz_cmp_ui(c, 1) != 0);
+    }
+
+    /* a^(e1 + e2) = a^e1 a^e2 mod m */
+    if (i < 16) {
+      goo_prng_random_bits(rng, m, 2048);
+      mpz_setbit(m, 0);
+      goo_prng_random_bits(rng, d, 1 + goo_prng_random_num(rng, 2048));
+      goo_prng_random_bits(rng, e, 1 + goo_prng_random_num(rng, 2048));
+
+      mpz_powm(b, a, d, m);
+      mpz_powm(c, a, e, m);
+      mpz_mul(b, b, c);
+      mpz_mod(b, b, m);
+
+      mpz_add(d, d, e);
+      mpz_powm(c, a, d, m);
+
+      assert(mpz_cmp(b, c) == 0);
+    }
+  }
+
+  mpz_clear(a);
+  mpz_clear(b);
+  mpz_clear(c);
+  mpz_clear(d);
+  mpz_clear(e);
+  mpz_clear(m);
+}
+
+static void
+run_mont_test(goo_prng_t *rng) {
+  static const size_t sizes[4] = { 1024, 2048, 3072, 4096 };
+  static const unsigned int kernels[4] = {
+    0,
+    GOO_MONT_ADX,
+    GOO_MONT_ADX | GOO_MONT_AVX2,
+    GOO_MONT_ADX | GOO_MONT_AVX2 | GOO_MONT_IFMA
+  };
+  unsigned int cpu = goo_mont_cpu();
+  unsigned char mod[GOO_MAX_RSA_BYTES];
+  unsigned char raw[GOO_MAX_RSA_BYTES];
+  unsigned char out[GOO_MAX_RSA_BYTES];
+  goo_limb_t x[GOO_MONT_MAX_LIMBS];
+  goo_limb_t y[GOO_MONT_MAX_LIMBS];
+  goo_limb_t z[GOO_MONT_MAX_LIMBS];
+  goo_limb_t w[GOO_MONT_MAX_LIMBS];
+  unsigned char raw4[4 * GOO_MAX_RSA_BYTES];
+  unsigned char out4[4 * GOO_MAX_RSA_BYTES];
+  goo_limb_t x4[GOO_MONT4_MAX_WORDS];
+  goo_limb_t y4[GOO_MONT4_MAX_WORDS];
+  goo_limb_t z4[GOO_MONT4_MAX_WORDS];
+  goo_limb_t w4[GOO_MONT4_MAX_WORDS];
+  const goo_limb_t *lanes[4];
+  mpz_t n, a, b, c, d;
+  goo_mont_t mont;
+  size_t i, j, k;
+
+  printf("Testing montgomery arithmetic...\n");
+
+  mpz_init(n);
+  mpz_init(a);
+  mpz_init(b);
+  mpz_init(c);
+  mpz_init(d);
+
+  /* Even moduli cannot be used. */
+  memset(raw, 0xff, 256);
+  raw[255] = 0xfe;
+
+  assert(!goo_mont_init(&mont, raw, 256));
+
+  for (i = 0; i < 4; i++) {
+    size_t bits = sizes[i];
+    size_t size = bits / 8;
+
+    goo_prng_random_bits(rng, n, bits);
+    mpz_setbit(n, bits - 1);
+    mpz_setbit(n, 0);
+
+    goo_mpz_pad(mod, size, n);
+
+    /* Cross-check the portable kernel and whichever of
+       the MULX/ADX, AVX2 and IFMA kernels the CPU has. */
+    for (k = 0; k < 4; k++) {
+      if ((cpu & kernels[k]) != kernels[k])
+        continue;
+
+      assert(goo_mont_init_cpu(&mont, mod, size, kernels[k]));
+
+      if (mont.ifma)
+        assert(mont.limbs == (bits == 3072 ? 64 : 80));
+      else
+        assert(mont.limbs * GOO_LIMB_BITS == (bits < 2048 ? 2048 : bits));
+
+      /* Running product, never leaving montgomery form. */
+      goo_mont_set_one(&mont, w);
+      mpz_set_ui(d, 1);
+
+      for (j = 0; j < 32; j++) {
+        goo_prng_random_bits(rng, a, bits);
+        goo_prng_random_bits(rng, b, bits);
+
+        mpz_mod(a, a, n);
+        mpz_mod(b, b, n);
+
+        /* Maximal operands: every carry chain runs full length. */
+        if (j == 0)
+          mpz_sub_ui(a, n, 1);
+
+        if (j == 1)
+          mpz_sub_ui(b, n, 1);
+
+        goo_mpz_pad(raw, size, a);
+        goo_mont_import(&mont, x, raw, size);
+
+        goo_mont_export(&mont, out, size, x);
+        assert(memcmp(out, raw, size) == 0);
+
+        goo_mpz_pad(raw, size, b);
+        goo_mont_import(&mont, y, raw, size);
+
+        /* a * b mod n */
+        goo_mont_mul(&mont, z, x, y);
+        goo_mont_export(&mont, out, size, z);
+
+        mpz_mul(c, a, b);
+        mpz_mod(c, c, n);
+        goo_mpz_pad(raw, size, c);
+
+        assert(memcmp(out, raw, size) == 0);
+
+        /* a^2 mod n */
+        goo_mont_sqr(&mont, z, x);
+        goo_mont_export(&mont, out, size, z);
+
+        mpz_mul(c, a, a);
+        mpz_mod(c, c, n);
+        goo_mpz_pad(raw, size, c);
+
+        assert(memcmp(out, raw, size) == 0);
+
+        /* d = (d * a)^2 mod n */
+        goo_mont_mul(&mont, w, w, x);
+        goo_mont_sqr(&mont, w, w);
+
+        mpz_mul(d, d, a);
+        mpz_mul(d, d, d);
+        mpz_mod(d, d, n);
+      }
+
+      goo_mont_export(&mont, out, size, w);
+      goo_mpz_pad(raw, size, d);
+
+      assert(memcmp(out, raw, size) == 0);
+
+      /* Four lanes: a[j] in x4, b[j] in y4 (lane 0 is maximal). */
+      assert(goo_mont4_words(&mont) <= GOO_MONT4_MAX_WORDS);
+
+      for (j = 0; j < 4; j++) {
+        goo_prng_random_bits(rng, a, bits);
+        mpz_mod(a, a, n);
+
+        if (j == 0)
+          mpz_sub_ui(a, n, 1);
+
+        goo_mpz_pad(raw4 + j * size, size, a);
+      }
+
+      goo_mont4_import(&mont, x4, raw4, size);
+      goo_mont4_export(&mont, out4, size, x4);
+
+      assert(memcmp(out4, raw4, 4 * size) == 0);
+
+      for (j = 0; j < 4; j++) {
+        goo_prng_random_bits(rng, b, bits);
+        mpz_mod(b, b, n);
+        goo_mpz_pad(raw4 + j * size, size, b);
+      }
+
+      goo_mont4_import(&mont, y4, raw4, size);
+
+      /* z[j] = a[j] * b[j], then z[j] = z[j]^2 */
+      goo_mont4_mul(&mont, z4, x4, y4);
+      goo_mont4_sqr(&mont, z4, z4);
+
+      /* z[j] = z[j] * (j odd ? b[j] : 1) */
+      goo_mont4_set_one(&mont, w4);
+
+      lanes[0] = NULL;
+      lanes[1] = y4;
+      lanes[2] = w4;
+      lanes[3] = y4;
+
+      goo_mont4_mul_lanes(&mont, z4, z4, lanes);
+      goo_mont4_export(&mont, out4, size, z4);
+
+      for (j = 0; j < 4; j++) {
+        goo_mont4_export(&mont, raw4, size, x4);
+        goo_mpz_import(a, raw4 + j * size, size);
+
+        goo_mont4_export(&mont, raw4, size, y4);
+        goo_mpz_import(b, raw4 + j * size, size);
+
+        mpz_mul(c, a, b);
+        mpz_mul(c, c, c);
+
+        if (j & 1)
+          mpz_mul(c, c, b);
+
+        mpz_mod(c, c, n);
+        goo_mpz_pad(raw, size, c);
+
+        assert(memcmp(out4 + j * size, raw, size) == 0);
+      }
+    }
+  }
+
+  /* Small moduli, one per lane (lane 1 is 2^192 - 1). */
+  for (k = 0; k < 3; k += 2) {
+    static const size_t small[4] = { 136, 192, 64, 137 };
+    const size_t size = GOO_SMONT4_BITS / 8;
+    goo_smont4_t sm;
+
+    if ((cpu & kernels[k]) != kernels[k])
+      continue;
+
+    memset(raw4, 0x00, 4 * size);
+    raw4[size - 1] = 0x02;
+
+    assert(!goo_smont4_init(&sm, raw4, size, kernels[k]));
+
+    for (j = 0; j < 4; j++) {
+      goo_prng_random_bits(rng, n, small[j]);
+      mpz_setbit(n, small[j] - 1);
+      mpz_setbit(n, 0);
+
+      if (j == 1)
+        memset(mod + j * size, 0xff, size);
+      else
+        goo_mpz_pad(mod + j * size, size, n);
+    }
+
+    assert(goo_smont4_init(&sm, mod, size, kernels[k]));
+    assert(sm.avx2 == ((kernels[k] & GOO_MONT_AVX2) != 0));
+
+    for (i = 0; i < 8; i++) {
+      for (j = 0; j < 4; j++) {
+        goo_mpz_import(n, mod + j * size, size);
+        goo_prng_random_bits(rng, a, GOO_SMONT4_BITS);
+        goo_prng_random_bits(rng, b, GOO_SMONT4_BITS);
+        mpz_mod(a, a, n);
+        mpz_mod(b, b, n);
+
+        if (i == 0)
+          mpz_sub_ui(a, n, 1);
+
+        goo_mpz_pad(raw4 + j * size, size, a);
+        goo_mpz_pad(out4 + j * size, size, b);
+      }
+
+      goo_smont4_import(&sm, x4, raw4, size);
+      goo_smont4_import(&sm, y4, out4, size);
+
+      goo_smont4_export(&sm, out4 + 4 * size, size, x4);
+      assert(memcmp(out4 + 4 * size, raw4, 4 * size) == 0);
+
+      /* z[j] = (a[j] * b[j])^2 * {b, 1, a, b}[j] */
+      goo_smont4_mul(&sm, z4, x4, y4);
+      goo_smont4_sqr(&sm, z4, z4);
+      goo_smont4_set_one(&sm, w4);
+
+      lanes[0] = y4;
+      lanes[1] = w4;
+      lanes[2] = x4;
+      lanes[3] = y4;
+
+      goo_smont4_mul_lanes(&sm, z4, z4, lanes);
+      goo_smont4_export(&sm, out4 + 4 * size, size, z4);
+
+      for (j = 0; j < 4; j++) {
+        goo_mpz_import(n, mod + j * size, size);
+        goo_mpz_import(a, raw4 + j * size, size);
+
+        goo_smont4_export(&sm, raw, size, y4);
+        goo_mpz_import(b, raw + j * size, size);
+
+        mpz_mul(c, a, b);
+        mpz_mul(c, c, c);
+
+        if (j == 0 || j == 3)
+          mpz_mul(c, c, b);
+        else if (j == 2)
+          mpz_mul(c, c, a);
+
+        mpz_mod(c, c, n);
+        goo_mpz_pad(raw, size, c);
+
+        assert(memcmp(out4 + (4 + j) * size, raw, size) == 0);
+      }
+    }
+  }
+
+  mpz_clear(n);
+  mpz_clear(a);
+  mpz_clear(b);
+  mpz_clear(c);
+  mpz_clear(d);
+}
+
 static void
 run_ops_test(goo_prng_t *rng) {
   mpz_t n;
@@ -1706,6 +2145,17 @@ run_ops_test(goo_prng_t *rng) {
   {
     printf("Testing comb calculation...\n");
 
+#if GOO_MAX_JOINT_COMB_SIZE >= 4080
+    assert(goo->combs[0].joint);
+    assert(goo->combs[0].g.points_per_add == 4);
+    assert(goo->combs[0].g.adds_per_shift == 16);
+    assert(goo->combs[0].g.shifts == 32);
+    assert(goo->combs[0].g.bits_per_window == 512);
+    assert(goo->combs[0].g.bits == 2048);
+    assert(goo->combs[0].g.points_per_subcomb == 255);
+    assert(goo->combs[0].g.size == 4080);
+    assert(goo->combs[0].g.bases == 2);
+#else
     assert(goo->combs[0].g.points_per_add == 8);
     assert(goo->combs[0].g.adds_per_shift == 2);
     assert(goo->combs[0].g.shifts == 128);
@@ -1721,6 +2171,10 @@ run_ops_test(goo_prng_t *rng) {
     assert(goo->combs[0].h.bits == 2048);
     assert(goo->combs[0].h.points_per_subcomb == 255);
     assert(goo->combs[0].h.size == 510);
+#endif
+
+    /* Too big for a joint comb to pay off. */
+    assert(!goo->combs[1].joint);
 
     assert(goo->combs[1].g.points_per_add == 8);
     assert(goo->combs[1].g.adds_per_shift == 2);
@@ -1797,11 +2251,17 @@ run_ops_test(goo_prng_t *rng) {
       goo_prng_random_bits(rng, e1, 128);
       goo_prng_random_bits(rng, e2, 128);
 
-      assert(goo_group_inv2(goo, b1i, b2i, b1, b2));
+      assert(goo_group_inv(goo, b1i, b1));
+      assert(goo_group_inv(goo, b2i, b2));
       assert(goo_group_pow2_slow(goo, r1, b1, e1, b2, e2));
       assert(goo_group_pow2(goo, r2, b1, b1i, e1, b2, b2i, e2));
 
       assert(mpz_cmp(r1, r2) == 0);
+
+      /* Positive windows for b1, without its inverse. */
+      assert(goo_group_pow2(goo, r2, b1, NULL, e1, b2, b2i, e2));
+
+      assert(mpz_cmp(r1, r2) == 0);
     }
 
     mpz_clear(b1);
@@ -1828,9 +2288,13 @@ run_ops_test(goo_prng_t *rng) {
     mpz_init(r1);
     mpz_init(r2);
 
-    for (i = 0; i < 20; i++) {
-      goo_prng_random_bits(rng, e1, 2048 + GOO_ELL_BITS + 2 - 1);
-      goo_prng_random_bits(rng, e2, 2048 + GOO_ELL_BITS + 2 - 1);
+    for (i = 0; i < 40; i++) {
+      /* Alternate between the small and the big combs. */
+      unsigned long bits = (i & 1) ? goo->rand_bits
+                                   : 2048 + GOO_ELL_BITS + 2 - 1;
+
+      goo_prng_random_bits(rng, e1, bits);
+      goo_prng_random_bits(rng, e2, bits);
 
       assert(goo_group_powgh_slow(goo, r1, e1, e2));
       assert(goo_group_powgh(goo, r2, e1, e2));
@@ -1844,93 +2308,54 @@ run_ops_test(goo_prng_t *rng) {
     mpz_clear(r2);
   }
 
-  /* test inv2 */
-  {
-    mpz_t e1, e2;
-    mpz_t e1_s, e2_s;
-    mpz_t e1_si, e2_si;
-    mpz_t r1, r2;
-    unsigned long i;
-
-    printf("Testing inv2...\n");
-
-    mpz_init(e1);
-    mpz_init(e2);
-    mpz_init(e1_s);
-    mpz_init(e2_s);
-    mpz_init(e1_si);
-    mpz_init(e2_si);
-
-    mpz_init(r1);
-    mpz_init(r2);
-
-    for (i = 0; i < 20; i++) {
-      goo_prng_random_bits(rng, e1, 2048);
-      goo_prng_random_bits(rng, e2, 2048);
-
-      mpz_fdiv_q_2exp(e1_s, e1, 1536);
-      mpz_fdiv_q_2exp(e2_s, e2, 1536);
-
-      assert(goo_group_inv2(goo, e1_si, e2_si, e1_s, e2_s));
-
-      mpz_mul(r1, e1_s, e1_si);
-      mpz_mod(r1, r1, goo->n);
-
-      mpz_mul(r2, e2_s, e2_si);
-      mpz_mod(r2, r1, goo->n);
-
-      goo_group_reduce(goo, r1, r1);
-      goo_group_reduce(goo, r2, r2);
-
-      assert(mpz_cmp_ui(r1, 1) == 0);
-      assert(mpz_cmp_ui(r2, 1) == 0);
-    }
-
-    mpz_clear(e1);
-    mpz_clear(e2);
-    mpz_clear(e1_s);
-    mpz_clear(e2_s);
-    mpz_clear(e1_si);
-    mpz_clear(e2_si);
-    mpz_clear(r1);
-    mpz_clear(r2);
-  }
-
-  /* test inv7 */
+  /* test inv_batch */
   {
-    mpz_t evals[7];
-    mpz_t einvs[7];
-    unsigned long i, j;
+    static const size_t lens[5] = {1, 2, 3, 7, 16};
+    mpz_t evals[16];
+    mpz_t einvs[16];
+    mpz_srcptr in[16];
+    mpz_ptr out[16];
+    unsigned long i, j, k;
 
-    printf("Testing inv7...\n");
+    printf("Testing inv_batch...\n");
 
-    for (i = 0; i < 7; i++) {
+    for (i = 0; i < 16; i++) {
       mpz_init(evals[i]);
       mpz_init(einvs[i]);
+      in[i] = evals[i];
+      out[i] = einvs[i];
     }
 
-    for (i = 0; i < 20; i++) {
-      for (j = 0; j < 7; j++)
-        goo_prng_random_bits(rng, evals[j], 2048);
+    assert(goo_group_inv_batch(goo, out, in, 0));
 
-      assert(goo_group_inv7(goo,
-        einvs[0], einvs[1], einvs[2], einvs[3], einvs[4], einvs[5], einvs[6],
-        evals[0], evals[1], evals[2], evals[3], evals[4], evals[5], evals[6]));
+    for (k = 0; k < 5; k++) {
+      for (i = 0; i < 20; i++) {
+        for (j = 0; j < lens[k]; j++)
+          goo_prng_random_bits(rng, evals[j], 2048);
 
-      for (j = 0; j < 7; j++) {
-        /* A 2^-2048 chance of happening by accident. */
-        assert(mpz_cmp_ui(evals[j], 1) != 0);
+        assert(goo_group_inv_batch(goo, out, in, lens[k]));
 
-        mpz_mul(evals[j], evals[j], einvs[j]);
-        mpz_mod(evals[j], evals[j], goo->n);
+        for (j = 0; j < lens[k]; j++) {
+          /* A 2^-2048 chance of happening by accident. */
+          assert(mpz_cmp_ui(evals[j], 1) != 0);
 
-        goo_group_reduce(goo, evals[j], evals[j]);
+          mpz_mul(evals[j], evals[j], einvs[j]);
+          mpz_mod(evals[j], evals[j], goo->n);
 
-        assert(mpz_cmp_ui(evals[j], 1) == 0);
+          assert(mpz_cmp_ui(evals[j], 1) == 0);
+        }
       }
     }
 
-    for (i = 0; i < 7; i++) {
+    /* One element without an inverse fails the batch. */
+    for (j = 0; j < 7; j++)
+      goo_prng_random_bits(rng, evals[j], 2048);
+
+    mpz_set(evals[4], goo->n);
+
+    assert(!goo_group_inv_batch(goo, out, in, 7));
+
+    for (i = 0; i < 16; i++) {
       mpz_clear(evals[i]);
       mpz_clear(einvs[i]);
     }
@@ -1950,7 +2375,7 @@ run_combspec_test(void) {
 
   printf("Testing combspec...\n");
 
-  assert(goo_combspec_init(&spec, GOO_CHAL_BITS, GOO_MAX_COMB_SIZE));
+  assert(goo_combspec_init(&spec, GOO_CHAL_BITS, GOO_MAX_COMB_SIZE, 1));
 
   bits = spec.bits_per_window * spec.points_per_add;
   points_per_subcomb = (1 << spec.points_per_add) - 1;
@@ -1963,6 +2388,17 @@ run_combspec_test(void) {
   assert(points_per_subcomb == 255);
   assert(spec.size == 510);
 
+  /* Joint combs square the subcombs. */
+  assert(goo_combspec_init(&spec, GOO_ELL_BITS, 4096, 2));
+
+  assert(spec.points_per_add == 5);
+  assert(spec.adds_per_shift == 4);
+  assert(spec.shifts == 7);
+  assert(spec.bits_per_window == 28);
+  assert(spec.size == 4092);
+
+  assert(!goo_combspec_init(&spec, GOO_ELL_BITS, 2, 2));
+
   mpz_init(n);
 
   goo_mpz_import(n, GOO_RSA2048, sizeof(GOO_RSA2048));
@@ -1971,6 +2407,51 @@ run_combspec_test(void) {
 
   assert(goo_group_init(goo, n, 2, 3, 0));
 
+#if GOO_MAX_JOINT_COMB_SIZE >= 4092
+  assert(goo->combs[0].joint);
+  assert(goo->combs[0].g.points_per_add == 5);
+  assert(goo->combs[0].g.adds_per_shift == 4);
+  assert(goo->combs[0].g.shifts == 7);
+  assert(goo->combs[0].g.bits_per_window == 28);
+  assert(goo->combs[0].g.bits == 140);
+  assert(goo->combs[0].g.points_per_subcomb == 1023);
+  assert(goo->combs[0].g.size == 4092);
+  assert(goo->combs[0].g.bases == 2);
+
+  /* The verifier's exponents. */
+  {
+    mpz_t e1, e2, r1, r2;
+    goo_prng_t rng;
+    unsigned char key[32];
+    unsigned long i;
+
+    memset(key, 0x55, sizeof(key));
+
+    goo_prng_init(&rng);
+    goo_prng_seed(&rng, key, GOO_PRNG_DERIVE);
+
+    mpz_init(e1);
+    mpz_init(e2);
+    mpz_init(r1);
+    mpz_init(r2);
+
+    for (i = 0; i < 20; i++) {
+      goo_prng_random_bits(&rng, e1, GOO_ELL_BITS);
+      goo_prng_random_bits(&rng, e2, i < 10 ? GOO_ELL_BITS : GOO_CHAL_BITS);
+
+      assert(goo_group_powgh_slow(goo, r1, e1, e2));
+      assert(goo_group_powgh(goo, r2, e1, e2));
+
+      assert(mpz_cmp(r1, r2) == 0);
+    }
+
+    mpz_clear(e1);
+    mpz_clear(e2);
+    mpz_clear(r1);
+    mpz_clear(r2);
+    goo_prng_uninit(&rng);
+  }
+#else
   assert(goo->combs[0].g.points_per_add == 7);
   assert(goo->combs[0].g.adds_per_shift == 4);
   assert(goo->combs[0].g.shifts == 5);
@@ -1986,6 +2467,7 @@ run_combspec_test(void) {
   assert(goo->combs[0].h.bits == 140);
   assert(goo->combs[0].h.points_per_subcomb == 127);
   assert(goo->combs[0].h.size == 508);
+#endif
 
   mpz_clear(n);
   goo_group_uninit(goo);
@@ -2196,6 +2678,32 @@ run_api_test(goo_prng_t *rng) {
   assert(goo_verify(goo, msg, sizeof(msg), sig, sig_len, C1, C1_len));
   assert(goo_verify(ver, msg, sizeof(msg), sig, sig_len, C1, C1_len));
 
+  /* Caller-provided output. */
+  {
+    unsigned char C1_out[256];
+    unsigned char *sig_out;
+
+    assert(goo_size(goo) == C1_len);
+    assert(goo_size(ver) == C1_len);
+    assert(goo_signature_size(goo) == sig_len);
+    assert(goo_signature_size(ver) == sig_len);
+
+    sig_out = goo_malloc(sig_len);
+
+    assert(goo_challenge_into(goo, C1_out, s_prime,
+                              MODULUS_4096, sizeof(MODULUS_4096)));
+
+    assert(memcmp(C1_out, C1, C1_len) == 0);
+
+    assert(goo_sign_into(goo, sig_out, msg, sizeof(msg), s_prime,
+                         PRIME_P_2048, sizeof(PRIME_P_2048),
+                         PRIME_Q_2048, sizeof(PRIME_Q_2048)));
+
+    assert(memcmp(sig_out, sig, sig_len) == 0);
+
+    goo_free(sig_out);
+  }
+
   goo_free(C1);
   goo_free(ct);
   goo_free(pt);
@@ -2204,12 +2712,529 @@ run_api_test(goo_prng_t *rng) {
   goo_destroy(ver);
 }
 
+static void
+run_presign_test(goo_prng_t *rng) {
+  unsigned char *C1, *sig1, *sig2, *sig3;
+  size_t C1_len, sig1_len, sig2_len, sig3_len;
+  unsigned char entropy[32];
+  unsigned char s_prime[32];
+  unsigned char msg[32];
+  goo_presig_t *presig, *other;
+  goo_group_t *goo, *clone, *aol;
+
+  printf("Testing presigning...\n");
+
+  goo_prng_generate(rng, entropy, sizeof(entropy));
+  goo_prng_generate(rng, s_prime, sizeof(s_prime));
+  goo_prng_generate(rng, msg, sizeof(msg));
+
+  goo = goo_create(GOO_RSA2048, sizeof(GOO_RSA2048), 2, 3, 2048);
+  aol = goo_create(GOO_AOL1, sizeof(GOO_AOL1), 2, 3, 2048);
+
+  assert(goo != NULL);
+  assert(aol != NULL);
+
+  clone = goo_clone(goo);
+
+  assert(clone != NULL);
+
+  assert(goo_challenge(goo, &C1, &C1_len, s_prime,
+                       MODULUS_2048, sizeof(MODULUS_2048)));
+
+  /* Clones share the combs and sign identically. */
+  assert(goo_sign(goo, &sig1, &sig1_len, msg, sizeof(msg), s_prime,
+                  PRIME_P_1024, sizeof(PRIME_P_1024),
+                  PRIME_Q_1024, sizeof(PRIME_Q_1024)));
+
+  assert(goo_sign(clone, &sig2, &sig2_len, msg, sizeof(msg), s_prime,
+                  PRIME_P_1024, sizeof(PRIME_P_1024),
+                  PRIME_Q_1024, sizeof(PRIME_Q_1024)));
+
+  assert(sig1_len == sig2_len);
+  assert(memcmp(sig1, sig2, sig1_len) == 0);
+
+  /* Clones do not count the shared tables. */
+  assert(goo_memory(clone) < goo_memory(goo));
+  assert(goo_memory(clone) >= sizeof(goo_group_t));
+
+  /* Presign on the clone, sign online on the parent. */
+  assert(goo_presign(clone, &presig, s_prime,
+                     PRIME_P_1024, sizeof(PRIME_P_1024),
+                     PRIME_Q_1024, sizeof(PRIME_Q_1024),
+                     entropy));
+
+  assert(goo_sign_with_presig(goo, &sig3, &sig3_len, presig,
+                              msg, sizeof(msg)));
+
+  assert(sig3_len == sig1_len);
+  assert(goo_verify(goo, msg, sizeof(msg), sig3, sig3_len, C1, C1_len));
+  assert(goo_verify(clone, msg, sizeof(msg), sig3, sig3_len, C1, C1_len));
+
+  /* Presignatures are consumed exactly once. */
+  assert(presig->used);
+  assert(!goo_sign_with_presig(goo, &sig2, &sig2_len, presig,
+                               msg, sizeof(msg)));
+
+  goo_presig_destroy(presig);
+
+  /* Presignatures are bound to their group. */
+  assert(goo_presign(goo, &other, s_prime,
+                     PRIME_P_1024, sizeof(PRIME_P_1024),
+                     PRIME_Q_1024, sizeof(PRIME_Q_1024),
+                     entropy));
+
+  assert(!goo_sign_with_presig(aol, &sig2, &sig2_len, other,
+                               msg, sizeof(msg)));
+  assert(other->used);
+
+  goo_presig_destroy(other);
+
+  /* Invalid keys are rejected offline. */
+  assert(!goo_presign(goo, &other, s_prime,
+                      PRIME_P_1024, sizeof(PRIME_P_1024),
+                      PRIME_P_1024, 1,
+                      entropy));
+
+  goo_free(C1);
+  goo_free(sig1);
+  goo_free(sig2);
+  goo_free(sig3);
+  goo_destroy(clone);
+  goo_destroy(goo);
+  goo_destroy(aol);
+}
+
+static void
+run_signer_test(goo_prng_t *rng) {
+  unsigned char *sig1, *sig2;
+  size_t sig1_len, sig2_len;
+  unsigned char s_prime[32];
+  unsigned char msg[32];
+  goo_group_t *goo, *clone, *aol;
+  goo_signer_t *signer;
+  size_t i;
+
+  printf("Testing prepared signer...\n");
+
+  goo_prng_generate(rng, s_prime, sizeof(s_prime));
+
+  goo = goo_create(GOO_RSA2048, sizeof(GOO_RSA2048), 2, 3, 2048);
+  aol = goo_create(GOO_AOL1, sizeof(GOO_AOL1), 2, 3, 2048);
+
+  assert(goo != NULL);
+  assert(aol != NULL);
+
+  clone = goo_clone(goo);
+
+  assert(clone != NULL);
+
+  signer = goo_signer_create(goo, s_prime,
+                             PRIME_P_1024, sizeof(PRIME_P_1024),
+                             PRIME_Q_1024, sizeof(PRIME_Q_1024));
+
+  assert(signer != NULL);
+
+  /* Prepared signatures match goo_sign exactly. */
+  for (i = 0; i < 4; i++) {
+    goo_group_t *ctx = (i & 1) ? clone : goo;
+
+    goo_prng_generate(rng, msg, sizeof(msg));
+
+    assert(goo_sign(goo, &sig1, &sig1_len, msg, sizeof(msg), s_prime,
+                    PRIME_P_1024, sizeof(PRIME_P_1024),
+                    PRIME_Q_1024, sizeof(PRIME_Q_1024)));
+
+    assert(goo_signer_sign(ctx, &sig2, &sig2_len, signer,
+                           msg, sizeof(msg)));
+
+    assert(sig1_len == sig2_len);
+    assert(memcmp(sig1, sig2, sig1_len) == 0);
+
+    goo_free(sig1);
+    goo_free(sig2);
+  }
+
+  /* Signers are bound to their group. */
+  assert(!goo_signer_sign(aol, &sig2, &sig2_len, signer, msg, sizeof(msg)));
+
+  goo_signer_destroy(signer);
+
+  /* Invalid keys are rejected up front. */
+  assert(goo_signer_create(goo, s_prime,
+                           PRIME_P_1024, sizeof(PRIME_P_1024),
+                           PRIME_P_1024, 1) == NULL);
+
+  goo_destroy(clone);
+  goo_destroy(goo);
+  goo_destroy(aol);
+}
+
+static void
+run_challenge_batch_test(goo_prng_t *rng) {
+  static const unsigned char expect[32] = {
+    0xcd, 0x7f, 0x03, 0x70, 0x30, 0x89, 0xf0, 0xbc,
+    0xde, 0x68, 0xcd, 0x20, 0x3e, 0x2a, 0x63, 0xf8,
+    0x72, 0xf3, 0x7b, 0xae, 0x6d, 0x44, 0xec, 0x36,
+    0x16, 0x5d, 0xa6, 0x7d, 0xb3, 0x1a, 0x3b, 0xff
+  };
+  static const unsigned char bad[1] = {0x03};
+  const unsigned char *ns[4];
+  size_t n_lens[4];
+  unsigned char seed[32];
+  unsigned char s_prime[32];
+  unsigned char s_primes[4 * 32];
+  unsigned char out1[4 * 256];
+  unsigned char out2[4 * 256];
+  unsigned char zero[256];
+  unsigned char *C1;
+  size_t C1_len;
+  goo_group_t *goo;
+  size_t i;
+
+  printf("Testing batch challenges...\n");
+
+  memset(seed, 0x00, sizeof(seed));
+  memset(zero, 0x00, sizeof(zero));
+
+  assert(goo_derive_sprime(NULL, s_prime, seed, 1));
+  assert(memcmp(s_prime, expect, 32) == 0);
+
+  goo_prng_generate(rng, seed, sizeof(seed));
+
+  goo = goo_create(GOO_RSA2048, sizeof(GOO_RSA2048), 2, 3, 4096);
+
+  assert(goo != NULL);
+
+  ns[0] = MODULUS_2048;
+  n_lens[0] = sizeof(MODULUS_2048);
+  ns[1] = MODULUS_4096;
+  n_lens[1] = sizeof(MODULUS_4096);
+  ns[2] = bad;
+  n_lens[2] = sizeof(bad);
+  ns[3] = MODULUS_2048;
+  n_lens[3] = sizeof(MODULUS_2048);
+
+  /* Derived s_primes, starting at index 7. */
+  assert(!goo_challenge_batch(goo, out1, s_primes, seed, 7, ns, n_lens, 4));
+
+  for (i = 0; i < 4; i++) {
+    assert(goo_derive_sprime(goo, s_prime, seed, 7 + i));
+    assert(memcmp(s_primes + i * 32, s_prime, 32) == 0);
+
+    if (ns[i] == bad) {
+      assert(memcmp(out1 + i * 256, zero, 256) == 0);
+      continue;
+    }
+
+    assert(goo_challenge(goo, &C1, &C1_len, s_prime, ns[i], n_lens[i]));
+    assert(C1_len == 256);
+    assert(memcmp(out1 + i * 256, C1, 256) == 0);
+
+    goo_free(C1);
+  }
+
+  /* Explicit s_primes. */
+  ns[2] = MODULUS_4096;
+  n_lens[2] = sizeof(MODULUS_4096);
+
+  assert(goo_challenge_batch(goo, out2, s_primes, NULL, 0, ns, n_lens, 4));
+  assert(memcmp(out2, out1, 2 * 256) == 0);
+  assert(memcmp(out2 + 3 * 256, out1 + 3 * 256, 256) == 0);
+
+  goo_destroy(goo);
+}
+
+static void
+run_encrypt_batch_test(goo_prng_t *rng) {
+  static const unsigned char exp[3] = {0x01, 0x00, 0x01};
+  static const unsigned char bad[1] = {0x03};
+  const unsigned char *ns[3];
+  const unsigned char *es[3];
+  size_t n_lens[3];
+  size_t e_lens[3];
+  unsigned char msgs[3 * 32];
+  unsigned char entropy[3 * 32];
+  unsigned char out[3 * GOO_CIPHERTEXT_SIZE];
+  unsigned char zero[GOO_CIPHERTEXT_SIZE];
+  unsigned char *pt;
+  size_t pt_len;
+  size_t i;
+
+  printf("Testing batch encryption...\n");
+
+  goo_prng_generate(rng, msgs, sizeof(msgs));
+  goo_prng_generate(rng, entropy, sizeof(entropy));
+
+  memset(zero, 0x00, sizeof(zero));
+
+  ns[0] = MODULUS_2048;
+  n_lens[0] = sizeof(MODULUS_2048);
+  ns[1] = MODULUS_4096;
+  n_lens[1] = sizeof(MODULUS_4096);
+  ns[2] = bad;
+  n_lens[2] = sizeof(bad);
+
+  for (i = 0; i < 3; i++) {
+    es[i] = exp;
+    e_lens[i] = sizeof(exp);
+  }
+
+  assert(!goo_encrypt_batch(NULL, out, msgs, 32, ns, n_lens,
+                            es, e_lens, entropy, 3));
+
+  assert(goo_decrypt(NULL, &pt, &pt_len, out, GOO_CIPHERTEXT_SIZE,
+                     PRIME_P_1024, sizeof(PRIME_P_1024),
+                     PRIME_Q_1024, sizeof(PRIME_Q_1024),
+                     exp, sizeof(exp), NULL, 0, entropy));
+
+  assert(pt_len == 32);
+  assert(memcmp(pt, msgs, 32) == 0);
+
+  goo_free(pt);
+
+  assert(goo_decrypt(NULL, &pt, &pt_len,
+                     out + GOO_CIPHERTEXT_SIZE, GOO_CIPHERTEXT_SIZE,
+                     PRIME_P_2048, sizeof(PRIME_P_2048),
+                     PRIME_Q_2048, sizeof(PRIME_Q_2048),
+                     exp, sizeof(exp), NULL, 0, entropy));
+
+  assert(pt_len == 32);
+  assert(memcmp(pt, msgs + 32, 32) == 0);
+
+  goo_free(pt);
+
+  assert(memcmp(out + 2 * GOO_CIPHERTEXT_SIZE, zero, sizeof(zero)) == 0);
+
+  assert(goo_encrypt_batch(NULL, out, msgs, 32, ns, n_lens,
+                           es, e_lens, entropy, 2));
+}
+
+static void
+run_verify_batch_test(goo_prng_t *rng) {
+  static const size_t pick[4] = {0, 1, 4, 6};
+  const unsigned char *msgs[7], *sigs[7], *C1s[7];
+  size_t msg_lens[7], sig_lens[7], C1_lens[7];
+  unsigned char msg[3][32];
+  unsigned char *sig[3];
+  size_t sig_len[3];
+  unsigned char *zero;
+  unsigned char entropy[32];
+  unsigned char s_prime[32];
+  unsigned char *C1;
+  size_t C1_len;
+  goo_group_t *goo, *ver;
+  int ok[7];
+  size_t i;
+
+  printf("Testing batch verification...\n");
+
+  goo_prng_generate(rng, entropy, sizeof(entropy));
+
+  goo = goo_create(GOO_RSA2048, sizeof(GOO_RSA2048), 2, 3, 4096);
+  ver = goo_create(GOO_RSA2048, sizeof(GOO_RSA2048), 2, 3, 0);
+
+  assert(goo != NULL);
+  assert(ver != NULL);
+
+  assert(goo_generate(goo, s_prime, entropy));
+
+  assert(goo_challenge(goo, &C1, &C1_len, s_prime,
+                       MODULUS_2048, sizeof(MODULUS_2048)));
+
+  for (i = 0; i < 3; i++) {
+    goo_prng_generate(rng, msg[i], 32);
+
+    assert(goo_sign(goo, &sig[i], &sig_len[i], msg[i], 32, s_prime,
+                    PRIME_P_1024, sizeof(PRIME_P_1024),
+                    PRIME_Q_1024, sizeof(PRIME_Q_1024)));
+  }
+
+  for (i = 0; i < 7; i++) {
+    msgs[i] = msg[0];
+    msg_lens[i] = 32;
+    sigs[i] = sig[0];
+    sig_lens[i] = sig_len[0];
+    C1s[i] = C1;
+    C1_lens[i] = C1_len;
+  }
+
+  /* Valid, valid, wrong message, truncated, valid, short C1, valid. */
+  msgs[1] = msg[1];
+  sigs[1] = sig[1];
+  sig_lens[1] = sig_len[1];
+
+  msgs[2] = msg[2];
+  sigs[2] = sig[1];
+  sig_lens[2] = sig_len[1];
+
+  sig_lens[3] -= 1;
+
+  msgs[4] = msg[2];
+  sigs[4] = sig[2];
+  sig_lens[4] = sig_len[2];
+
+  C1_lens[5] -= 1;
+
+  assert(!goo_verify_batch(ver, ok, msgs, msg_lens, sigs, sig_lens,
+                           C1s, C1_lens, 7));
+
+  for (i = 0; i < 7; i++) {
+    assert(ok[i] == goo_verify(ver, msgs[i], msg_lens[i],
+                               sigs[i], sig_lens[i],
+                               C1s[i], C1_lens[i]));
+    assert(ok[i] == (i == 0 || i == 1 || i == 4 || i == 6));
+  }
+
+  /* Only the valid ones. */
+  for (i = 0; i < 4; i++) {
+    msgs[i] = msgs[pick[i]];
+    sigs[i] = sigs[pick[i]];
+    sig_lens[i] = sig_lens[pick[i]];
+    C1_lens[i] = C1_lens[pick[i]];
+  }
+
+  assert(goo_verify_batch(goo, ok, msgs, msg_lens, sigs, sig_lens,
+                          C1s, C1_lens, 4));
+  assert(ok[0] && ok[1] && ok[2] && ok[3]);
+
+  assert(goo_verify_batch(ver, ok, msgs, msg_lens, sigs, sig_lens,
+                          C1s, C1_lens, 0));
+
+  /* A C2 of zero passes the range checks but has no inverse: */
+  /* the shared inversion fails, and only that signature with it. */
+  zero = goo_malloc(sig_lens[1]);
+  memcpy(zero, sigs[1], sig_lens[1]);
+  memset(zero, 0x00, goo_size(ver));
+
+  sigs[1] = zero;
+
+  assert(!goo_verify_batch(ver, ok, msgs, msg_lens, sigs, sig_lens,
+                           C1s, C1_lens, 4));
+  assert(ok[0] && !ok[1] && ok[2] && ok[3]);
+
+  goo_free(zero);
+
+  for (i = 0; i < 3; i++)
+    goo_free(sig[i]);
+
+  goo_free(C1);
+  goo_destroy(goo);
+  goo_destroy(ver);
+}
+
+static void
+run_rsakey_test(goo_prng_t *rng) {
+  static const unsigned char exp[3] = {0x01, 0x00, 0x01};
+  unsigned char entropy[32];
+  unsigned char msg[32];
+  unsigned char *ct, *pt;
+  size_t ct_len, pt_len;
+  goo_rsakey_t *key;
+  size_t i;
+
+  printf("Testing prepared RSA key...\n");
+
+  key = goo_rsakey_create(PRIME_P_2048, sizeof(PRIME_P_2048),
+                          PRIME_Q_2048, sizeof(PRIME_Q_2048),
+                          exp, sizeof(exp));
+
+  assert(key != NULL);
+
+  for (i = 0; i < 4; i++) {
+    goo_prng_generate(rng, msg, sizeof(msg));
+    goo_prng_generate(rng, entropy, sizeof(entropy));
+
+    assert(goo_encrypt(NULL, &ct, &ct_len, msg, sizeof(msg),
+                       MODULUS_4096, sizeof(MODULUS_4096),
+                       exp, sizeof(exp), NULL, 0, entropy));
+
+    assert(goo_rsakey_decrypt(NULL, &pt, &pt_len, key, ct, ct_len,
+                              NULL, 0, entropy));
+
+    assert(pt_len == sizeof(msg));
+    assert(memcmp(pt, msg, pt_len) == 0);
+
+    goo_free(pt);
+
+    /* Wrong label. */
+    assert(!goo_rsakey_decrypt(NULL, &pt, &pt_len, key, ct, ct_len,
+                               msg, 1, entropy));
+
+    /* Corrupted ciphertext. */
+    ct[ct_len - 1] ^= 1;
+
+    assert(!goo_rsakey_decrypt(NULL, &pt, &pt_len, key, ct, ct_len,
+                               NULL, 0, entropy));
+
+    goo_free(ct);
+  }
+
+  /* Scanning. Records 2 and 4 are ours; 3 is garbage. */
+  {
+    unsigned char data[5 * GOO_CIPHERTEXT_SIZE];
+    unsigned char msgs[5 * 32];
+    unsigned char found[32];
+    size_t index;
+
+    goo_prng_generate(rng, msgs, sizeof(msgs));
+
+    for (i = 0; i < 5; i++) {
+      int ours = (i == 2 || i == 4);
+
+      goo_prng_generate(rng, entropy, sizeof(entropy));
+
+      if (i == 3) {
+        goo_prng_generate(rng, data + i * GOO_CIPHERTEXT_SIZE,
+                          GOO_CIPHERTEXT_SIZE);
+        data[i * GOO_CIPHERTEXT_SIZE] = 0x00;
+        continue;
+      }
+
+      assert(goo_encrypt(NULL, &ct, &ct_len, msgs + i * 32, 32,
+                         ours ? MODULUS_4096 : MODULUS_2048,
+                         ours ? sizeof(MODULUS_4096)
+                              : sizeof(MODULUS_2048),
+                         exp, sizeof(exp), NULL, 0, entropy));
+
+      assert(ct_len == GOO_CIPHERTEXT_SIZE);
+
+      memcpy(data + i * GOO_CIPHERTEXT_SIZE, ct, ct_len);
+
+      goo_free(ct);
+    }
+
+    assert(goo_rsakey_scan(NULL, &index, found, key, data, 5, 32, entropy));
+    assert(index == 2);
+    assert(memcmp(found, msgs + 2 * 32, 32) == 0);
+
+    assert(goo_rsakey_scan(NULL, &index, found, key,
+                           data + 3 * GOO_CIPHERTEXT_SIZE, 2, 32, entropy));
+    assert(index == 1);
+    assert(memcmp(found, msgs + 4 * 32, 32) == 0);
+
+    assert(!goo_rsakey_scan(NULL, &index, found, key, data, 2, 32, entropy));
+    assert(!goo_rsakey_scan(NULL, &index, found, key, data, 5, 31, entropy));
+  }
+
+  goo_rsakey_destroy(key);
+
+  /* Invalid keys are rejected up front. */
+  assert(goo_rsakey_create(PRIME_P_2048, sizeof(PRIME_P_2048),
+                           PRIME_P_2048, 1,
+                           exp, sizeof(exp)) == NULL);
+}
+
 int
 main(void) {
   goo_prng_t rng;
 
-  (void)PRIME_Q_1024;
-  (void)MODULUS_2048;
+#ifdef GOO_HAS_DLGMP
+  /* Run against a system libgmp instead of mini-gmp. */
+  if (getenv("GOO_TEST_DLGMP") != NULL)
+    assert(goo_load_gmp());
+#endif
+
+  printf("Using %s.\n", goo_backend());
 
   rng_init(&rng);
 
@@ -2222,11 +3247,19 @@ main(void) {
 #endif
   run_util_test(&rng);
   run_primes_test(&rng);
+  run_mpz_test(&rng);
+  run_mont_test(&rng);
   run_ops_test(&rng);
   run_combspec_test();
   run_sig_test();
   run_goo_test(&rng);
   run_api_test(&rng);
+  run_presign_test(&rng);
+  run_signer_test(&rng);
+  run_challenge_batch_test(&rng);
+  run_encrypt_batch_test(&rng);
+  run_verify_batch_test(&rng);
+  run_rsakey_test(&rng);
 
   rng_clear(&rng);
 
@@ -10,8 +10,26 @@
 #include <string.h>
 #include <stdio.h>
 #include <node_api.h>
+#include <uv.h>
 #include "goo/goo.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #define CHECK(expr) do {                           \
   if (!(expr))                                     \
     goosig_assert_fail(__FILE__, __LINE__, #expr); \
@@ -29,7 +47,36 @@
 #define JS_ERR_SPRIME_SIZE "Invalid s_prime size."
 #define JS_ERR_GENERATE "Could not generate s_prime."
 #define JS_ERR_CHALLENGE "Could not create challenge."
+#define JS_ERR_OUTPUT_SIZE "Invalid output size."
+#define JS_ERR_SPRIMES_SIZE "Invalid s_primes size."
+#define JS_ERR_SEED_SIZE "Invalid seed size."
 #define JS_ERR_SIGN "Could not sign."
+#define JS_ERR_ENCRYPT "Could not encrypt."
+#define JS_ERR_DECRYPT "Could not decrypt."
+#define JS_ERR_KEY "Invalid RSA private key."
+#define JS_ERR_FILE "Could not read ciphertext file."
+#define JS_ERR_PRESIGN "Could not presign."
+#define JS_ERR_SIGNER "Could not prepare signer."
+#define JS_ERR_OP "Invalid operation."
+#define JS_ERR_POOL "Invalid pool options."
+#define JS_ERR_POOL_CLOSED "Pool is closed."
+
+/* Operations with latency histograms. */
+#define GOOSIG_OP_CHALLENGE 0
+#define GOOSIG_OP_VALIDATE 1
+#define GOOSIG_OP_SIGN 2
+#define GOOSIG_OP_VERIFY 3
+#define GOOSIG_OP_MAX 4
+
+/* Log-bucketed (HDR-style) histogram layout. Each power of two is split
+ * into 2^GOOSIG_HIST_SUB_BITS linear sub-buckets, bounding the relative
+ * error of a reported percentile to 1/2^(GOOSIG_HIST_SUB_BITS + 1).
+ * Values are nanoseconds and saturate at 2^GOOSIG_HIST_EXP_BITS - 1. */
+#define GOOSIG_HIST_SUB_BITS 3
+#define GOOSIG_HIST_SUB (1 << GOOSIG_HIST_SUB_BITS)
+#define GOOSIG_HIST_EXP_BITS 48
+#define GOOSIG_HIST_LEN \
+  ((GOOSIG_HIST_EXP_BITS - GOOSIG_HIST_SUB_BITS + 1) * GOOSIG_HIST_SUB)
 
 /*
  * Assertions
@@ -42,14 +89,584 @@ goosig_assert_fail(const char *file, int line, const char *expr) {
   abort();
 }
 
+/*
+ * Helpers
+ */
+
+static void
+goosig_cleanse(void *ptr, size_t len) {
+  volatile uint8_t *p = (volatile uint8_t *)ptr;
+
+  while (len--)
+    *p++ = 0;
+}
+
+/*
+ * Atomics
+ */
+
+#ifdef _MSC_VER
+static void
+goosig_atomic_add(volatile uint64_t *ptr, uint64_t val) {
+  _InterlockedExchangeAdd64((volatile __int64 *)ptr, (__int64)val);
+}
+
+static uint64_t
+goosig_atomic_load(volatile uint64_t *ptr) {
+  return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)ptr, 0, 0);
+}
+
+static void
+goosig_atomic_store(volatile uint64_t *ptr, uint64_t val) {
+  _InterlockedExchange64((volatile __int64 *)ptr, (__int64)val);
+}
+
+static bool
+goosig_atomic_cas(volatile uint64_t *ptr, uint64_t expect, uint64_t val) {
+  return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)ptr,
+                                                 (__int64)val,
+                                                 (__int64)expect) == expect;
+}
+
+static uint64_t
+goosig_atomic_acquire(volatile uint64_t *ptr) {
+  return goosig_atomic_load(ptr);
+}
+
+static void
+goosig_atomic_release(volatile uint64_t *ptr, uint64_t val) {
+  goosig_atomic_store(ptr, val);
+}
+#else
+static void
+goosig_atomic_add(volatile uint64_t *ptr, uint64_t val) {
+  __atomic_fetch_add(ptr, val, __ATOMIC_RELAXED);
+}
+
+static uint64_t
+goosig_atomic_load(volatile uint64_t *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_RELAXED);
+}
+
+static void
+goosig_atomic_store(volatile uint64_t *ptr, uint64_t val) {
+  __atomic_store_n(ptr, val, __ATOMIC_RELAXED);
+}
+
+static bool
+goosig_atomic_cas(volatile uint64_t *ptr, uint64_t expect, uint64_t val) {
+  return __atomic_compare_exchange_n(ptr, &expect, val, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
+static uint64_t
+goosig_atomic_acquire(volatile uint64_t *ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static void
+goosig_atomic_release(volatile uint64_t *ptr, uint64_t val) {
+  __atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+#endif
+
+/*
+ * Backend
+ */
+
+static uv_once_t goosig_backend_once = UV_ONCE_INIT;
+
+static void
+goosig_backend_init(void) {
+  /* Set GOOSIG_NO_GMP to stay on the bundled mini-gmp. */
+  if (getenv("GOOSIG_NO_GMP") == NULL)
+    goo_load_gmp();
+}
+
+static napi_value
+goosig_backend(napi_env env, napi_callback_info info) {
+  napi_value result;
+
+  CHECK(napi_create_string_latin1(env,
+                                  goo_backend(),
+                                  NAPI_AUTO_LENGTH,
+                                  &result) == napi_ok);
+
+  return result;
+}
+
+/*
+ * Histogram
+ */
+
+typedef struct goosig_hist_s {
+  volatile uint64_t count;
+  volatile uint64_t sum;
+  volatile uint64_t min;
+  volatile uint64_t max;
+  volatile uint64_t buckets[GOOSIG_HIST_LEN];
+} goosig_hist_t;
+
+/* Process-wide histograms, shared by all contexts (and workers). */
+static goosig_hist_t goosig_hists[GOOSIG_OP_MAX];
+static uv_once_t goosig_hists_once = UV_ONCE_INIT;
+
+static size_t
+goosig_hist_index(uint64_t val) {
+  uint64_t max = ((uint64_t)1 << GOOSIG_HIST_EXP_BITS) - 1;
+  size_t bits = 0;
+  size_t shift;
+
+  if (val > max)
+    val = max;
+
+  if (val < GOOSIG_HIST_SUB)
+    return (size_t)val;
+
+  while ((val >> bits) > 1)
+    bits += 1;
+
+  shift = bits - GOOSIG_HIST_SUB_BITS;
+
+  return (shift + 1) * GOOSIG_HIST_SUB
+       + (size_t)((val >> shift) - GOOSIG_HIST_SUB);
+}
+
+static double
+goosig_hist_value(size_t index) {
+  /* Midpoint of the bucket. */
+  size_t shift;
+  uint64_t lo;
+
+  if (index < GOOSIG_HIST_SUB)
+    return (double)index;
+
+  shift = index / GOOSIG_HIST_SUB - 1;
+  lo = (uint64_t)(GOOSIG_HIST_SUB + index % GOOSIG_HIST_SUB) << shift;
+
+  return (double)lo + (double)((uint64_t)1 << shift) / 2.0;
+}
+
+static void
+goosig_hist_reset(goosig_hist_t *hist) {
+  size_t i;
+
+  goosig_atomic_store(&hist->count, 0);
+  goosig_atomic_store(&hist->sum, 0);
+  goosig_atomic_store(&hist->min, UINT64_MAX);
+  goosig_atomic_store(&hist->max, 0);
+
+  for (i = 0; i < GOOSIG_HIST_LEN; i++)
+    goosig_atomic_store(&hist->buckets[i], 0);
+}
+
+static void
+goosig_hists_init(void) {
+  int i;
+
+  for (i = 0; i < GOOSIG_OP_MAX; i++)
+    goosig_hist_reset(&goosig_hists[i]);
+}
+
+static void
+goosig_hist_record(goosig_hist_t *hist, uint64_t val) {
+  uint64_t cur;
+
+  goosig_atomic_add(&hist->buckets[goosig_hist_index(val)], 1);
+  goosig_atomic_add(&hist->count, 1);
+  goosig_atomic_add(&hist->sum, val);
+
+  do {
+    cur = goosig_atomic_load(&hist->min);
+  } while (val < cur && !goosig_atomic_cas(&hist->min, cur, val));
+
+  do {
+    cur = goosig_atomic_load(&hist->max);
+  } while (val > cur && !goosig_atomic_cas(&hist->max, cur, val));
+}
+
+static double
+goosig_hist_percentile(const uint64_t *buckets,
+                       uint64_t count,
+                       double min,
+                       double max,
+                       double q) {
+  uint64_t target = (uint64_t)(q * (double)count + 0.5);
+  uint64_t total = 0;
+  double val = max;
+  size_t i;
+
+  if (target == 0)
+    target = 1;
+
+  for (i = 0; i < GOOSIG_HIST_LEN; i++) {
+    total += buckets[i];
+
+    if (total >= target) {
+      val = goosig_hist_value(i);
+      break;
+    }
+  }
+
+  if (val < min)
+    val = min;
+
+  if (val > max)
+    val = max;
+
+  return val;
+}
+
+static void
+goosig_set_number(napi_env env, napi_value obj, const char *name, double x) {
+  napi_value val;
+
+  CHECK(napi_create_double(env, x, &val) == napi_ok);
+  CHECK(napi_set_named_property(env, obj, name, val) == napi_ok);
+}
+
+static napi_value
+goosig_hist_export(napi_env env, goosig_hist_t *hist) {
+  static const struct {
+    const char *name;
+    double q;
+  } quantiles[] = {
+    { "p50", 0.50 },
+    { "p90", 0.90 },
+    { "p99", 0.99 },
+    { "p999", 0.999 }
+  };
+
+  uint64_t *buckets = (uint64_t *)malloc(GOOSIG_HIST_LEN * sizeof(uint64_t));
+  uint64_t count = 0;
+  uint64_t sum = goosig_atomic_load(&hist->sum);
+  double min = 0;
+  double max = (double)goosig_atomic_load(&hist->max);
+  napi_value result;
+  size_t i;
+
+  CHECK(buckets != NULL);
+
+  /* Recorders may race with us; derive the count */
+  /* from the bucket snapshot so the quantiles agree. */
+  for (i = 0; i < GOOSIG_HIST_LEN; i++) {
+    buckets[i] = goosig_atomic_load(&hist->buckets[i]);
+    count += buckets[i];
+  }
+
+  if (count > 0)
+    min = (double)goosig_atomic_load(&hist->min);
+
+  CHECK(napi_create_object(env, &result) == napi_ok);
+
+  goosig_set_number(env, result, "count", (double)count);
+  goosig_set_number(env, result, "min", min);
+  goosig_set_number(env, result, "max", max);
+  goosig_set_number(env, result, "mean",
+                    count > 0 ? (double)sum / (double)count : 0);
+
+  for (i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+    double val = 0;
+
+    if (count > 0)
+      val = goosig_hist_percentile(buckets, count, min, max, quantiles[i].q);
+
+    goosig_set_number(env, result, quantiles[i].name, val);
+  }
+
+  free(buckets);
+
+  return result;
+}
+
+/*
+ * Parallelism
+ */
+
+typedef int goosig_range_f(void *arg, goo_ctx_t *ctx,
+                           size_t start, size_t end);
+
+typedef struct goosig_chunk_s {
+  goosig_range_f *func;
+  void *arg;
+  const goo_ctx_t *parent;
+  uv_thread_t thread;
+  size_t start;
+  size_t end;
+  int ok;
+} goosig_chunk_t;
+
+static void
+goosig_chunk_run(void *data) {
+  goosig_chunk_t *chunk = (goosig_chunk_t *)data;
+  goo_ctx_t *ctx = NULL;
+
+  if (chunk->end == chunk->start) {
+    chunk->ok = 1;
+    return;
+  }
+
+  /* Every thread gets a clone sharing the combs. */
+  if (chunk->parent != NULL) {
+    ctx = goo_clone(chunk->parent);
+    CHECK(ctx != NULL);
+  }
+
+  chunk->ok = chunk->func(chunk->arg, ctx, chunk->start, chunk->end);
+
+  goo_destroy(ctx);
+}
+
+static int
+goosig_parallel(const goo_ctx_t *parent,
+                size_t len,
+                uint32_t threads,
+                goosig_range_f *func,
+                void *arg) {
+  goosig_chunk_t *chunks;
+  size_t per;
+  uint32_t i;
+  int ok;
+
+  if (threads > len)
+    threads = len > 0 ? len : 1;
+
+  if (threads == 0)
+    threads = 1;
+
+  chunks = (goosig_chunk_t *)calloc(threads, sizeof(goosig_chunk_t));
+
+  CHECK(chunks != NULL);
+
+  per = (len + threads - 1) / threads;
+
+  for (i = 0; i < threads; i++) {
+    chunks[i].func = func;
+    chunks[i].arg = arg;
+    chunks[i].parent = parent;
+    chunks[i].start = i * per < len ? i * per : len;
+    chunks[i].end = chunks[i].start + per < len
+                  ? chunks[i].start + per
+                  : len;
+  }
+
+  /* The first chunk runs on the calling (pool) thread. */
+  for (i = 1; i < threads; i++) {
+    CHECK(uv_thread_create(&chunks[i].thread, goosig_chunk_run,
+                           &chunks[i]) == 0);
+  }
+
+  goosig_chunk_run(&chunks[0]);
+
+  ok = chunks[0].ok;
+
+  for (i = 1; i < threads; i++) {
+    CHECK(uv_thread_join(&chunks[i].thread) == 0);
+    ok &= chunks[i].ok;
+  }
+
+  free(chunks);
+
+  return ok;
+}
+
+/*
+ * Registry
+ */
+
+/* Identical groups share one set of combs, process-wide (and so across
+ * worker threads). Each entry owns a template context which is never
+ * used directly; every handle works on its own clone of it. */
+typedef struct goosig_group_s {
+  struct goosig_group_s *next;
+  uint8_t *n;
+  size_t n_len;
+  uint32_t g;
+  uint32_t h;
+  uint32_t bits;
+  goo_ctx_t *ctx;
+  size_t refs;
+} goosig_group_t;
+
+static uv_once_t goosig_registry_once = UV_ONCE_INIT;
+static uv_mutex_t goosig_registry_lock;
+static goosig_group_t *goosig_registry;
+
+static void
+goosig_registry_init(void) {
+  CHECK(uv_mutex_init(&goosig_registry_lock) == 0);
+}
+
+static goosig_group_t *
+goosig_registry_find(const uint8_t *n, size_t n_len,
+                     uint32_t g, uint32_t h, uint32_t bits) {
+  goosig_group_t *group;
+
+  for (group = goosig_registry; group != NULL; group = group->next) {
+    if (group->n_len == n_len
+        && group->g == g
+        && group->h == h
+        && group->bits == bits
+        && memcmp(group->n, n, n_len) == 0) {
+      return group;
+    }
+  }
+
+  return NULL;
+}
+
+static goosig_group_t *
+goosig_registry_acquire(const uint8_t *n, size_t n_len,
+                        uint32_t g, uint32_t h, uint32_t bits) {
+  goosig_group_t *group;
+  goo_ctx_t *ctx;
+
+  while (n_len > 0 && n[0] == 0x00) {
+    n += 1;
+    n_len -= 1;
+  }
+
+  uv_mutex_lock(&goosig_registry_lock);
+
+  group = goosig_registry_find(n, n_len, g, h, bits);
+
+  if (group != NULL)
+    group->refs += 1;
+
+  uv_mutex_unlock(&goosig_registry_lock);
+
+  if (group != NULL)
+    return group;
+
+  /* Build the combs without holding the lock. */
+  ctx = goo_create(n, n_len, g, h, bits);
+
+  if (ctx == NULL)
+    return NULL;
+
+  uv_mutex_lock(&goosig_registry_lock);
+
+  group = goosig_registry_find(n, n_len, g, h, bits);
+
+  if (group != NULL) {
+    /* Lost the race. */
+    group->refs += 1;
+  } else {
+    group = (goosig_group_t *)malloc(sizeof(goosig_group_t));
+
+    CHECK(group != NULL);
+
+    group->n = (uint8_t *)malloc(n_len + 1);
+
+    CHECK(group->n != NULL);
+
+    memcpy(group->n, n, n_len);
+
+    group->n_len = n_len;
+    group->g = g;
+    group->h = h;
+    group->bits = bits;
+    group->ctx = ctx;
+    group->refs = 1;
+    group->next = goosig_registry;
+
+    goosig_registry = group;
+    ctx = NULL;
+  }
+
+  uv_mutex_unlock(&goosig_registry_lock);
+
+  goo_destroy(ctx);
+
+  return group;
+}
+
+static void
+goosig_registry_retain(goosig_group_t *group) {
+  uv_mutex_lock(&goosig_registry_lock);
+  CHECK(group->refs > 0);
+  group->refs += 1;
+  uv_mutex_unlock(&goosig_registry_lock);
+}
+
+static void
+goosig_registry_release(goosig_group_t *group) {
+  goosig_group_t **link;
+
+  uv_mutex_lock(&goosig_registry_lock);
+
+  CHECK(group->refs > 0);
+
+  group->refs -= 1;
+
+  if (group->refs > 0) {
+    uv_mutex_unlock(&goosig_registry_lock);
+    return;
+  }
+
+  for (link = &goosig_registry; *link != group; link = &(*link)->next)
+    CHECK(*link != NULL);
+
+  *link = group->next;
+
+  uv_mutex_unlock(&goosig_registry_lock);
+
+  goo_destroy(group->ctx);
+  free(group->n);
+  free(group);
+}
+
+static napi_value
+goosig_registry_stats(napi_env env, napi_callback_info info) {
+  goosig_group_t *group;
+  size_t groups = 0;
+  size_t refs = 0;
+  size_t memory = 0;
+  napi_value result;
+
+  uv_mutex_lock(&goosig_registry_lock);
+
+  for (group = goosig_registry; group != NULL; group = group->next) {
+    groups += 1;
+    refs += group->refs;
+    memory += goo_memory(group->ctx);
+  }
+
+  uv_mutex_unlock(&goosig_registry_lock);
+
+  CHECK(napi_create_object(env, &result) == napi_ok);
+
+  goosig_set_number(env, result, "groups", (double)groups);
+  goosig_set_number(env, result, "references", (double)refs);
+  goosig_set_number(env, result, "memory", (double)memory);
+
+  return result;
+}
+
 /*
  * GooSig
  */
 
+typedef struct goosig_s {
+  goosig_group_t *group;
+  goo_ctx_t *ctx;
+  goosig_hist_t hists[GOOSIG_OP_MAX];
+} goosig_t;
+
+static void
+goosig_record(goosig_t *goo, int op, uint64_t start) {
+  uint64_t elapsed = uv_hrtime() - start;
+
+  goosig_hist_record(&goo->hists[op], elapsed);
+  goosig_hist_record(&goosig_hists[op], elapsed);
+}
+
 static void
 goosig_destroy(napi_env env, void *data, void *hint) {
-  goo_ctx_t *goo = (goo_ctx_t *)data;
-  goo_destroy(goo);
+  goosig_t *goo = (goosig_t *)data;
+  goo_destroy(goo->ctx);
+  goosig_registry_release(goo->group);
+  free(goo);
 }
 
 static napi_value
@@ -59,8 +676,11 @@ goosig_create(napi_env env, napi_callback_info info) {
   const uint8_t *n;
   size_t n_len;
   uint32_t g, h, bits;
-  goo_ctx_t *goo;
+  goosig_group_t *group;
+  goo_ctx_t *ctx;
+  goosig_t *goo;
   napi_value handle;
+  int i;
 
   CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
   CHECK(argc == 4);
@@ -69,9 +689,23 @@ goosig_create(napi_env env, napi_callback_info info) {
   CHECK(napi_get_value_uint32(env, argv[2], &h) == napi_ok);
   CHECK(napi_get_value_uint32(env, argv[3], &bits) == napi_ok);
 
-  goo = goo_create(n, n_len, g, h, bits);
+  group = goosig_registry_acquire(n, n_len, g, h, bits);
+
+  JS_ASSERT(group != NULL, JS_ERR_CONTEXT);
+
+  ctx = goo_clone(group->ctx);
+
+  CHECK(ctx != NULL);
 
-  JS_ASSERT(goo != NULL, JS_ERR_CONTEXT);
+  goo = (goosig_t *)malloc(sizeof(goosig_t));
+
+  CHECK(goo != NULL);
+
+  goo->group = group;
+  goo->ctx = ctx;
+
+  for (i = 0; i < GOOSIG_OP_MAX; i++)
+    goosig_hist_reset(&goo->hists[i]);
 
   CHECK(napi_create_external(env,
                              goo,
@@ -109,11 +743,12 @@ goosig_challenge(napi_env env, napi_callback_info info) {
   napi_value argv[3];
   size_t argc = 3;
   uint8_t *out;
-  size_t out_len;
   const uint8_t *s_prime, *n;
   size_t s_prime_len, n_len;
-  goo_ctx_t *goo;
+  goosig_t *goo;
   napi_value result;
+  uint64_t start;
+  int ok;
 
   CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
   CHECK(argc == 3);
@@ -123,38 +758,269 @@ goosig_challenge(napi_env env, napi_callback_info info) {
   CHECK(napi_get_buffer_info(env, argv[2], (void **)&n, &n_len) == napi_ok);
 
   JS_ASSERT(s_prime_len == 32, JS_ERR_SPRIME_SIZE);
-  JS_ASSERT(goo_challenge(goo, &out, &out_len, s_prime, n, n_len),
-            JS_ERR_CHALLENGE);
 
-  CHECK(napi_create_buffer_copy(env, out_len, out, NULL, &result) == napi_ok);
+  CHECK(napi_create_buffer(env, goo_size(goo->ctx), (void **)&out,
+                           &result) == napi_ok);
 
-  free(out);
+  start = uv_hrtime();
+  ok = goo_challenge_into(goo->ctx, out, s_prime, n, n_len);
+  goosig_record(goo, GOOSIG_OP_CHALLENGE, start);
+
+  JS_ASSERT(ok, JS_ERR_CHALLENGE);
 
   return result;
 }
 
-static napi_value
-goosig_validate(napi_env env, napi_callback_info info) {
-  napi_value argv[5];
-  size_t argc = 5;
-  const uint8_t *s_prime, *C1, *p, *q;
-  size_t s_prime_len, C1_len, p_len, q_len;
-  goo_ctx_t *goo;
-  napi_value result;
+typedef struct goosig_batch_job_s {
+  goosig_t *goo;
+  napi_ref ref;
+  napi_ref out_ref;
+  napi_ref s_primes_ref;
+  napi_ref callback;
+  napi_async_work work;
+  uint8_t *out;
+  uint8_t *s_primes;
+  uint8_t seed[32];
+  int has_seed;
+  uint32_t offset;
+  uint8_t *data;
+  const uint8_t **ns;
+  size_t *n_lens;
+  size_t len;
+  uint32_t threads;
   int ok;
+} goosig_batch_job_t;
 
-  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
-  CHECK(argc == 5);
-  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
-  CHECK(napi_get_buffer_info(env, argv[1], (void **)&s_prime,
-                             &s_prime_len) == napi_ok);
-  CHECK(napi_get_buffer_info(env, argv[2], (void **)&C1, &C1_len) == napi_ok);
-  CHECK(napi_get_buffer_info(env, argv[3], (void **)&p, &p_len) == napi_ok);
-  CHECK(napi_get_buffer_info(env, argv[4], (void **)&q, &q_len) == napi_ok);
+static int
+goosig_batch_range(void *arg, goo_ctx_t *ctx, size_t start, size_t end) {
+  goosig_batch_job_t *job = (goosig_batch_job_t *)arg;
+
+  return goo_challenge_batch(ctx,
+                             job->out + start * goo_size(job->goo->ctx),
+                             job->s_primes != NULL
+                               ? job->s_primes + start * 32
+                               : NULL,
+                             job->has_seed ? job->seed : NULL,
+                             job->offset + start,
+                             job->ns + start,
+                             job->n_lens + start,
+                             end - start);
+}
+
+static void
+goosig_batch_execute(napi_env env, void *data) {
+  goosig_batch_job_t *job = (goosig_batch_job_t *)data;
+
+  job->ok = goosig_parallel(job->goo->ctx, job->len, job->threads,
+                            goosig_batch_range, job);
+}
+
+static void
+goosig_batch_complete(napi_env env, napi_status status, void *data) {
+  goosig_batch_job_t *job = (goosig_batch_job_t *)data;
+  napi_value argv[1];
+  napi_value callback, global, msg;
+
+  if (status != napi_ok)
+    job->ok = 0;
+
+  if (job->ok) {
+    CHECK(napi_get_null(env, &argv[0]) == napi_ok);
+  } else {
+    CHECK(napi_create_string_utf8(env, JS_ERR_CHALLENGE,
+                                  NAPI_AUTO_LENGTH, &msg) == napi_ok);
+    CHECK(napi_create_error(env, NULL, msg, &argv[0]) == napi_ok);
+  }
+
+  CHECK(napi_get_reference_value(env, job->callback, &callback) == napi_ok);
+  CHECK(napi_get_global(env, &global) == napi_ok);
+
+  CHECK(napi_delete_async_work(env, job->work) == napi_ok);
+  CHECK(napi_delete_reference(env, job->callback) == napi_ok);
+  CHECK(napi_delete_reference(env, job->ref) == napi_ok);
+  CHECK(napi_delete_reference(env, job->out_ref) == napi_ok);
+
+  if (job->s_primes_ref != NULL)
+    CHECK(napi_delete_reference(env, job->s_primes_ref) == napi_ok);
+
+  goosig_cleanse(job->seed, sizeof(job->seed));
+
+  free(job->data);
+  free(job->ns);
+  free(job->n_lens);
+  free(job);
+
+  CHECK(napi_call_function(env, global, callback, 1, argv, NULL) == napi_ok);
+}
+
+static napi_value
+goosig_challenge_batch(napi_env env, napi_callback_info info) {
+  napi_value argv[8];
+  size_t argc = 8;
+  uint8_t *out, *s_primes;
+  const uint8_t *seed, *n;
+  size_t out_len, s_primes_len, seed_len, n_len;
+  size_t total = 0;
+  uint32_t offset, threads, len, i;
+  goosig_batch_job_t *job;
+  napi_valuetype type;
+  napi_value item, name;
+  goosig_t *goo;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 8);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&out,
+                             &out_len) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[4], &offset) == napi_ok);
+  CHECK(napi_get_array_length(env, argv[5], &len) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[6], &threads) == napi_ok);
+
+  JS_ASSERT(out_len == (size_t)len * goo_size(goo->ctx), JS_ERR_OUTPUT_SIZE);
+
+  s_primes = NULL;
+  s_primes_len = 0;
+
+  CHECK(napi_typeof(env, argv[2], &type) == napi_ok);
+
+  if (type != napi_null && type != napi_undefined) {
+    CHECK(napi_get_buffer_info(env, argv[2], (void **)&s_primes,
+                               &s_primes_len) == napi_ok);
+    JS_ASSERT(s_primes_len == (size_t)len * 32, JS_ERR_SPRIMES_SIZE);
+  }
+
+  seed = NULL;
+  seed_len = 0;
+
+  CHECK(napi_typeof(env, argv[3], &type) == napi_ok);
+
+  if (type != napi_null && type != napi_undefined) {
+    CHECK(napi_get_buffer_info(env, argv[3], (void **)&seed,
+                               &seed_len) == napi_ok);
+    JS_ASSERT(seed_len == 32, JS_ERR_SEED_SIZE);
+  }
+
+  JS_ASSERT(seed != NULL || s_primes != NULL, JS_ERR_SPRIMES_SIZE);
+
+  job = (goosig_batch_job_t *)calloc(1, sizeof(goosig_batch_job_t));
+
+  CHECK(job != NULL);
+
+  job->goo = goo;
+  job->out = out;
+  job->s_primes = s_primes;
+  job->has_seed = seed != NULL;
+  job->offset = offset;
+  job->len = len;
+  job->threads = threads;
+  job->ns = (const uint8_t **)malloc((len + 1) * sizeof(uint8_t *));
+  job->n_lens = (size_t *)malloc((len + 1) * sizeof(size_t));
+
+  CHECK(job->ns != NULL);
+  CHECK(job->n_lens != NULL);
+
+  if (seed != NULL)
+    memcpy(job->seed, seed, 32);
+
+  /* Copy the moduli into one allocation: the */
+  /* array may be modified while we run. */
+  for (i = 0; i < len; i++) {
+    CHECK(napi_get_element(env, argv[5], i, &item) == napi_ok);
+    CHECK(napi_get_buffer_info(env, item, (void **)&n, &n_len) == napi_ok);
+    job->n_lens[i] = n_len;
+    total += n_len;
+  }
+
+  job->data = (uint8_t *)malloc(total + 1);
+
+  CHECK(job->data != NULL);
+
+  total = 0;
+
+  for (i = 0; i < len; i++) {
+    CHECK(napi_get_element(env, argv[5], i, &item) == napi_ok);
+    CHECK(napi_get_buffer_info(env, item, (void **)&n, &n_len) == napi_ok);
+    CHECK(n_len == job->n_lens[i]);
+    memcpy(job->data + total, n, n_len);
+    job->ns[i] = job->data + total;
+    total += n_len;
+  }
+
+  /* Keep the context and output buffers alive until we complete. */
+  CHECK(napi_create_reference(env, argv[0], 1, &job->ref) == napi_ok);
+  CHECK(napi_create_reference(env, argv[1], 1, &job->out_ref) == napi_ok);
+  CHECK(napi_create_reference(env, argv[7], 1, &job->callback) == napi_ok);
+
+  if (s_primes != NULL) {
+    CHECK(napi_create_reference(env, argv[2], 1,
+                                &job->s_primes_ref) == napi_ok);
+  }
+
+  CHECK(napi_create_string_latin1(env, "goosig_challenge_batch",
+                                  NAPI_AUTO_LENGTH, &name) == napi_ok);
+
+  CHECK(napi_create_async_work(env,
+                               NULL,
+                               name,
+                               goosig_batch_execute,
+                               goosig_batch_complete,
+                               job,
+                               &job->work) == napi_ok);
+
+  CHECK(napi_queue_async_work(env, job->work) == napi_ok);
+
+  return NULL;
+}
+
+static napi_value
+goosig_derive_sprime(napi_env env, napi_callback_info info) {
+  napi_value argv[2];
+  size_t argc = 2;
+  uint8_t out[32];
+  const uint8_t *seed;
+  size_t seed_len;
+  uint32_t index;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 2);
+  CHECK(napi_get_buffer_info(env, argv[0], (void **)&seed,
+                             &seed_len) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[1], &index) == napi_ok);
+
+  JS_ASSERT(seed_len == 32, JS_ERR_SEED_SIZE);
+  JS_ASSERT(goo_derive_sprime(NULL, out, seed, index), JS_ERR_GENERATE);
+
+  CHECK(napi_create_buffer_copy(env, 32, out, NULL, &result) == napi_ok);
+
+  return result;
+}
+
+static napi_value
+goosig_validate(napi_env env, napi_callback_info info) {
+  napi_value argv[5];
+  size_t argc = 5;
+  const uint8_t *s_prime, *C1, *p, *q;
+  size_t s_prime_len, C1_len, p_len, q_len;
+  goosig_t *goo;
+  napi_value result;
+  uint64_t start;
+  int ok;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 5);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&s_prime,
+                             &s_prime_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&C1, &C1_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&p, &p_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[4], (void **)&q, &q_len) == napi_ok);
 
   JS_ASSERT(s_prime_len == 32, JS_ERR_SPRIME_SIZE);
 
-  ok = goo_validate(goo, s_prime, C1, C1_len, p, p_len, q, q_len);
+  start = uv_hrtime();
+  ok = goo_validate(goo->ctx, s_prime, C1, C1_len, p, p_len, q, q_len);
+  goosig_record(goo, GOOSIG_OP_VALIDATE, start);
 
   CHECK(napi_get_boolean(env, ok, &result) == napi_ok);
 
@@ -166,11 +1032,11 @@ goosig_sign(napi_env env, napi_callback_info info) {
   napi_value argv[5];
   size_t argc = 5;
   uint8_t *out;
-  size_t out_len;
   const uint8_t *msg, *s_prime, *p, *q;
   size_t msg_len, s_prime_len, p_len, q_len;
-  goo_ctx_t *goo;
+  goosig_t *goo;
   napi_value result;
+  uint64_t start;
   int ok;
 
   CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
@@ -184,13 +1050,290 @@ goosig_sign(napi_env env, napi_callback_info info) {
 
   JS_ASSERT(s_prime_len == 32, JS_ERR_SPRIME_SIZE);
 
-  ok = goo_sign(goo, &out, &out_len, msg, msg_len, s_prime, p, p_len, q, q_len);
+  CHECK(napi_create_buffer(env, goo_signature_size(goo->ctx), (void **)&out,
+                           &result) == napi_ok);
+
+  start = uv_hrtime();
+  ok = goo_sign_into(goo->ctx, out, msg, msg_len,
+                     s_prime, p, p_len, q, q_len);
+  goosig_record(goo, GOOSIG_OP_SIGN, start);
 
   JS_ASSERT(ok, JS_ERR_SIGN);
 
-  CHECK(napi_create_buffer_copy(env, out_len, out, NULL, &result) == napi_ok);
+  return result;
+}
 
-  free(out);
+static void
+goosig_signer_destroy(napi_env env, void *data, void *hint) {
+  goo_signer_destroy((goo_signer_t *)data);
+}
+
+static napi_value
+goosig_signer_create(napi_env env, napi_callback_info info) {
+  napi_value argv[4];
+  size_t argc = 4;
+  const uint8_t *s_prime, *p, *q;
+  size_t s_prime_len, p_len, q_len;
+  goo_signer_t *signer;
+  goosig_t *goo;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 4);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&s_prime,
+                             &s_prime_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&p, &p_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&q, &q_len) == napi_ok);
+
+  JS_ASSERT(s_prime_len == 32, JS_ERR_SPRIME_SIZE);
+
+  signer = goo_signer_create(goo->ctx, s_prime, p, p_len, q, q_len);
+
+  JS_ASSERT(signer != NULL, JS_ERR_SIGNER);
+
+  CHECK(napi_create_external(env,
+                             signer,
+                             goosig_signer_destroy,
+                             NULL,
+                             &result) == napi_ok);
+
+  return result;
+}
+
+static napi_value
+goosig_signer_sign(napi_env env, napi_callback_info info) {
+  napi_value argv[3];
+  size_t argc = 3;
+  uint8_t *out;
+  const uint8_t *msg;
+  size_t msg_len;
+  goo_signer_t *signer;
+  goosig_t *goo;
+  napi_value result;
+  uint64_t start;
+  int ok;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 3);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
+  CHECK(napi_get_value_external(env, argv[1], (void **)&signer) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&msg, &msg_len) == napi_ok);
+
+  CHECK(napi_create_buffer(env, goo_signature_size(goo->ctx), (void **)&out,
+                           &result) == napi_ok);
+
+  start = uv_hrtime();
+  ok = goo_signer_sign_into(goo->ctx, out, signer, msg, msg_len);
+  goosig_record(goo, GOOSIG_OP_SIGN, start);
+
+  JS_ASSERT(ok, JS_ERR_SIGN);
+
+  return result;
+}
+
+static void
+goosig_presig_destroy(napi_env env, void *data, void *hint) {
+  goo_presig_destroy((goo_presig_t *)data);
+}
+
+static napi_value
+goosig_presign(napi_env env, napi_callback_info info) {
+  napi_value argv[5];
+  size_t argc = 5;
+  const uint8_t *s_prime, *p, *q, *entropy;
+  size_t s_prime_len, p_len, q_len, entropy_len;
+  goo_presig_t *presig;
+  goosig_t *goo;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 5);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&s_prime,
+                             &s_prime_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&p, &p_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&q, &q_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[4], (void **)&entropy,
+                             &entropy_len) == napi_ok);
+
+  JS_ASSERT(s_prime_len == 32, JS_ERR_SPRIME_SIZE);
+  JS_ASSERT(entropy_len == 32, JS_ERR_ENTROPY_SIZE);
+
+  JS_ASSERT(goo_presign(goo->ctx, &presig, s_prime,
+                        p, p_len, q, q_len, entropy), JS_ERR_PRESIGN);
+
+  CHECK(napi_create_external(env,
+                             presig,
+                             goosig_presig_destroy,
+                             NULL,
+                             &result) == napi_ok);
+
+  return result;
+}
+
+typedef struct goosig_presign_job_s {
+  goosig_t *goo;
+  napi_ref ref;
+  napi_ref callback;
+  napi_async_work work;
+  uint8_t s_prime[32];
+  uint8_t entropy[32];
+  uint8_t *p;
+  size_t p_len;
+  uint8_t *q;
+  size_t q_len;
+  goo_presig_t *presig;
+  int ok;
+} goosig_presign_job_t;
+
+static void
+goosig_presign_execute(napi_env env, void *data) {
+  goosig_presign_job_t *job = (goosig_presign_job_t *)data;
+  goo_ctx_t *ctx = goo_clone(job->goo->ctx);
+
+  /* Run on a clone: the context's scratch space may be */
+  /* in use on the main thread, but its combs are not */
+  /* written after creation. */
+  job->ok = goo_presign(ctx, &job->presig, job->s_prime,
+                        job->p, job->p_len, job->q, job->q_len,
+                        job->entropy);
+
+  goo_destroy(ctx);
+}
+
+static void
+goosig_presign_complete(napi_env env, napi_status status, void *data) {
+  goosig_presign_job_t *job = (goosig_presign_job_t *)data;
+  napi_value argv[2];
+  napi_value callback, global, msg;
+
+  if (status != napi_ok)
+    job->ok = 0;
+
+  if (job->ok) {
+    CHECK(napi_get_null(env, &argv[0]) == napi_ok);
+    CHECK(napi_create_external(env,
+                               job->presig,
+                               goosig_presig_destroy,
+                               NULL,
+                               &argv[1]) == napi_ok);
+  } else {
+    CHECK(napi_create_string_utf8(env, JS_ERR_PRESIGN,
+                                  NAPI_AUTO_LENGTH, &msg) == napi_ok);
+    CHECK(napi_create_error(env, NULL, msg, &argv[0]) == napi_ok);
+    CHECK(napi_get_undefined(env, &argv[1]) == napi_ok);
+  }
+
+  CHECK(napi_get_reference_value(env, job->callback, &callback) == napi_ok);
+  CHECK(napi_get_global(env, &global) == napi_ok);
+
+  CHECK(napi_delete_async_work(env, job->work) == napi_ok);
+  CHECK(napi_delete_reference(env, job->callback) == napi_ok);
+  CHECK(napi_delete_reference(env, job->ref) == napi_ok);
+
+  goosig_cleanse(job->s_prime, sizeof(job->s_prime));
+  goosig_cleanse(job->entropy, sizeof(job->entropy));
+  goosig_cleanse(job->p, job->p_len);
+  goosig_cleanse(job->q, job->q_len);
+
+  free(job->p);
+  free(job->q);
+  free(job);
+
+  CHECK(napi_call_function(env, global, callback, 2, argv, NULL) == napi_ok);
+}
+
+static napi_value
+goosig_presign_async(napi_env env, napi_callback_info info) {
+  napi_value argv[6];
+  size_t argc = 6;
+  const uint8_t *s_prime, *p, *q, *entropy;
+  size_t s_prime_len, p_len, q_len, entropy_len;
+  goosig_presign_job_t *job;
+  goosig_t *goo;
+  napi_value name;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 6);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&s_prime,
+                             &s_prime_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&p, &p_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&q, &q_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[4], (void **)&entropy,
+                             &entropy_len) == napi_ok);
+
+  JS_ASSERT(s_prime_len == 32, JS_ERR_SPRIME_SIZE);
+  JS_ASSERT(entropy_len == 32, JS_ERR_ENTROPY_SIZE);
+
+  job = (goosig_presign_job_t *)malloc(sizeof(goosig_presign_job_t));
+
+  CHECK(job != NULL);
+
+  job->goo = goo;
+  job->p = (uint8_t *)malloc(p_len + 1);
+  job->p_len = p_len;
+  job->q = (uint8_t *)malloc(q_len + 1);
+  job->q_len = q_len;
+  job->presig = NULL;
+  job->ok = 0;
+
+  CHECK(job->p != NULL);
+  CHECK(job->q != NULL);
+
+  memcpy(job->s_prime, s_prime, 32);
+  memcpy(job->entropy, entropy, 32);
+  memcpy(job->p, p, p_len);
+  memcpy(job->q, q, q_len);
+
+  /* Keep the context alive until we complete. */
+  CHECK(napi_create_reference(env, argv[0], 1, &job->ref) == napi_ok);
+  CHECK(napi_create_reference(env, argv[5], 1, &job->callback) == napi_ok);
+
+  CHECK(napi_create_string_latin1(env, "goosig_presign",
+                                  NAPI_AUTO_LENGTH, &name) == napi_ok);
+
+  CHECK(napi_create_async_work(env,
+                               NULL,
+                               name,
+                               goosig_presign_execute,
+                               goosig_presign_complete,
+                               job,
+                               &job->work) == napi_ok);
+
+  CHECK(napi_queue_async_work(env, job->work) == napi_ok);
+
+  return NULL;
+}
+
+static napi_value
+goosig_sign_with_presig(napi_env env, napi_callback_info info) {
+  napi_value argv[3];
+  size_t argc = 3;
+  uint8_t *out;
+  const uint8_t *msg;
+  size_t msg_len;
+  goo_presig_t *presig;
+  goosig_t *goo;
+  napi_value result;
+  uint64_t start;
+  int ok;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 3);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&goo) == napi_ok);
+  CHECK(napi_get_value_external(env, argv[1], (void **)&presig) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&msg, &msg_len) == napi_ok);
+
+  CHECK(napi_create_buffer(env, goo_signature_size(goo->ctx), (void **)&out,
+                           &result) == napi_ok);
+
+  start = uv_hrtime();
+  ok = goo_sign_with_presig_into(goo->ctx, out, presig, msg, msg_len);
+  goosig_record(goo, GOOSIG_OP_SIGN, start);
+
+  JS_ASSERT(ok, JS_ERR_SIGN);
 
   return result;
 }
@@ -201,8 +1344,9 @@ goosig_verify(napi_env env, napi_callback_info info) {
   size_t argc = 4;
   const uint8_t *msg, *sig, *C1;
   size_t msg_len, sig_len, C1_len;
-  goo_ctx_t *goo;
+  goosig_t *goo;
   napi_value result;
+  uint64_t start;
   int ok;
 
   CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
@@ -213,7 +1357,9 @@ goosig_verify(napi_env env, napi_callback_info info) {
   CHECK(napi_get_buffer_info(env, argv[2], (void **)&sig, &sig_len) == napi_ok);
   CHECK(napi_get_buffer_info(env, argv[3], (void **)&C1, &C1_len) == napi_ok);
 
-  ok = goo_verify(goo, msg, msg_len, sig, sig_len, C1, C1_len);
+  start = uv_hrtime();
+  ok = goo_verify(goo->ctx, msg, msg_len, sig, sig_len, C1, C1_len);
+  goosig_record(goo, GOOSIG_OP_VERIFY, start);
 
   CHECK(napi_get_boolean(env, ok, &result) == napi_ok);
 
@@ -221,24 +1367,1384 @@ goosig_verify(napi_env env, napi_callback_info info) {
 }
 
 /*
- * Module
+ * Verification Pool
  */
 
-napi_value
-goosig_init(napi_env env, napi_value exports) {
-  size_t i;
+/* A dedicated set of verifier threads, kept off the libuv threadpool so
+ * verification does not compete with fs and dns work. Jobs go through a
+ * bounded lock-free MPMC queue (Vyukov's sequenced ring). Each worker
+ * coalesces up to `batch` queued jobs, runs them on its own clone of the
+ * group and completes the whole batch back to the loop thread with a
+ * single JS call. */
 
-  static struct {
-    const char *name;
-    napi_callback callback;
-  } funcs[] = {
-    { "goosig_create", goosig_create },
-    { "goosig_generate", goosig_generate },
-    { "goosig_challenge", goosig_challenge },
-    { "goosig_validate", goosig_validate },
-    { "goosig_sign", goosig_sign },
-    { "goosig_verify", goosig_verify }
-  };
+#define GOOSIG_POOL_BATCH 64
+
+typedef struct goosig_pool_job_s {
+  uint32_t id;
+  goosig_t *goo;
+  napi_ref ref;
+  uint8_t *data;
+  size_t msg_len;
+  size_t sig_len;
+  size_t C1_len;
+  int ok;
+} goosig_pool_job_t;
+
+typedef struct goosig_pool_batch_s {
+  struct goosig_pool_batch_s *next;
+  size_t len;
+  goosig_pool_job_t *jobs[GOOSIG_POOL_BATCH];
+} goosig_pool_batch_t;
+
+typedef struct goosig_pool_cell_s {
+  volatile uint64_t seq;
+  goosig_pool_job_t *job;
+} goosig_pool_cell_t;
+
+typedef struct goosig_pool_s goosig_pool_t;
+
+typedef struct goosig_pool_worker_s {
+  goosig_pool_t *pool;
+  uv_thread_t thread;
+  int cpu;
+} goosig_pool_worker_t;
+
+struct goosig_pool_s {
+  goosig_pool_cell_t *cells;
+  uint64_t mask;
+  volatile uint64_t head;
+  volatile uint64_t tail;
+  volatile uint64_t stop;
+  uv_sem_t sem;
+  size_t batch;
+  goosig_pool_worker_t *workers;
+  uint32_t threads;
+  uv_mutex_t lock;
+  goosig_pool_batch_t *done;
+  uv_async_t async;
+  napi_env env;
+  napi_ref callback;
+  napi_async_context context;
+  size_t pending;
+  int closed;
+  int finalized;
+};
+
+static int
+goosig_pool_push(goosig_pool_t *pool, goosig_pool_job_t *job) {
+  uint64_t pos = goosig_atomic_load(&pool->tail);
+  goosig_pool_cell_t *cell;
+
+  for (;;) {
+    int64_t dif;
+
+    cell = &pool->cells[pos & pool->mask];
+    dif = (int64_t)(goosig_atomic_acquire(&cell->seq) - pos);
+
+    if (dif == 0) {
+      if (goosig_atomic_cas(&pool->tail, pos, pos + 1))
+        break;
+      pos = goosig_atomic_load(&pool->tail);
+    } else if (dif < 0) {
+      return 0; /* Full. */
+    } else {
+      pos = goosig_atomic_load(&pool->tail);
+    }
+  }
+
+  cell->job = job;
+
+  goosig_atomic_release(&cell->seq, pos + 1);
+
+  return 1;
+}
+
+static goosig_pool_job_t *
+goosig_pool_pop(goosig_pool_t *pool) {
+  uint64_t pos = goosig_atomic_load(&pool->head);
+  goosig_pool_cell_t *cell;
+  goosig_pool_job_t *job;
+
+  for (;;) {
+    int64_t dif;
+
+    cell = &pool->cells[pos & pool->mask];
+    dif = (int64_t)(goosig_atomic_acquire(&cell->seq) - (pos + 1));
+
+    if (dif == 0) {
+      if (goosig_atomic_cas(&pool->head, pos, pos + 1))
+        break;
+      pos = goosig_atomic_load(&pool->head);
+    } else if (dif < 0) {
+      return NULL; /* Empty. */
+    } else {
+      pos = goosig_atomic_load(&pool->head);
+    }
+  }
+
+  job = cell->job;
+
+  goosig_atomic_release(&cell->seq, pos + pool->mask + 1);
+
+  return job;
+}
+
+static void
+goosig_pool_pin(int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+
+  if (cpu < 0 || cpu >= CPU_SETSIZE)
+    return;
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  /* Best effort: the cpu may be offline or outside our cgroup. */
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)cpu;
+#endif
+}
+
+static void
+goosig_pool_run(void *data) {
+  goosig_pool_worker_t *worker = (goosig_pool_worker_t *)data;
+  goosig_pool_t *pool = worker->pool;
+  goosig_group_t *group = NULL;
+  goo_ctx_t *ctx = NULL;
+
+  goosig_pool_pin(worker->cpu);
+
+  for (;;) {
+    goosig_pool_batch_t *batch;
+    size_t i, j, k;
+
+    goosig_pool_job_t *job;
+
+    uv_sem_wait(&pool->sem);
+
+    if (goosig_atomic_load(&pool->stop))
+      break;
+
+    /* The semaphore is only posted after a push is published, */
+    /* so a token is either a queued job or a stop request. */
+    job = goosig_pool_pop(pool);
+
+    if (job == NULL)
+      break;
+
+    batch = (goosig_pool_batch_t *)malloc(sizeof(goosig_pool_batch_t));
+
+    CHECK(batch != NULL);
+
+    batch->next = NULL;
+    batch->jobs[0] = job;
+    batch->len = 1;
+
+    /* Coalesce whatever else is already queued. */
+    while (batch->len < pool->batch && uv_sem_trywait(&pool->sem) == 0) {
+      job = goosig_pool_pop(pool);
+
+      if (job == NULL) {
+        /* Hand the stop request to its owner. */
+        uv_sem_post(&pool->sem);
+        break;
+      }
+
+      batch->jobs[batch->len++] = job;
+    }
+
+    /* Verify each run of jobs from the same group as one batch. */
+    for (i = 0; i < batch->len; i = j) {
+      const unsigned char *msgs[GOOSIG_POOL_BATCH];
+      const unsigned char *sigs[GOOSIG_POOL_BATCH];
+      const unsigned char *C1s[GOOSIG_POOL_BATCH];
+      size_t msg_lens[GOOSIG_POOL_BATCH];
+      size_t sig_lens[GOOSIG_POOL_BATCH];
+      size_t C1_lens[GOOSIG_POOL_BATCH];
+      int oks[GOOSIG_POOL_BATCH];
+      uint64_t start, share;
+
+      job = batch->jobs[i];
+
+      /* Keep a clone of the last group we saw. */
+      if (job->goo->group != group) {
+        goo_destroy(ctx);
+
+        if (group != NULL)
+          goosig_registry_release(group);
+
+        group = job->goo->group;
+
+        goosig_registry_retain(group);
+
+        ctx = goo_clone(group->ctx);
+
+        CHECK(ctx != NULL);
+      }
+
+      for (j = i; j < batch->len; j++) {
+        job = batch->jobs[j];
+
+        if (job->goo->group != group)
+          break;
+
+        msgs[j - i] = job->data;
+        msg_lens[j - i] = job->msg_len;
+        sigs[j - i] = msgs[j - i] + job->msg_len;
+        sig_lens[j - i] = job->sig_len;
+        C1s[j - i] = sigs[j - i] + job->sig_len;
+        C1_lens[j - i] = job->C1_len;
+      }
+
+      start = uv_hrtime();
+
+      goo_verify_batch(ctx, oks, msgs, msg_lens, sigs, sig_lens,
+                       C1s, C1_lens, j - i);
+
+      /* Each job is charged an equal share of the batch. */
+      share = (uv_hrtime() - start) / (j - i);
+
+      for (k = i; k < j; k++) {
+        batch->jobs[k]->ok = oks[k - i];
+        goosig_record(batch->jobs[k]->goo, GOOSIG_OP_VERIFY,
+                      uv_hrtime() - share);
+      }
+    }
+
+    uv_mutex_lock(&pool->lock);
+    batch->next = pool->done;
+    pool->done = batch;
+    uv_mutex_unlock(&pool->lock);
+
+    uv_async_send(&pool->async);
+  }
+
+  goo_destroy(ctx);
+
+  if (group != NULL)
+    goosig_registry_release(group);
+}
+
+static void
+goosig_pool_job_free(napi_env env, goosig_pool_job_t *job) {
+  CHECK(napi_delete_reference(env, job->ref) == napi_ok);
+  free(job->data);
+  free(job);
+}
+
+static goosig_pool_batch_t *
+goosig_pool_collect(goosig_pool_t *pool) {
+  goosig_pool_batch_t *list, *batch, *next;
+  goosig_pool_batch_t *head = NULL;
+
+  uv_mutex_lock(&pool->lock);
+  list = pool->done;
+  pool->done = NULL;
+  uv_mutex_unlock(&pool->lock);
+
+  /* Reverse into completion order. */
+  for (batch = list; batch != NULL; batch = next) {
+    next = batch->next;
+    batch->next = head;
+    head = batch;
+  }
+
+  return head;
+}
+
+static void
+goosig_pool_settle(goosig_pool_t *pool, size_t len) {
+  CHECK(pool->pending >= len);
+
+  pool->pending -= len;
+
+  /* Only hold the loop open while work is outstanding. */
+  if (pool->pending == 0)
+    uv_unref((uv_handle_t *)&pool->async);
+}
+
+static void
+goosig_pool_complete(uv_async_t *handle) {
+  goosig_pool_t *pool = (goosig_pool_t *)handle->data;
+  napi_env env = pool->env;
+  goosig_pool_batch_t *batch, *next;
+  napi_handle_scope scope;
+  napi_value callback, global;
+
+  if (pool->closed)
+    return;
+
+  CHECK(napi_open_handle_scope(env, &scope) == napi_ok);
+  CHECK(napi_get_reference_value(env, pool->callback,
+                                 &callback) == napi_ok);
+  CHECK(napi_get_global(env, &global) == napi_ok);
+
+  for (batch = goosig_pool_collect(pool); batch != NULL; batch = next) {
+    napi_value argv[2];
+    size_t i;
+
+    next = batch->next;
+
+    CHECK(napi_create_array_with_length(env, batch->len,
+                                        &argv[0]) == napi_ok);
+    CHECK(napi_create_array_with_length(env, batch->len,
+                                        &argv[1]) == napi_ok);
+
+    for (i = 0; i < batch->len; i++) {
+      goosig_pool_job_t *job = batch->jobs[i];
+      napi_value id, ok;
+
+      CHECK(napi_create_uint32(env, job->id, &id) == napi_ok);
+      CHECK(napi_get_boolean(env, job->ok, &ok) == napi_ok);
+      CHECK(napi_set_element(env, argv[0], i, id) == napi_ok);
+      CHECK(napi_set_element(env, argv[1], i, ok) == napi_ok);
+
+      goosig_pool_job_free(env, job);
+    }
+
+    goosig_pool_settle(pool, batch->len);
+
+    CHECK(napi_make_callback(env, pool->context, global, callback,
+                             2, argv, NULL) == napi_ok);
+
+    free(batch);
+
+    /* The callback may have closed us. */
+    if (pool->closed) {
+      for (batch = next; batch != NULL; batch = next) {
+        next = batch->next;
+
+        for (i = 0; i < batch->len; i++)
+          goosig_pool_job_free(env, batch->jobs[i]);
+
+        free(batch);
+      }
+      break;
+    }
+  }
+
+  CHECK(napi_close_handle_scope(env, scope) == napi_ok);
+}
+
+static void
+goosig_pool_free(goosig_pool_t *pool) {
+  uv_sem_destroy(&pool->sem);
+  uv_mutex_destroy(&pool->lock);
+  free(pool->workers);
+  free(pool->cells);
+  free(pool);
+}
+
+static void
+goosig_pool_on_close(uv_handle_t *handle) {
+  goosig_pool_t *pool = (goosig_pool_t *)handle->data;
+
+  /* Whoever finishes last (the handle or the finalizer) frees. */
+  if (pool->finalized)
+    goosig_pool_free(pool);
+  else
+    pool->finalized = -1;
+}
+
+static void
+goosig_pool_shutdown(napi_env env, goosig_pool_t *pool) {
+  goosig_pool_batch_t *batch, *next;
+  goosig_pool_job_t *job;
+  uint32_t i;
+  size_t j;
+
+  if (pool->closed)
+    return;
+
+  pool->closed = 1;
+
+  goosig_atomic_store(&pool->stop, 1);
+
+  for (i = 0; i < pool->threads; i++)
+    uv_sem_post(&pool->sem);
+
+  for (i = 0; i < pool->threads; i++)
+    CHECK(uv_thread_join(&pool->workers[i].thread) == 0);
+
+  /* Jobs which never ran or never completed are dropped. */
+  while ((job = goosig_pool_pop(pool)) != NULL)
+    goosig_pool_job_free(env, job);
+
+  for (batch = goosig_pool_collect(pool); batch != NULL; batch = next) {
+    next = batch->next;
+
+    for (j = 0; j < batch->len; j++)
+      goosig_pool_job_free(env, batch->jobs[j]);
+
+    free(batch);
+  }
+
+  pool->pending = 0;
+
+  CHECK(napi_delete_reference(env, pool->callback) == napi_ok);
+  CHECK(napi_async_destroy(env, pool->context) == napi_ok);
+
+  uv_close((uv_handle_t *)&pool->async, goosig_pool_on_close);
+}
+
+static void
+goosig_pool_destroy(napi_env env, void *data, void *hint) {
+  goosig_pool_t *pool = (goosig_pool_t *)data;
+
+  goosig_pool_shutdown(env, pool);
+
+  if (pool->finalized == -1)
+    goosig_pool_free(pool);
+  else
+    pool->finalized = 1;
+}
+
+static napi_value
+goosig_pool_create(napi_env env, napi_callback_info info) {
+  napi_value argv[5];
+  size_t argc = 5;
+  uint32_t threads, capacity, batch, ncpus, i;
+  napi_valuetype type;
+  goosig_pool_t *pool;
+  uv_loop_t *loop;
+  napi_value handle, name;
+  bool is_array = false;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 5);
+  CHECK(napi_get_value_uint32(env, argv[0], &threads) == napi_ok);
+  CHECK(napi_typeof(env, argv[1], &type) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[2], &capacity) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[3], &batch) == napi_ok);
+
+  JS_ASSERT(threads > 0 && threads <= 256, JS_ERR_POOL);
+  JS_ASSERT(capacity >= 2 && (capacity & (capacity - 1)) == 0, JS_ERR_POOL);
+  JS_ASSERT(batch > 0 && batch <= GOOSIG_POOL_BATCH, JS_ERR_POOL);
+
+  if (type != napi_null && type != napi_undefined)
+    CHECK(napi_is_array(env, argv[1], &is_array) == napi_ok);
+
+  ncpus = 0;
+
+  if (is_array)
+    CHECK(napi_get_array_length(env, argv[1], &ncpus) == napi_ok);
+
+  CHECK(napi_get_uv_event_loop(env, &loop) == napi_ok);
+
+  pool = (goosig_pool_t *)calloc(1, sizeof(goosig_pool_t));
+
+  CHECK(pool != NULL);
+
+  pool->cells = (goosig_pool_cell_t *)calloc(capacity,
+                                             sizeof(goosig_pool_cell_t));
+  pool->workers = (goosig_pool_worker_t *)calloc(threads,
+                                                 sizeof(goosig_pool_worker_t));
+
+  CHECK(pool->cells != NULL);
+  CHECK(pool->workers != NULL);
+
+  for (i = 0; i < capacity; i++)
+    pool->cells[i].seq = i;
+
+  pool->mask = capacity - 1;
+  pool->batch = batch;
+  pool->threads = threads;
+  pool->env = env;
+
+  CHECK(uv_sem_init(&pool->sem, 0) == 0);
+  CHECK(uv_mutex_init(&pool->lock) == 0);
+  CHECK(uv_async_init(loop, &pool->async, goosig_pool_complete) == 0);
+
+  pool->async.data = pool;
+
+  uv_unref((uv_handle_t *)&pool->async);
+
+  CHECK(napi_create_reference(env, argv[4], 1, &pool->callback) == napi_ok);
+  CHECK(napi_create_string_latin1(env, "goosig_pool",
+                                  NAPI_AUTO_LENGTH, &name) == napi_ok);
+  CHECK(napi_async_init(env, NULL, name, &pool->context) == napi_ok);
+
+  for (i = 0; i < threads; i++) {
+    goosig_pool_worker_t *worker = &pool->workers[i];
+
+    worker->pool = pool;
+    worker->cpu = -1;
+
+    if (ncpus > 0) {
+      napi_value item;
+      int32_t cpu;
+
+      CHECK(napi_get_element(env, argv[1], i % ncpus, &item) == napi_ok);
+      CHECK(napi_get_value_int32(env, item, &cpu) == napi_ok);
+
+      worker->cpu = cpu;
+    }
+
+    CHECK(uv_thread_create(&worker->thread, goosig_pool_run, worker) == 0);
+  }
+
+  CHECK(napi_create_external(env,
+                             pool,
+                             goosig_pool_destroy,
+                             NULL,
+                             &handle) == napi_ok);
+
+  return handle;
+}
+
+static napi_value
+goosig_pool_verify(napi_env env, napi_callback_info info) {
+  napi_value argv[6];
+  size_t argc = 6;
+  const uint8_t *msg, *sig, *C1;
+  size_t msg_len, sig_len, C1_len;
+  goosig_pool_job_t *job;
+  goosig_pool_t *pool;
+  goosig_t *goo;
+  uint32_t id;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 6);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&pool) == napi_ok);
+  CHECK(napi_get_value_external(env, argv[1], (void **)&goo) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[2], &id) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&msg,
+                             &msg_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[4], (void **)&sig, &sig_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[5], (void **)&C1, &C1_len) == napi_ok);
+
+  JS_ASSERT(!pool->closed, JS_ERR_POOL_CLOSED);
+
+  job = (goosig_pool_job_t *)malloc(sizeof(goosig_pool_job_t));
+
+  CHECK(job != NULL);
+
+  job->id = id;
+  job->goo = goo;
+  job->data = (uint8_t *)malloc(msg_len + sig_len + C1_len + 1);
+  job->msg_len = msg_len;
+  job->sig_len = sig_len;
+  job->C1_len = C1_len;
+  job->ok = 0;
+
+  CHECK(job->data != NULL);
+
+  memcpy(job->data, msg, msg_len);
+  memcpy(job->data + msg_len, sig, sig_len);
+  memcpy(job->data + msg_len + sig_len, C1, C1_len);
+
+  /* Keep the context alive until we complete. */
+  CHECK(napi_create_reference(env, argv[1], 1, &job->ref) == napi_ok);
+
+  if (!goosig_pool_push(pool, job)) {
+    /* Full: the caller queues and retries. */
+    goosig_pool_job_free(env, job);
+    CHECK(napi_get_boolean(env, false, &result) == napi_ok);
+    return result;
+  }
+
+  if (pool->pending++ == 0)
+    uv_ref((uv_handle_t *)&pool->async);
+
+  uv_sem_post(&pool->sem);
+
+  CHECK(napi_get_boolean(env, true, &result) == napi_ok);
+
+  return result;
+}
+
+static napi_value
+goosig_pool_close(napi_env env, napi_callback_info info) {
+  napi_value argv[1];
+  size_t argc = 1;
+  goosig_pool_t *pool;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 1);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&pool) == napi_ok);
+
+  goosig_pool_shutdown(env, pool);
+
+  return NULL;
+}
+
+static goosig_hist_t *
+goosig_get_hist(napi_env env, napi_value handle, uint32_t op) {
+  napi_valuetype type;
+  goosig_t *goo;
+
+  if (op >= GOOSIG_OP_MAX)
+    return NULL;
+
+  CHECK(napi_typeof(env, handle, &type) == napi_ok);
+
+  /* A null handle selects the process-wide histograms. */
+  if (type == napi_null || type == napi_undefined)
+    return &goosig_hists[op];
+
+  CHECK(napi_get_value_external(env, handle, (void **)&goo) == napi_ok);
+
+  return &goo->hists[op];
+}
+
+static napi_value
+goosig_encrypt(napi_env env, napi_callback_info info) {
+  napi_value argv[4];
+  size_t argc = 4;
+  uint8_t *out;
+  size_t out_len;
+  const uint8_t *msg, *n, *e, *entropy;
+  size_t msg_len, n_len, e_len, entropy_len;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 4);
+  CHECK(napi_get_buffer_info(env, argv[0], (void **)&msg, &msg_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&n, &n_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&e, &e_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&entropy,
+                             &entropy_len) == napi_ok);
+
+  JS_ASSERT(entropy_len == 32, JS_ERR_ENTROPY_SIZE);
+
+  JS_ASSERT(goo_encrypt(NULL, &out, &out_len, msg, msg_len,
+                        n, n_len, e, e_len, NULL, 0, entropy),
+            JS_ERR_ENCRYPT);
+
+  CHECK(napi_create_buffer_copy(env, out_len, out, NULL, &result) == napi_ok);
+
+  free(out);
+
+  return result;
+}
+
+static napi_value
+goosig_decrypt(napi_env env, napi_callback_info info) {
+  napi_value argv[5];
+  size_t argc = 5;
+  uint8_t *out;
+  size_t out_len;
+  const uint8_t *ct, *p, *q, *e, *entropy;
+  size_t ct_len, p_len, q_len, e_len, entropy_len;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 5);
+  CHECK(napi_get_buffer_info(env, argv[0], (void **)&ct, &ct_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&p, &p_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&q, &q_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&e, &e_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[4], (void **)&entropy,
+                             &entropy_len) == napi_ok);
+
+  JS_ASSERT(entropy_len == 32, JS_ERR_ENTROPY_SIZE);
+
+  JS_ASSERT(goo_decrypt(NULL, &out, &out_len, ct, ct_len,
+                        p, p_len, q, q_len, e, e_len,
+                        NULL, 0, entropy),
+            JS_ERR_DECRYPT);
+
+  CHECK(napi_create_buffer_copy(env, out_len, out, NULL, &result) == napi_ok);
+
+  goosig_cleanse(out, out_len);
+  free(out);
+
+  return result;
+}
+
+static void
+goosig_rsakey_destroy(napi_env env, void *data, void *hint) {
+  goo_rsakey_destroy((goo_rsakey_t *)data);
+}
+
+static napi_value
+goosig_rsakey_create(napi_env env, napi_callback_info info) {
+  napi_value argv[3];
+  size_t argc = 3;
+  const uint8_t *p, *q, *e;
+  size_t p_len, q_len, e_len;
+  goo_rsakey_t *key;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 3);
+  CHECK(napi_get_buffer_info(env, argv[0], (void **)&p, &p_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&q, &q_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&e, &e_len) == napi_ok);
+
+  key = goo_rsakey_create(p, p_len, q, q_len, e, e_len);
+
+  JS_ASSERT(key != NULL, JS_ERR_KEY);
+
+  CHECK(napi_create_external(env,
+                             key,
+                             goosig_rsakey_destroy,
+                             NULL,
+                             &result) == napi_ok);
+
+  return result;
+}
+
+static napi_value
+goosig_rsakey_decrypt(napi_env env, napi_callback_info info) {
+  napi_value argv[3];
+  size_t argc = 3;
+  uint8_t *out;
+  size_t out_len;
+  const uint8_t *ct, *entropy;
+  size_t ct_len, entropy_len;
+  goo_rsakey_t *key;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 3);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&key) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&ct, &ct_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[2], (void **)&entropy,
+                             &entropy_len) == napi_ok);
+
+  JS_ASSERT(entropy_len == 32, JS_ERR_ENTROPY_SIZE);
+
+  JS_ASSERT(goo_rsakey_decrypt(NULL, &out, &out_len, key, ct, ct_len,
+                               NULL, 0, entropy),
+            JS_ERR_DECRYPT);
+
+  CHECK(napi_create_buffer_copy(env, out_len, out, NULL, &result) == napi_ok);
+
+  goosig_cleanse(out, out_len);
+  free(out);
+
+  return result;
+}
+
+/*
+ * Scanning
+ */
+
+typedef struct goosig_match_s {
+  size_t index;
+  uint8_t msg[GOO_CIPHERTEXT_SIZE];
+} goosig_match_t;
+
+typedef struct goosig_scan_job_s {
+  goo_rsakey_t *key;
+  napi_ref ref;
+  napi_ref callback;
+  napi_async_work work;
+  char *path;
+  size_t msg_len;
+  uint8_t entropy[32];
+  uint32_t threads;
+  const uint8_t *data;
+  size_t size;
+  uv_mutex_t lock;
+  goosig_match_t *matches;
+  size_t count;
+  size_t alloc;
+  const char *error;
+} goosig_scan_job_t;
+
+static void
+goosig_scan_push(goosig_scan_job_t *job, size_t index, const uint8_t *msg) {
+  uv_mutex_lock(&job->lock);
+
+  if (job->count == job->alloc) {
+    job->alloc = job->alloc ? job->alloc * 2 : 4;
+    job->matches = (goosig_match_t *)realloc(job->matches,
+      job->alloc * sizeof(goosig_match_t));
+    CHECK(job->matches != NULL);
+  }
+
+  job->matches[job->count].index = index;
+  memcpy(job->matches[job->count].msg, msg, job->msg_len);
+  job->count += 1;
+
+  uv_mutex_unlock(&job->lock);
+}
+
+static int
+goosig_scan_range(void *arg, goo_ctx_t *ctx, size_t start, size_t end) {
+  goosig_scan_job_t *job = (goosig_scan_job_t *)arg;
+  uint8_t msg[GOO_CIPHERTEXT_SIZE];
+  uint8_t entropy[32];
+  size_t pos = start;
+  size_t index, i;
+
+  while (pos < end) {
+    /* Mix the position into the entropy so */
+    /* no two attempts share a blinding seed. */
+    memcpy(entropy, job->entropy, 32);
+
+    for (i = 0; i < 8; i++)
+      entropy[31 - i] ^= (uint8_t)((uint64_t)pos >> (i * 8));
+
+    if (!goo_rsakey_scan(ctx, &index, msg, job->key,
+                         job->data + pos * GOO_CIPHERTEXT_SIZE,
+                         end - pos, job->msg_len, entropy)) {
+      break;
+    }
+
+    goosig_scan_push(job, pos + index, msg);
+
+    pos += index + 1;
+  }
+
+  goosig_cleanse(msg, sizeof(msg));
+  goosig_cleanse(entropy, sizeof(entropy));
+
+  return 1;
+}
+
+static int
+goosig_scan_map(goosig_scan_job_t *job) {
+#ifndef _WIN32
+  struct stat st;
+  void *data;
+  int fd;
+
+  fd = open(job->path, O_RDONLY);
+
+  if (fd < 0)
+    return 0;
+
+  if (fstat(fd, &st) != 0 || st.st_size < 0) {
+    close(fd);
+    return 0;
+  }
+
+  job->size = (size_t)st.st_size;
+
+  if (job->size == 0) {
+    close(fd);
+    job->data = NULL;
+    return 1;
+  }
+
+  data = mmap(NULL, job->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  close(fd);
+
+  if (data == MAP_FAILED)
+    return 0;
+
+#ifdef MADV_SEQUENTIAL
+  madvise(data, job->size, MADV_SEQUENTIAL);
+#endif
+
+  job->data = (const uint8_t *)data;
+
+  return 1;
+#else
+  uint8_t *data;
+  FILE *fp;
+  long size;
+
+  fp = fopen(job->path, "rb");
+
+  if (fp == NULL)
+    return 0;
+
+  if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0) {
+    fclose(fp);
+    return 0;
+  }
+
+  rewind(fp);
+
+  data = (uint8_t *)malloc((size_t)size + 1);
+
+  CHECK(data != NULL);
+
+  if (fread(data, 1, (size_t)size, fp) != (size_t)size) {
+    fclose(fp);
+    free(data);
+    return 0;
+  }
+
+  fclose(fp);
+
+  job->data = data;
+  job->size = (size_t)size;
+
+  return 1;
+#endif
+}
+
+static void
+goosig_scan_unmap(goosig_scan_job_t *job) {
+  if (job->data == NULL)
+    return;
+
+#ifndef _WIN32
+  munmap((void *)job->data, job->size);
+#else
+  free((void *)job->data);
+#endif
+
+  job->data = NULL;
+}
+
+static int
+goosig_match_cmp(const void *a, const void *b) {
+  const goosig_match_t *x = (const goosig_match_t *)a;
+  const goosig_match_t *y = (const goosig_match_t *)b;
+
+  return (x->index > y->index) - (x->index < y->index);
+}
+
+static void
+goosig_scan_execute(napi_env env, void *data) {
+  goosig_scan_job_t *job = (goosig_scan_job_t *)data;
+
+  if (!goosig_scan_map(job)) {
+    job->error = JS_ERR_FILE;
+    return;
+  }
+
+  if (job->size % GOO_CIPHERTEXT_SIZE != 0) {
+    job->error = JS_ERR_FILE;
+  } else {
+    goosig_parallel(NULL, job->size / GOO_CIPHERTEXT_SIZE, job->threads,
+                    goosig_scan_range, job);
+
+    if (job->count > 1) {
+      qsort(job->matches, job->count, sizeof(goosig_match_t),
+            goosig_match_cmp);
+    }
+  }
+
+  goosig_scan_unmap(job);
+}
+
+static void
+goosig_scan_complete(napi_env env, napi_status status, void *data) {
+  goosig_scan_job_t *job = (goosig_scan_job_t *)data;
+  napi_value argv[2];
+  napi_value callback, global, msg, item, val;
+  size_t i;
+
+  if (status != napi_ok && job->error == NULL)
+    job->error = JS_ERR_FILE;
+
+  if (job->error == NULL) {
+    CHECK(napi_get_null(env, &argv[0]) == napi_ok);
+    CHECK(napi_create_array_with_length(env, job->count,
+                                        &argv[1]) == napi_ok);
+
+    for (i = 0; i < job->count; i++) {
+      CHECK(napi_create_object(env, &item) == napi_ok);
+
+      goosig_set_number(env, item, "index", (double)job->matches[i].index);
+
+      CHECK(napi_create_buffer_copy(env, job->msg_len,
+                                    job->matches[i].msg,
+                                    NULL, &val) == napi_ok);
+      CHECK(napi_set_named_property(env, item, "msg", val) == napi_ok);
+      CHECK(napi_set_element(env, argv[1], i, item) == napi_ok);
+    }
+  } else {
+    CHECK(napi_create_string_utf8(env, job->error,
+                                  NAPI_AUTO_LENGTH, &msg) == napi_ok);
+    CHECK(napi_create_error(env, NULL, msg, &argv[0]) == napi_ok);
+    CHECK(napi_get_undefined(env, &argv[1]) == napi_ok);
+  }
+
+  CHECK(napi_get_reference_value(env, job->callback, &callback) == napi_ok);
+  CHECK(napi_get_global(env, &global) == napi_ok);
+
+  CHECK(napi_delete_async_work(env, job->work) == napi_ok);
+  CHECK(napi_delete_reference(env, job->callback) == napi_ok);
+  CHECK(napi_delete_reference(env, job->ref) == napi_ok);
+
+  if (job->matches != NULL)
+    goosig_cleanse(job->matches, job->alloc * sizeof(goosig_match_t));
+
+  goosig_cleanse(job->entropy, sizeof(job->entropy));
+
+  uv_mutex_destroy(&job->lock);
+
+  free(job->matches);
+  free(job->path);
+  free(job);
+
+  CHECK(napi_call_function(env, global, callback, 2, argv, NULL) == napi_ok);
+}
+
+static napi_value
+goosig_rsakey_scan(napi_env env, napi_callback_info info) {
+  napi_value argv[6];
+  size_t argc = 6;
+  const uint8_t *entropy;
+  size_t path_len, entropy_len;
+  uint32_t msg_len, threads;
+  goosig_scan_job_t *job;
+  goo_rsakey_t *key;
+  napi_value name;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 6);
+  CHECK(napi_get_value_external(env, argv[0], (void **)&key) == napi_ok);
+  CHECK(napi_get_value_string_utf8(env, argv[1], NULL, 0,
+                                   &path_len) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[2], &msg_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[3], (void **)&entropy,
+                             &entropy_len) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[4], &threads) == napi_ok);
+
+  JS_ASSERT(msg_len <= GOO_CIPHERTEXT_SIZE, JS_ERR_DECRYPT);
+  JS_ASSERT(entropy_len == 32, JS_ERR_ENTROPY_SIZE);
+
+  job = (goosig_scan_job_t *)calloc(1, sizeof(goosig_scan_job_t));
+
+  CHECK(job != NULL);
+
+  job->key = key;
+  job->msg_len = msg_len;
+  job->threads = threads;
+  job->path = (char *)malloc(path_len + 1);
+
+  CHECK(job->path != NULL);
+  CHECK(napi_get_value_string_utf8(env, argv[1], job->path, path_len + 1,
+                                   &path_len) == napi_ok);
+  CHECK(uv_mutex_init(&job->lock) == 0);
+
+  memcpy(job->entropy, entropy, 32);
+
+  /* Keep the key alive until we complete. */
+  CHECK(napi_create_reference(env, argv[0], 1, &job->ref) == napi_ok);
+  CHECK(napi_create_reference(env, argv[5], 1, &job->callback) == napi_ok);
+
+  CHECK(napi_create_string_latin1(env, "goosig_rsakey_scan",
+                                  NAPI_AUTO_LENGTH, &name) == napi_ok);
+
+  CHECK(napi_create_async_work(env,
+                               NULL,
+                               name,
+                               goosig_scan_execute,
+                               goosig_scan_complete,
+                               job,
+                               &job->work) == napi_ok);
+
+  CHECK(napi_queue_async_work(env, job->work) == napi_ok);
+
+  return NULL;
+}
+
+typedef struct goosig_encrypt_job_s {
+  napi_ref out_ref;
+  napi_ref callback;
+  napi_async_work work;
+  uint8_t *out;
+  uint8_t *msgs;
+  size_t msg_len;
+  uint8_t *entropy;
+  uint8_t *data;
+  const uint8_t **ns;
+  size_t *n_lens;
+  const uint8_t **es;
+  size_t *e_lens;
+  size_t len;
+  uint32_t threads;
+  int ok;
+} goosig_encrypt_job_t;
+
+static int
+goosig_encrypt_range(void *arg, goo_ctx_t *ctx, size_t start, size_t end) {
+  goosig_encrypt_job_t *job = (goosig_encrypt_job_t *)arg;
+
+  return goo_encrypt_batch(ctx,
+                           job->out + start * GOO_CIPHERTEXT_SIZE,
+                           job->msgs + start * job->msg_len,
+                           job->msg_len,
+                           job->ns + start,
+                           job->n_lens + start,
+                           job->es + start,
+                           job->e_lens + start,
+                           job->entropy + start * 32,
+                           end - start);
+}
+
+static void
+goosig_encrypt_execute(napi_env env, void *data) {
+  goosig_encrypt_job_t *job = (goosig_encrypt_job_t *)data;
+
+  job->ok = goosig_parallel(NULL, job->len, job->threads,
+                            goosig_encrypt_range, job);
+}
+
+static void
+goosig_encrypt_complete(napi_env env, napi_status status, void *data) {
+  goosig_encrypt_job_t *job = (goosig_encrypt_job_t *)data;
+  napi_value argv[1];
+  napi_value callback, global, msg;
+
+  if (status != napi_ok)
+    job->ok = 0;
+
+  if (job->ok) {
+    CHECK(napi_get_null(env, &argv[0]) == napi_ok);
+  } else {
+    CHECK(napi_create_string_utf8(env, JS_ERR_ENCRYPT,
+                                  NAPI_AUTO_LENGTH, &msg) == napi_ok);
+    CHECK(napi_create_error(env, NULL, msg, &argv[0]) == napi_ok);
+  }
+
+  CHECK(napi_get_reference_value(env, job->callback, &callback) == napi_ok);
+  CHECK(napi_get_global(env, &global) == napi_ok);
+
+  CHECK(napi_delete_async_work(env, job->work) == napi_ok);
+  CHECK(napi_delete_reference(env, job->callback) == napi_ok);
+  CHECK(napi_delete_reference(env, job->out_ref) == napi_ok);
+
+  goosig_cleanse(job->msgs, job->len * job->msg_len);
+  goosig_cleanse(job->entropy, job->len * 32);
+
+  free(job->msgs);
+  free(job->entropy);
+  free(job->data);
+  free(job->ns);
+  free(job->n_lens);
+  free(job->es);
+  free(job->e_lens);
+  free(job);
+
+  CHECK(napi_call_function(env, global, callback, 1, argv, NULL) == napi_ok);
+}
+
+static napi_value
+goosig_encrypt_batch(napi_env env, napi_callback_info info) {
+  napi_value argv[8];
+  size_t argc = 8;
+  uint8_t *out;
+  const uint8_t *msgs, *entropy, *buf;
+  size_t out_len, msgs_len, entropy_len, buf_len;
+  size_t total = 0;
+  uint32_t msg_len, threads, len, i, j;
+  goosig_encrypt_job_t *job;
+  napi_value item, name;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 8);
+  CHECK(napi_get_buffer_info(env, argv[0], (void **)&out,
+                             &out_len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[1], (void **)&msgs,
+                             &msgs_len) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[2], &msg_len) == napi_ok);
+  CHECK(napi_get_array_length(env, argv[3], &len) == napi_ok);
+  CHECK(napi_get_buffer_info(env, argv[5], (void **)&entropy,
+                             &entropy_len) == napi_ok);
+  CHECK(napi_get_value_uint32(env, argv[6], &threads) == napi_ok);
+
+  JS_ASSERT(out_len == (size_t)len * GOO_CIPHERTEXT_SIZE, JS_ERR_OUTPUT_SIZE);
+  JS_ASSERT(msgs_len == (size_t)len * msg_len, JS_ERR_ENCRYPT);
+  JS_ASSERT(entropy_len == (size_t)len * 32, JS_ERR_ENTROPY_SIZE);
+
+  job = (goosig_encrypt_job_t *)calloc(1, sizeof(goosig_encrypt_job_t));
+
+  CHECK(job != NULL);
+
+  job->out = out;
+  job->msg_len = msg_len;
+  job->len = len;
+  job->threads = threads;
+  job->msgs = (uint8_t *)malloc(msgs_len + 1);
+  job->entropy = (uint8_t *)malloc(entropy_len + 1);
+  job->ns = (const uint8_t **)malloc((len + 1) * sizeof(uint8_t *));
+  job->n_lens = (size_t *)malloc((len + 1) * sizeof(size_t));
+  job->es = (const uint8_t **)malloc((len + 1) * sizeof(uint8_t *));
+  job->e_lens = (size_t *)malloc((len + 1) * sizeof(size_t));
+
+  CHECK(job->msgs != NULL);
+  CHECK(job->entropy != NULL);
+  CHECK(job->ns != NULL);
+  CHECK(job->n_lens != NULL);
+  CHECK(job->es != NULL);
+  CHECK(job->e_lens != NULL);
+
+  memcpy(job->msgs, msgs, msgs_len);
+  memcpy(job->entropy, entropy, entropy_len);
+
+  /* Copy the keys into one allocation: the */
+  /* arrays may be modified while we run. */
+  for (j = 3; j <= 4; j++) {
+    for (i = 0; i < len; i++) {
+      CHECK(napi_get_element(env, argv[j], i, &item) == napi_ok);
+      CHECK(napi_get_buffer_info(env, item, (void **)&buf,
+                                 &buf_len) == napi_ok);
+      total += buf_len;
+    }
+  }
+
+  job->data = (uint8_t *)malloc(total + 1);
+
+  CHECK(job->data != NULL);
+
+  total = 0;
+
+  for (j = 3; j <= 4; j++) {
+    const uint8_t **ptrs = j == 3 ? job->ns : job->es;
+    size_t *lens = j == 3 ? job->n_lens : job->e_lens;
+
+    for (i = 0; i < len; i++) {
+      CHECK(napi_get_element(env, argv[j], i, &item) == napi_ok);
+      CHECK(napi_get_buffer_info(env, item, (void **)&buf,
+                                 &buf_len) == napi_ok);
+      memcpy(job->data + total, buf, buf_len);
+      ptrs[i] = job->data + total;
+      lens[i] = buf_len;
+      total += buf_len;
+    }
+  }
+
+  /* Keep the output buffer alive until we complete. */
+  CHECK(napi_create_reference(env, argv[0], 1, &job->out_ref) == napi_ok);
+  CHECK(napi_create_reference(env, argv[7], 1, &job->callback) == napi_ok);
+
+  CHECK(napi_create_string_latin1(env, "goosig_encrypt_batch",
+                                  NAPI_AUTO_LENGTH, &name) == napi_ok);
+
+  CHECK(napi_create_async_work(env,
+                               NULL,
+                               name,
+                               goosig_encrypt_execute,
+                               goosig_encrypt_complete,
+                               job,
+                               &job->work) == napi_ok);
+
+  CHECK(napi_queue_async_work(env, job->work) == napi_ok);
+
+  return NULL;
+}
+
+static napi_value
+goosig_histogram(napi_env env, napi_callback_info info) {
+  napi_value argv[2];
+  size_t argc = 2;
+  goosig_hist_t *hist;
+  uint32_t op;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 2);
+  CHECK(napi_get_value_uint32(env, argv[1], &op) == napi_ok);
+
+  hist = goosig_get_hist(env, argv[0], op);
+
+  JS_ASSERT(hist != NULL, JS_ERR_OP);
+
+  return goosig_hist_export(env, hist);
+}
+
+static napi_value
+goosig_histogram_reset(napi_env env, napi_callback_info info) {
+  napi_value argv[2];
+  size_t argc = 2;
+  goosig_hist_t *hist;
+  uint32_t op;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 2);
+  CHECK(napi_get_value_uint32(env, argv[1], &op) == napi_ok);
+
+  hist = goosig_get_hist(env, argv[0], op);
+
+  JS_ASSERT(hist != NULL, JS_ERR_OP);
+
+  goosig_hist_reset(hist);
+
+  return NULL;
+}
+
+/*
+ * Peer Credentials
+ */
+
+static napi_value
+goosig_peer_uid(napi_env env, napi_callback_info info) {
+  /* Effective uid of the process at the other end of a unix */
+  /* socket, or -1 where the platform cannot tell us. */
+  napi_value argv[1];
+  size_t argc = 1;
+  int32_t fd;
+  int64_t uid = -1;
+  napi_value result;
+
+  CHECK(napi_get_cb_info(env, info, &argc, argv, NULL, NULL) == napi_ok);
+  CHECK(argc == 1);
+  CHECK(napi_get_value_int32(env, argv[0], &fd) == napi_ok);
+
+#if defined(__linux__) && defined(SO_PEERCRED)
+  {
+    struct ucred cred;
+    socklen_t len = sizeof(cred);
+
+    if (fd >= 0 && getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0)
+      uid = cred.uid;
+  }
+#elif defined(__APPLE__) || defined(__FreeBSD__) \
+   || defined(__OpenBSD__) || defined(__NetBSD__)
+  {
+    uid_t euid;
+    gid_t egid;
+
+    if (fd >= 0 && getpeereid(fd, &euid, &egid) == 0)
+      uid = euid;
+  }
+#else
+  (void)fd;
+#endif
+
+  CHECK(napi_create_int64(env, uid, &result) == napi_ok);
+
+  return result;
+}
+
+/*
+ * Module
+ */
+
+napi_value
+goosig_init(napi_env env, napi_value exports) {
+  size_t i;
+
+  static struct {
+    const char *name;
+    napi_callback callback;
+  } funcs[] = {
+    { "goosig_create", goosig_create },
+    { "goosig_generate", goosig_generate },
+    { "goosig_challenge", goosig_challenge },
+    { "goosig_challenge_batch", goosig_challenge_batch },
+    { "goosig_derive_sprime", goosig_derive_sprime },
+    { "goosig_validate", goosig_validate },
+    { "goosig_sign", goosig_sign },
+    { "goosig_signer_create", goosig_signer_create },
+    { "goosig_signer_sign", goosig_signer_sign },
+    { "goosig_presign", goosig_presign },
+    { "goosig_presign_async", goosig_presign_async },
+    { "goosig_sign_with_presig", goosig_sign_with_presig },
+    { "goosig_verify", goosig_verify },
+    { "goosig_pool_create", goosig_pool_create },
+    { "goosig_pool_verify", goosig_pool_verify },
+    { "goosig_pool_close", goosig_pool_close },
+    { "goosig_encrypt", goosig_encrypt },
+    { "goosig_decrypt", goosig_decrypt },
+    { "goosig_rsakey_create", goosig_rsakey_create },
+    { "goosig_rsakey_decrypt", goosig_rsakey_decrypt },
+    { "goosig_rsakey_scan", goosig_rsakey_scan },
+    { "goosig_encrypt_batch", goosig_encrypt_batch },
+    { "goosig_registry", goosig_registry_stats },
+    { "goosig_backend", goosig_backend },
+    { "goosig_histogram", goosig_histogram },
+    { "goosig_histogram_reset", goosig_histogram_reset },
+    { "goosig_peer_uid", goosig_peer_uid }
+  };
+
+  uv_once(&goosig_backend_once, goosig_backend_init);
+  uv_once(&goosig_hists_once, goosig_hists_init);
+  uv_once(&goosig_registry_once, goosig_registry_init);
 
   for (i = 0; i < sizeof(funcs) / sizeof(funcs[0]); i++) {
     const char *name = funcs[i].name;
@@ -0,0 +1,275 @@
+/* eslint-env mocha */
+/* eslint prefer-arrow-callback: 'off' */
+/* eslint camelcase: "off" */
+
+'use strict';
+
+const assert = require('bsert');
+const fs = require('fs');
+const net = require('net');
+const os = require('os');
+const path = require('path');
+const SHA256 = require('bcrypto/lib/sha256');
+const Goo = require('../');
+const verify = require('./data/verify.json');
+
+const MAGIC = 0x474f4f56;
+
+const items = verify.map((vector) => {
+  return vector.slice(0, 3).map(x => Buffer.from(x, 'hex'));
+});
+
+const expect = verify.map(vector => vector[3]);
+
+/*
+ * A goosigd stand-in speaking the same framing (see src/bin/goosigd.c).
+ */
+
+class Server {
+  constructor(file, n, g, h) {
+    this.file = file;
+    this.id = groupId(n, g, h);
+    this.goo = new Goo(n, g, h);
+    this.frames = [];
+    this.server = net.createServer(socket => this._handle(socket));
+  }
+
+  open() {
+    return new Promise((resolve, reject) => {
+      this.server.once('error', reject);
+      this.server.listen(this.file, () => {
+        // As goosigd does.
+        fs.chmodSync(this.file, 0o600);
+        resolve();
+      });
+    });
+  }
+
+  close() {
+    return new Promise(resolve => this.server.close(resolve));
+  }
+
+  _handle(socket) {
+    let buffer = Buffer.alloc(0);
+
+    socket.on('error', () => socket.destroy());
+
+    socket.on('data', (data) => {
+      const out = [];
+
+      buffer = Buffer.concat([buffer, data]);
+
+      while (buffer.length >= 8) {
+        assert.strictEqual(buffer.readUInt32BE(0), MAGIC);
+
+        const size = buffer.readUInt32BE(4);
+
+        if (buffer.length < 8 + size)
+          break;
+
+        out.push(this._answer(buffer.slice(8, 8 + size)));
+
+        buffer = buffer.slice(8 + size);
+      }
+
+      // Answer a byte at a time (and several frames
+      // at once) to exercise the client's reassembly.
+      for (const ch of Buffer.concat(out))
+        socket.write(Buffer.from([ch]));
+    });
+  }
+
+  _answer(body) {
+    const id = body.slice(0, 32);
+    const count = body.readUInt32BE(32);
+    const batch = [];
+
+    let pos = 36;
+
+    for (let i = 0; i < count; i++) {
+      const item = [];
+
+      for (let j = 0; j < 3; j++) {
+        const len = body.readUInt32BE(pos);
+
+        pos += 4;
+        item.push(body.slice(pos, pos + len));
+        pos += len;
+      }
+
+      batch.push(item);
+    }
+
+    assert.strictEqual(pos, body.length);
+
+    this.frames.push(batch);
+
+    const head = Buffer.alloc(12);
+
+    head.writeUInt32BE(MAGIC, 0);
+
+    if (!id.equals(this.id)) {
+      head.writeUInt32BE(1, 4);
+      head.writeUInt32BE(0, 8);
+      return head;
+    }
+
+    head.writeUInt32BE(0, 4);
+    head.writeUInt32BE(count, 8);
+
+    const results = batch.map(([msg, sig, C1]) => {
+      return this.goo.verify(msg, sig, C1) ? 1 : 0;
+    });
+
+    return Buffer.concat([head, Buffer.from(results)]);
+  }
+}
+
+function groupId(n, g, h) {
+  let i = 0;
+
+  while (i < n.length && n[i] === 0x00)
+    i += 1;
+
+  const head = Buffer.alloc(8);
+
+  head.writeUInt32BE(g, 0);
+  head.writeUInt32BE(h, 4);
+
+  return SHA256.multi(head, n.slice(i));
+}
+
+function noLocal(client) {
+  client.local.verify = () => {
+    throw new Error('Verified locally.');
+  };
+}
+
+describe('Client', function() {
+  this.timeout(30000);
+
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'goosigd-'));
+  const file = path.join(dir, 'goosigd.sock');
+
+  let server = null;
+
+  before(async () => {
+    server = new Server(file, Goo.RSA2048, 2, 3);
+
+    await server.open();
+  });
+
+  after(async () => {
+    await server.close();
+
+    if (fs.existsSync(file))
+      fs.unlinkSync(file);
+
+    fs.rmdirSync(dir);
+  });
+
+  beforeEach(() => {
+    server.frames.length = 0;
+  });
+
+  it('should fall back to local verification', async () => {
+    const client = new Goo.Client({
+      n: Goo.RSA2048,
+      path: path.join(dir, 'missing.sock')
+    });
+
+    const results = await client.verifyBatch(items);
+
+    assert.strictEqual(client.fallback, true);
+    assert.deepStrictEqual(results, expect);
+    assert.strictEqual(await client.verify(...items[0]), verify[0][3]);
+
+    client.close();
+  });
+
+  it('should verify a mixed batch over the socket', async () => {
+    const client = new Goo.Client({ n: Goo.RSA2048, path: file });
+
+    noLocal(client);
+
+    assert(expect.includes(true) && expect.includes(false));
+    assert.deepStrictEqual(await client.verifyBatch(items), expect);
+    assert.strictEqual(client.connected, true);
+    assert.strictEqual(client.fallback, false);
+
+    assert.strictEqual(server.frames.length, 1);
+    assert.strictEqual(server.frames[0].length, items.length);
+
+    for (const [i, item] of server.frames[0].entries()) {
+      for (let j = 0; j < 3; j++)
+        assert.bufferEqual(item[j], items[i][j]);
+    }
+
+    client.close();
+  });
+
+  it('should answer pipelined batches in order', async () => {
+    const client = new Goo.Client({ n: Goo.RSA2048, path: file });
+
+    noLocal(client);
+
+    const reversed = items.slice().reverse();
+
+    const results = await Promise.all([
+      client.verifyBatch(items),
+      client.verifyBatch([]),
+      client.verifyBatch(reversed),
+      client.verify(...items[0])
+    ]);
+
+    assert.deepStrictEqual(results, [
+      expect,
+      [],
+      expect.slice().reverse(),
+      expect[0]
+    ]);
+
+    assert.strictEqual(client.fallback, false);
+    assert.strictEqual(client.pending.length, 0);
+    assert.deepStrictEqual(server.frames.map(f => f.length),
+                           [items.length, 0, items.length, 1]);
+
+    client.close();
+  });
+
+  it('should not trust a socket others can use', async () => {
+    const client = new Goo.Client({ n: Goo.RSA2048, path: file });
+
+    fs.chmodSync(file, 0o666);
+
+    try {
+      assert.deepStrictEqual(await client.verifyBatch(items), expect);
+    } finally {
+      fs.chmodSync(file, 0o600);
+    }
+
+    assert.strictEqual(client.connected, false);
+    assert.strictEqual(client.fallback, true);
+    assert.strictEqual(server.frames.length, 0);
+
+    client.close();
+  });
+
+  it('should fall back on a wrong group', async () => {
+    const client = new Goo.Client({ n: Goo.RSA2048, g: 5, path: file });
+    const results = await client.verifyBatch(items.slice(0, 2));
+
+    // The daemon rejected the group and the batch was redone locally.
+    assert.strictEqual(server.frames.length, 1);
+    assert.strictEqual(client.connected, false);
+    assert.strictEqual(client.fallback, true);
+    assert.strictEqual(results.length, 2);
+
+    // Later calls no longer touch the socket.
+    await client.verifyBatch(items.slice(0, 2));
+
+    assert.strictEqual(server.frames.length, 1);
+
+    client.close();
+  });
+});
@@ -5,10 +5,14 @@
 'use strict';
 
 const assert = require('bsert');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
 const rng = require('bcrypto/lib/random');
 const rsa = require('bcrypto/lib/rsa');
 const util = require('./util');
 const Goo = require('../');
+const JSGoo = require('../lib/js/goo');
 const verify = require('./data/verify.json');
 const sign = require('./data/sign.json');
 
@@ -168,4 +172,277 @@ describe('Goo', function() {
       });
     }
   });
+
+  describe('Batch Challenge', () => {
+    const goo = new Goo(Goo.RSA2048, 2, 3, 4096);
+    const keys = sign.slice(0, 4).map((item) => {
+      return rsa.publicKeyCreate(Buffer.from(item[0], 'hex'));
+    });
+
+    it('should derive s_primes', () => {
+      const seed = Buffer.alloc(32, 0x00);
+      const expect = ''
+        + 'cd7f03703089f0bcde68cd203e2a63f8'
+        + '72f37bae6d44ec36165da67db31a3bff';
+
+      assert.strictEqual(goo.deriveSprime(seed, 1).toString('hex'), expect);
+    });
+
+    it('should match goo.challenge with a seed', async () => {
+      const seed = rng.randomBytes(32);
+      const s_primes = Buffer.alloc(keys.length * 32);
+      const out = await goo.challengeBatch(keys, {
+        seed,
+        offset: 5,
+        s_primes,
+        threads: 3
+      });
+
+      assert.strictEqual(out.length, keys.length * goo.size);
+
+      for (const [i, key] of keys.entries()) {
+        const s_prime = goo.deriveSprime(seed, 5 + i);
+        const C1 = goo.challenge(s_prime, key);
+
+        assert.bufferEqual(s_primes.slice(i * 32, i * 32 + 32), s_prime);
+        assert.bufferEqual(out.slice(i * goo.size, (i + 1) * goo.size), C1);
+      }
+    });
+
+    it('should match goo.challenge with s_primes', async () => {
+      const s_primes = rng.randomBytes(keys.length * 32);
+      const out = await goo.challengeBatch(keys, { s_primes });
+
+      for (const [i, key] of keys.entries()) {
+        const s_prime = s_primes.slice(i * 32, i * 32 + 32);
+        const C1 = goo.challenge(s_prime, key);
+
+        assert.bufferEqual(out.slice(i * goo.size, (i + 1) * goo.size), C1);
+      }
+    });
+  });
+
+  describe('Batch Encrypt', () => {
+    it('should encrypt to many keys', async () => {
+      const items = sign.slice(0, 3);
+      const keys = items.map(item => Buffer.from(item[0], 'hex'));
+      const pubs = keys.map(key => rsa.publicKeyCreate(key));
+      const msgs = keys.map(() => rng.randomBytes(32));
+      const out = await Goo.encryptBatch(msgs, pubs, { threads: 2 });
+      const size = out.length / keys.length;
+
+      assert.strictEqual(size, 513);
+
+      for (const [i, key] of keys.entries()) {
+        const ct = out.slice(i * size, (i + 1) * size);
+        assert.bufferEqual(Goo.decrypt(ct, key), msgs[i]);
+      }
+    });
+
+    it('should decrypt with a prepared key', () => {
+      const key = Buffer.from(sign[0][0], 'hex');
+      const pub = rsa.publicKeyCreate(key);
+      const decryptor = Goo.decryptor(key);
+
+      for (let i = 0; i < 3; i++) {
+        const msg = rng.randomBytes(32);
+        const ct = Goo.encrypt(msg, pub);
+
+        assert.bufferEqual(decryptor.decrypt(ct), msg);
+
+        ct[ct.length - 1] ^= 1;
+
+        assert.throws(() => decryptor.decrypt(ct));
+      }
+    });
+
+    it('should scan a ciphertext file', async () => {
+      const keys = sign.slice(0, 3).map(item => Buffer.from(item[0], 'hex'));
+      const pubs = keys.map(key => rsa.publicKeyCreate(key));
+      const owners = [1, 0, 2, 1, 1, 0];
+      const msgs = owners.map(() => rng.randomBytes(32));
+      const cts = await Goo.encryptBatch(msgs, owners.map(i => pubs[i]));
+      const file = path.join(os.tmpdir(), `goosig-${process.pid}.bin`);
+
+      fs.writeFileSync(file, cts);
+
+      try {
+        const matches = await Goo.decryptor(keys[1]).scan(file);
+
+        assert.deepStrictEqual(matches.map(m => m.index), [0, 3, 4]);
+
+        for (const {index, msg} of matches)
+          assert.bufferEqual(msg, msgs[index]);
+      } finally {
+        fs.unlinkSync(file);
+      }
+    });
+  });
+
+  describe('Signer', () => {
+    if (Goo.native !== 2)
+      return;
+
+    const goo = new Goo(Goo.RSA2048, 2, 3, 4096);
+
+    for (const [i, item] of sign.slice(0, 3).entries()) {
+      it(`should match goo.sign for vector #${i + 1}`, () => {
+        const key = Buffer.from(item[0], 'hex');
+        const msg = Buffer.from(item[1], 'hex');
+        const s_prime = Buffer.from(item[2], 'hex');
+        const sig = Buffer.from(item[5], 'hex');
+        const signer = goo.signer(s_prime, key);
+
+        assert.bufferEqual(signer.sign(msg), sig);
+        assert.bufferEqual(signer.sign(msg), sig);
+      });
+    }
+  });
+
+  describe('Presign', () => {
+    if (Goo.native !== 2)
+      return;
+
+    const goo = new Goo(Goo.RSA2048, 2, 3, 4096);
+    const ver = new Goo(Goo.RSA2048, 2, 3);
+    const key = Buffer.from(sign[0][0], 'hex');
+    const s_prime = Buffer.from(sign[0][2], 'hex');
+    const C1 = Buffer.from(sign[0][3], 'hex');
+
+    it('should sign with a presignature once', () => {
+      const msg = rng.randomBytes(32);
+      const presig = goo.presign(s_prime, key);
+      const sig = goo.signWithPresig(msg, presig);
+
+      assert(presig.used);
+      assert.strictEqual(ver.verify(msg, sig, C1), true);
+      assert.throws(() => goo.signWithPresig(msg, presig));
+    });
+
+    it('should presign in the background', async () => {
+      const pool = goo.presigPool(s_prime, key, 2);
+
+      await pool.open();
+
+      assert.strictEqual(pool.available, 2);
+
+      for (let i = 0; i < 3; i++) {
+        const msg = rng.randomBytes(32);
+        const sig = pool.sign(msg);
+
+        assert.strictEqual(ver.verify(msg, sig, C1), true);
+      }
+
+      pool.close();
+    });
+  });
+
+  describe('Histogram', () => {
+    if (Goo.native !== 2)
+      return;
+
+    it('should record verification latency', () => {
+      const goo = new Goo(Goo.RSA2048, 2, 3);
+      const [msg, sig, C1] = verify[0].slice(0, 3).map((x) => {
+        return Buffer.from(x, 'hex');
+      });
+      const total = Goo.histogram('verify').count;
+
+      for (let i = 0; i < 4; i++)
+        assert.strictEqual(goo.verify(msg, sig, C1), verify[0][3]);
+
+      const hist = goo.histogram('verify');
+
+      assert.strictEqual(hist.count, 4);
+      assert(hist.min > 0);
+      assert(hist.min <= hist.p50);
+      assert(hist.p50 <= hist.p99);
+      assert(hist.p99 <= hist.p999);
+      assert(hist.p999 <= hist.max);
+      assert.strictEqual(goo.histogram('sign').count, 0);
+      assert(Goo.histogram('verify').count >= total + 4);
+
+      goo.resetHistogram('verify');
+
+      assert.strictEqual(goo.histogram('verify').count, 0);
+      assert.strictEqual(goo.histogram().verify.count, 0);
+    });
+
+    it('should report the bignum backend', () => {
+      assert(['gmp', 'mini-gmp'].includes(Goo.backend));
+    });
+
+    it('should share identical groups', () => {
+      const [msg, sig, C1] = verify[0].slice(0, 3).map((x) => {
+        return Buffer.from(x, 'hex');
+      });
+      const a = new Goo(Goo.RSA2048, 2, 3);
+      const b = new Goo(Goo.RSA2048, 2, 3);
+
+      // Contexts are created lazily.
+      assert.strictEqual(a.verify(msg, sig, C1), verify[0][3]);
+
+      const before = Goo.registry();
+
+      assert.strictEqual(b.verify(msg, sig, C1), verify[0][3]);
+
+      const after = Goo.registry();
+
+      assert.strictEqual(after.groups, before.groups);
+      assert.strictEqual(after.references, before.references + 1);
+      assert(after.memory > 0);
+    });
+
+    it('should verify on a worker pool', async () => {
+      const goo = new Goo(Goo.RSA2048, 2, 3);
+      const pool = Goo.verifyPool({ threads: 2, capacity: 4, batch: 4 });
+      const jobs = [];
+
+      for (const [msg, sig, C1, expect] of verify) {
+        const args = [msg, sig, C1].map(x => Buffer.from(x, 'hex'));
+        jobs.push(goo.verifyAsync(...args, pool).then((result) => {
+          assert.strictEqual(result, expect);
+        }));
+      }
+
+      await Promise.all(jobs);
+
+      assert.strictEqual(pool.pending, 0);
+
+      const msg = Buffer.alloc(32);
+      const job = goo.verifyAsync(msg, msg, msg, pool);
+
+      pool.close();
+
+      await assert.rejects(() => job, /Pool is closed/);
+    });
+  });
+
+  describe('Javascript Backend', () => {
+    const goo = new JSGoo(JSGoo.RSA2048, 2, 3, 4096);
+    const ver = new JSGoo(JSGoo.RSA2048, 2, 3);
+    const item = sign[0];
+    const key = Buffer.from(item[0], 'hex');
+    const msg = Buffer.from(item[1], 'hex');
+    const s_prime = Buffer.from(item[2], 'hex');
+    const C1 = Buffer.from(item[3], 'hex');
+    const sig = Buffer.from(item[5], 'hex');
+
+    it('should sign & verify vector #1', () => {
+      assert.bufferEqual(goo.sign(msg, s_prime, key), sig);
+      assert.strictEqual(ver.verify(msg, sig, C1), true);
+
+      msg[0] ^= 1;
+
+      assert.strictEqual(ver.verify(msg, sig, C1), false);
+
+      msg[0] ^= 1;
+    });
+
+    it('should derive s_primes', () => {
+      const seed = rng.randomBytes(32);
+
+      assert.bufferEqual(goo.deriveSprime(seed, 7), Goo.deriveSprime(seed, 7));
+    });
+  });
 });
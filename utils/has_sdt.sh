@@ -0,0 +1,32 @@
+#!/bin/sh
+
+# Static tracepoint (USDT) support checking
+# Copyright (c) 2019, Christopher Jeffrey (MIT License).
+# https://github.com/handshake-org/goosig
+#
+# Tested with shells: bash, dash, busybox
+# Tested with compilers: gcc, clang
+#
+# We try to compile a single probe using
+# systemtap's <sys/sdt.h>. If the header is
+# missing, the probes compile to nothing.
+
+if test x"$CC" = x; then
+  CC='cc'
+fi
+
+code='
+#include <sys/sdt.h>
+int main(void) {
+  DTRACE_PROBE1(goosig, test, 1);
+  return 0;
+}
+'
+
+if echo "$code" | "$CC" -x c -o /dev/null - > /dev/null 2>&1; then
+  echo 'true'
+else
+  echo 'false'
+fi
+
+exit 0